@@ -45,10 +45,9 @@ private:
     MetaJointController* controller;
     double position;
     bool ready;
-    double currGoal;
 
 public:
-    ArmMetaJoint(MetaJointController* controller);
+    ArmMetaJoint(MetaJointController* controller, JointTable& table);
     virtual ~ArmMetaJoint();
 
     bool get(PROPERTY property, double &value);
@@ -54,9 +54,6 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 class BalanceController{
 private:
 
-    typedef Names::Properties Properties;
-    typedef Names::Commands Commands;
-
     std::ofstream logfile;
     enum SupportPhase {LEFT_FOOT, RIGHT_FOOT, BOTH_FEET};
     bool initialized;
@@ -74,18 +71,22 @@ private:
     // The hubo state which has all of the metajoints and sensors
     HuboState* state; 
 
-    // The metajoints for balancing and calculating
-    string balanceComponents[9];
-    // Initialization check
+    // The metajoints and sensors for balancing and calculating. They are looked up once, when the controller is initialized.
+    enum BalanceComponent {BAL_RFX, BAL_RFZ, BAL_RFY, BAL_LFX, BAL_LFY, BAL_LFZ, BAL_RAT, BAL_LAT, BAL_IMU, NUM_BALANCE_COMPONENTS};
+    string balanceComponents[NUM_BALANCE_COMPONENTS];
+    RobotComponent* components[NUM_BALANCE_COMPONENTS];
+    // Initialization check. Also looks up the components.
     bool allComponentsFound();
     // Calculation methods
     // Carried over from Robot Control. Get the property on joint named "name"
     double get(string name, string property);
-    // Carried over from Robot Control. Set the property on the joint named "name" as the value
-    void set(string name, string property, double value);
+    // Get a property of one of the balance components
+    double get(BalanceComponent which, PROPERTY property);
+    // Set a property of one of the balance components
+    void set(BalanceComponent which, PROPERTY property, double value);
     // sets the interpolation offset for a joint. This value is added at each interpolation step, essentially changing the speed of the joint. 
     // It is only used on meta joints not physical joints meaning that the physical joints will never interpolate too fast. This is a good thing
-    void setOffset(string name, double offset);
+    void setOffset(BalanceComponent which, double offset);
     // Tells you if you are standing on the Left foot, Right foot, or Both feet
     void getCurrentSupportPhase();
     // I think it stands for Digital Signal Processing, none the less it generates the offsets for the X, Y, and Z coordinates.
@@ -98,7 +99,7 @@ private:
     // Calculates the ZMP positions. These are then used in the DSP controller to calculate offsets
     void ZMPcalculation();
     // Carried over from Robot Control. Checks to see if the is at it's goal position. If it isn't it requires motion
-    bool requiresMotion(string name);
+    bool requiresMotion(BalanceComponent which);
 public:
     BalanceController();
     virtual ~BalanceController();
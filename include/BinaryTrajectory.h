@@ -0,0 +1,92 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * BinaryTrajectory.h
+ *
+ * The binary trajectory format. A file is a BinaryTrajectoryHeader, then the column
+ * names, each ended by a '\0' and padded with '\0's to a multiple of 8 bytes, then
+ * numFrames rows of numCols values. Values are doubles or floats, as valueSize says.
+ * Everything is in the byte order of the machine that wrote it, which for us is always
+ * little endian.
+ *
+ * The frames start 8 byte aligned, so a mapped file of doubles can be read in place.
+ */
+
+#ifndef BINARYTRAJECTORY_H_
+#define BINARYTRAJECTORY_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#define BINARY_TRAJECTORY_MAGIC "MAESTRAJ"
+#define BINARY_TRAJECTORY_MAGIC_SIZE 8
+#define BINARY_TRAJECTORY_VERSION 1
+
+struct BinaryTrajectoryHeader {
+    char magic[BINARY_TRAJECTORY_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t valueSize;     // sizeof(double) or sizeof(float)
+    uint32_t numCols;
+    uint32_t namesSize;     // Bytes of column names, padding included
+    uint64_t numFrames;
+    double rate;            // Frames per second. 0 if unknown.
+};
+
+bool isBinaryTrajectory(const string &path);
+
+/**
+ * Writes a binary trajectory a frame at a time. The frame count is filled in by close().
+ */
+class BinaryTrajectoryWriter {
+public:
+    BinaryTrajectoryWriter();
+    ~BinaryTrajectoryWriter();
+
+    bool open(const string &path, const vector< string > &columns, int valueSize, double rate);
+    bool write(const double* frame);
+    bool close();
+
+    uint64_t numFrames();
+    const string& getError();
+
+private:
+    bool fail(const string &message);
+
+    FILE* file;
+    string path;
+    BinaryTrajectoryHeader header;
+    vector< float > floats;     // Scratch for writing frames of floats
+    string errorMessage;
+};
+
+#endif /* BINARYTRAJECTORY_H_ */
@@ -41,6 +41,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdint.h>
 #include <sys/types.h>
 #include "Singleton.h"
+#include "JointRegistry.h"
 #include "ach.h"
 #include "hubo.h"
 
@@ -57,12 +58,10 @@ private:
     typedef ach_channel_t AchChannel;
     typedef hubo_board_cmd_t BoardCommand;
 
-    static const char *urdf_joint_names[];
-
     AchChannel huboBoardCommandChannel;
 
 
-    int indexLookup(std::string &joint);
+    int indexLookup(const std::string &joint);
 
 protected:
     CommandChannel();
@@ -72,10 +71,10 @@ public:
 
     ~CommandChannel();
 
-    bool enable(string joint = "all");
-    bool disable(string joint = "all");
-    bool home(string joint = "all");
-    bool reset(string &joint);
+    bool enable(const string &joint = "all");
+    bool disable(const string &joint = "all");
+    bool home(const string &joint = "all");
+    bool reset(const string &joint);
     bool initializeSensors();
 
 };
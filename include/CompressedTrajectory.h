@@ -0,0 +1,161 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * CompressedTrajectory.h
+ *
+ * The compressed trajectory format, for keeping many long recordings on a small disk.
+ * Consecutive frames differ very little, so values are rounded to a multiple of the
+ * file's quantum, and each is stored as its difference from the same column in the
+ * frame before, in as few bytes as that difference needs.
+ *
+ * A file is a CompressedTrajectoryHeader, then the column names as in the binary format,
+ * then the frames in blocks of blockFrames, then the byte offset of each block. The first
+ * frame of a block is stored whole rather than as differences, so a reader can seek to
+ * any block and decode from there.
+ *
+ * Every value is a multiple of the quantum, stored as a zigzag encoded LEB128 varint:
+ * seven bits a byte, low bits first, with the top bit set on every byte but the last.
+ * The header and the block offsets are in the byte order of the machine that wrote them,
+ * which for us is always little endian.
+ */
+
+#ifndef COMPRESSEDTRAJECTORY_H_
+#define COMPRESSEDTRAJECTORY_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "FrameReader.h"
+
+using std::string;
+using std::vector;
+
+#define COMPRESSED_TRAJECTORY_MAGIC "MAESTRJZ"
+#define COMPRESSED_TRAJECTORY_MAGIC_SIZE 8
+#define COMPRESSED_TRAJECTORY_VERSION 1
+#define COMPRESSED_EXTENSION ".trz"         // Write-enabled trajectories with this extension are recorded in this format
+#define COMPRESSED_BLOCK_FRAMES 256         // Frames between seek points
+#define DEFAULT_QUANTUM 1e-6                // Values are stored to within half of this
+
+struct CompressedTrajectoryHeader {
+    char magic[COMPRESSED_TRAJECTORY_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t numCols;
+    uint32_t namesSize;     // Bytes of column names, padding included
+    uint32_t blockFrames;   // Frames in each block. The last block may have fewer.
+    uint64_t numFrames;
+    uint64_t indexOffset;   // Where the block offsets start, one uint64_t per block
+    double rate;            // Frames per second. 0 if unknown.
+    double quantum;         // Every value is a multiple of this
+};
+
+bool isCompressedTrajectory(const string &path);
+
+/**
+ * Writes a compressed trajectory a frame at a time. The frame count and block offsets are
+ * filled in by close().
+ */
+class CompressedTrajectoryWriter {
+public:
+    CompressedTrajectoryWriter();
+    ~CompressedTrajectoryWriter();
+
+    bool open(const string &path, const vector< string > &columns, double rate, double quantum = DEFAULT_QUANTUM);
+    bool write(const double* frame);
+    bool close();
+
+    uint64_t numFrames();
+    const string& getError();
+
+private:
+    bool fail(const string &message);
+
+    FILE* file;
+    string path;
+    CompressedTrajectoryHeader header;
+    uint64_t offset;                // Bytes written so far
+    vector< uint64_t > index;       // Offset of each block
+    vector< int64_t > last;         // The frame before, in quanta
+    vector< unsigned char > bytes;  // Scratch for encoding a frame
+    string errorMessage;
+};
+
+/**
+ * Reads a compressed trajectory a buffer at a time, decoding only the blocks it reaches.
+ * Opening one reads the header, the block offsets and the first and last blocks.
+ */
+class CompressedTrajectoryReader : public FrameReader {
+public:
+    CompressedTrajectoryReader(const string &path, int bufferSize);
+    ~CompressedTrajectoryReader();
+
+    bool loadBuffer();
+    void reset();
+    bool seek(int frame);
+    double rate();
+
+    Buffer& buffer();
+    HeaderMap& header();
+    Header& orderedHeader();
+    Frame& start();
+    Frame& end();
+    int numLines();
+    int numCols();
+
+    bool errored();
+    string getError();
+
+private:
+    bool fail(const string &message);
+    bool readBlock(int64_t block);
+    bool decode(Frame &values);
+
+    FILE* file;
+    string path;
+    CompressedTrajectoryHeader info;
+    vector< uint64_t > index;
+    vector< unsigned char > bytes;  // The block being decoded
+    size_t used;                    // Bytes of it decoded so far
+    vector< int64_t > last;         // The frame decoded last, in quanta
+    int64_t frame;                  // The next frame to decode
+    double steps;                   // Quanta in 1, when that is a whole number. Otherwise 0.
+
+    int _bufferSize;
+    Buffer _buffer;
+    HeaderMap _header;
+    Header _orderedHeader;
+    Frame _start;
+    Frame _end;
+
+    bool _error;
+    string errorMessage;
+};
+
+#endif /* COMPRESSEDTRAJECTORY_H_ */
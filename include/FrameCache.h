@@ -0,0 +1,118 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * FrameCache.h
+ *
+ * Parsed trajectory files, kept between loads. Scripts load the same files over and
+ * over, so a file that has not changed since it was last parsed is handed out again
+ * instead of being read. Files are known by their path, and by the device, inode, size
+ * and modification time stat() gives for it, so an edited file is always parsed again.
+ *
+ * The cache only holds references to the parsed data. Once it is over its limit it drops
+ * the least recently loaded files, but a file stays in memory for as long as a
+ * trajectory is still playing it.
+ */
+
+#ifndef FRAMECACHE_H_
+#define FRAMECACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <string>
+#include <boost/thread.hpp>
+
+#include "PreloadedSource.h"
+
+using std::list;
+using std::map;
+using std::string;
+
+#define DEFAULT_CACHE_LIMIT (128 * 1024 * 1024)    // Bytes of parsed frames kept between loads
+
+class FrameCache {
+public:
+    typedef PreloadedSource::Data Data;
+
+    /**
+     * Which version of a file was parsed.
+     */
+    struct Stamp {
+        uint64_t device;
+        uint64_t inode;
+        int64_t size;
+        int64_t seconds;
+        int64_t nanoseconds;
+
+        bool operator==(const Stamp &other) const;
+    };
+
+    /**
+     * Take the stamp of a file as it is now.
+     * @return False if the file cannot be stat()ed
+     */
+    static bool stamp(const string &path, Stamp &stamp);
+
+    /**
+     * The parsed frames of the file at 'path', if they were parsed from the version with this stamp.
+     */
+    static Data find(const string &path, const Stamp &stamp);
+
+    /**
+     * Keep the frames parsed from the version of 'path' with this stamp, dropping old files to stay under the limit.
+     */
+    static void store(const string &path, const Stamp &stamp, const Data &data);
+
+    static void setLimit(size_t bytes);
+    static size_t getLimit();
+    static size_t size();
+    static int64_t numHits();
+    static int64_t numMisses();
+    static void clear();
+
+private:
+    struct Entry {
+        Stamp stamp;
+        Data data;
+        size_t bytes;
+        list< string >::iterator use;
+    };
+
+    static void trim();
+
+    static boost::mutex lock;
+    static map< string, Entry > entries;
+    static list< string > uses;             // Most recently loaded first
+    static size_t bytes;
+    static size_t limit;
+    static int64_t hits;
+    static int64_t misses;
+};
+
+#endif /* FRAMECACHE_H_ */
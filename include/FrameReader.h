@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * FrameReader.h
+ *
+ * Something frames can be read from a buffer at a time: a text file, or a compressed
+ * one. This is what a StreamedSource's prefetch thread reads from.
+ */
+
+#ifndef FRAMEREADER_H_
+#define FRAMEREADER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+class FrameReader {
+public:
+    typedef std::vector< double > Frame;
+    typedef std::vector< Frame > Buffer;
+    typedef std::vector< std::string > Header;
+    typedef std::map < std::string, int > HeaderMap;
+
+    virtual ~FrameReader() {}
+
+    /**
+     * Fills the buffer with the next frames. Returns false at the end or on error.
+     */
+    virtual bool loadBuffer() = 0;
+
+    /**
+     * Goes back to the first frame, so that the next loadBuffer() starts with it.
+     */
+    virtual void reset() = 0;
+
+    /**
+     * Moves to frame 'frame', counted from 0, so that the next loadBuffer() starts with it.
+     * Returns false if there is no such frame.
+     */
+    virtual bool seek(int frame) = 0;
+
+    /**
+     * Frames per second the frames were recorded at, or 0 if not known.
+     */
+    virtual double rate() { return 0; }
+
+    virtual Buffer& buffer() = 0;
+    virtual HeaderMap& header() = 0;
+    virtual Header& orderedHeader() = 0;
+    virtual Frame& start() = 0;
+    virtual Frame& end() = 0;
+    virtual int numLines() = 0;
+    virtual int numCols() = 0;
+
+    virtual bool errored() = 0;
+    virtual std::string getError() = 0;
+};
+
+#endif /* FRAMEREADER_H_ */
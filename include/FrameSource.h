@@ -0,0 +1,137 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * FrameSource.h
+ *
+ * Where a read trajectory gets its frames from. Every source knows its columns and its
+ * first and last frames up front, and hands out the current frame as a plain array of
+ * doubles, one per column. How the frames get there (parsed into memory ahead of time,
+ * streamed from disk by a prefetch thread, or mapped from a binary file) is up to the
+ * subclass.
+ */
+
+#ifndef FRAMESOURCE_H_
+#define FRAMESOURCE_H_
+
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "WSVFile.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+#define DEFAULT_PRELOAD_LIMIT (64 * 1024 * 1024)   // Bytes of frames a single file may preload
+#define STREAM_BUFFER_SIZE 200                      // Frames in each prefetched block when a file is streamed
+#define DEFAULT_HEADER "RHY RHR RHP RKP RAP RAR LHY LHR LHP LKP LAP LAR RSP RSR RSY REP RWY RWR RWP LSP LSR LSY LEP LWY LWR LWP NKY NK1 NK2 WST RF1 RF2 RF3 RF4 RF5 LF1 LF2 LF3 LF4 LF5"
+
+class FrameSource {
+public:
+    typedef WSVFile::Frame Frame;
+    typedef WSVFile::Header Header;
+    typedef WSVFile::HeaderMap HeaderMap;
+
+    static FrameSource* open(const string &path, string &error);
+    static void setPreloadLimit(size_t bytes);
+    static size_t getPreloadLimit();
+
+    virtual ~FrameSource();
+
+    /**
+     * The values of the current frame, one per column, or NULL if there is none.
+     */
+    virtual const double* current() = 0;
+
+    /**
+     * Move to the next frame.
+     * @return False at the end of the source or on error
+     */
+    virtual bool advance() = 0;
+
+    /**
+     * Go back to the first frame.
+     * @return False on error
+     */
+    virtual bool rewind() = 0;
+
+    /**
+     * Go to frame 'frame', counted from 0.
+     * @return False if there is no such frame, or on error
+     */
+    virtual bool seek(int frame) = 0;
+
+    /**
+     * Whether the frame sought has yet to be read. Until it has, current() is the frame from before the seek.
+     */
+    virtual bool seeking();
+
+    /**
+     * Whether the last advance() stayed where it was instead of moving on by a frame, as a
+     * streamed source does while the frame it needs is not read yet.
+     */
+    virtual bool stalled();
+
+    /**
+     * Frames per second the source was recorded at, or 0 if it does not say.
+     */
+    virtual double rate();
+
+    HeaderMap& header();
+    const Header& orderedHeader();
+    int column(const string &name);
+    int numCols();
+    int numFrames();
+
+    const Frame& start();
+    const Frame& end();
+
+    bool errored();
+    const string& getError();
+
+protected:
+    FrameSource();
+    void describe(FrameReader &file);
+    void fail(const string &message);
+
+    HeaderMap _header;
+    Header _orderedHeader;
+    Frame _start;
+    Frame _end;
+    int _frames;
+
+    bool _error;
+    string errorMessage;
+
+private:
+    static size_t preloadLimit;
+};
+
+#endif /* FRAMESOURCE_H_ */
@@ -47,14 +47,12 @@ class HuboMotor : public RobotComponent, public Interpolable {
 
 private:
 
-    typedef ReferenceChannel::Mode Mode;
+    //Identification, stored in the joint table
+    int& mode;                      //hubo-ach interpretation mode
 
-    //Identification
-    Mode mode;                      //hubo-ach interpretation mode
-
-    //Internal State
-    bool enabled;                    //Whether the motor has motion enabled
-    int boardNum;                   //Board number as referenced in Hubo-ach
+    //Internal State, stored in the joint table
+    bool& enabled;                  //Whether the motor has motion enabled
+    int& boardNum;                  //Board number as referenced in Hubo-ach
 
     //Soft limits for the motors
     double lowerLim;
@@ -63,7 +61,7 @@ private:
 
 public:
 
-    HuboMotor();
+    HuboMotor(JointTable& table);
     virtual ~HuboMotor();
 
     bool get(PROPERTY property, double& value);
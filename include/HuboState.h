@@ -34,9 +34,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string>
 #include <queue>
 #include <iostream>
+#include <utility>
 
 #include "RobotComponent.h"
 #include "MetaJointController.h"
+#include "JointTable.h"
+#include "JointRegistry.h"
 
 #include "HuboMotor.h"
 #include "FTSensorBoard.h"
@@ -48,6 +51,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "LowerBodyLeg.h"
 
 using std::map;
+using std::pair;
 using std::string;
 using std::cout;
 using std::endl;
@@ -70,13 +74,17 @@ class HuboState : public Singleton<HuboState> {
 public:
     typedef vector< RobotComponent* > Components;
     typedef vector< HuboMotor* > Motors;
+    typedef vector< MetaJoint* > MetaJoints;
 
 private:
     
     Components components;
     Motors motors;
+    MetaJoints metaJoints;
     vector< MetaJointController* > controllers;
+    JointTable joints;
     map< string, RobotComponent* > index;
+    vector< pair< string, string > > registryAliases; // Aliases from the config, for the joint registry once this state is in use
 
 protected:
     HuboState();
@@ -84,15 +92,21 @@ protected:
 
 public:
 
+    static HuboState* spare();
+
     void initHuboWithDefaults(string path, double frequency);
+    void initHuboFromDocument(xml_document& doc, double frequency);
+    void registerAliases();
 
     bool setAlias(string name, string alias);
-    bool nameExists(string name);
+    bool nameExists(const string &name);
 
-    RobotComponent* getComponent(string name);
+    RobotComponent* getComponent(const string &name);
 
     const Components &getComponents();
     const Motors &getMotors();
+    const MetaJoints &getMetaJoints();
+    JointTable &getJointTable();
 
 private:
 
@@ -103,6 +117,7 @@ private:
 
     bool addComponentFromXML(xml_node node, RobotComponent* component, bool back);
     bool addMetaJointControllerFromXML(xml_node node, MetaJointController* controller, string type, double frequency);
+    bool addAlias(const string &name, const string &alias);
 
     void reset();
 };
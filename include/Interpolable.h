@@ -42,14 +42,18 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <iostream>
 
 #include "Interpolation.h"
+#include "JointTable.h"
 
 
 class Interpolable {
 protected:
-    //Output Data
-    double currGoal;        //Goal position in radians
-    double interStep;       //Current interpolated step in radians
-    double interVel;        //Current interpolated velocity in rad/sec
+    JointTable& table;      //Table holding this joint's row
+    int row;                //Row of the table this joint owns
+
+    //Output Data, stored in the joint table
+    double& currGoal;       //Goal position in radians
+    double& interStep;      //Current interpolated step in radians
+    double& interVel;       //Current interpolated velocity in rad/sec
 
     double lastGoal;        //Origin point for sinusoidal inteprolation
     double frequency;       //Interpolation Frequency
@@ -62,9 +66,11 @@ protected:
     FourthOrderParams startParams;
     FourthOrderParams currParams;
 public:
-    Interpolable();
+    Interpolable(JointTable& table, JOINT_KIND kind);
     virtual ~Interpolable();
 
+    int getRow();
+
     void setFrequency(double frequency);
     bool setOffset(double offSet);
     double getOffset();
@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * JointRegistry.h
+ *
+ * The one list of hubo-ach joint names, and the map from joint names and their aliases
+ * to hubo-ach joint indices. Names are resolved when the robot is loaded so that the
+ * ach channels only ever index arrays while the loop is running.
+ */
+
+#ifndef JOINTREGISTRY_H_
+#define JOINTREGISTRY_H_
+
+#include <map>
+#include <string>
+#include "Singleton.h"
+#include "hubo.h"
+
+using std::map;
+using std::string;
+
+class JointRegistry : public Singleton<JointRegistry> {
+    friend class Singleton<JointRegistry>;
+
+private:
+    static const char *urdf_joint_names[];
+
+    map< string, int > names;
+    map< string, int > aliases;
+
+protected:
+    JointRegistry();
+
+public:
+
+    int indexOf(const string &name) const;
+    const char* nameOf(int index) const;
+
+    bool setAlias(const string &name, const string &alias);
+    void clearAliases();
+};
+
+#endif /* JOINTREGISTRY_H_ */
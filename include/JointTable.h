@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * JointTable.h
+ *
+ * The state the control loop touches every tick for every joint, kept as one array per
+ * field instead of spread across the joint objects. HuboMotor and MetaJoint still
+ * present the usual get/set interface, but their goal, step, velocity, mode, enabled
+ * and board values live in a row of this table, so the loop can walk it front to back.
+ */
+
+#ifndef JOINTTABLE_H_
+#define JOINTTABLE_H_
+
+#include <bitset>
+
+#define JOINT_TABLE_SIZE 128
+#define CACHE_LINE 64
+
+class RobotComponent;
+
+// One bit per row of the table, spare row included
+typedef std::bitset< JOINT_TABLE_SIZE + 1 > JointMask;
+
+enum JOINT_KIND {
+    JOINT_FREE, JOINT_MOTOR, JOINT_META
+};
+
+class JointTable {
+public:
+    JointTable();
+
+    int add(JOINT_KIND kind);
+    void release(int row);
+    void clear();
+
+    int size() const;
+    bool full() const;
+
+    // The arrays are only cache aligned when the table is not on the heap. HuboState
+    // keeps both its instance and its spare in function statics, so the ones that matter are.
+    double goal[JOINT_TABLE_SIZE + 1] __attribute__((aligned(CACHE_LINE)));        // Goal position in radians
+    double step[JOINT_TABLE_SIZE + 1] __attribute__((aligned(CACHE_LINE)));        // Current interpolated step in radians
+    double velocity[JOINT_TABLE_SIZE + 1] __attribute__((aligned(CACHE_LINE)));    // Interpolation velocity in rad/sec
+    int mode[JOINT_TABLE_SIZE + 1] __attribute__((aligned(CACHE_LINE)));           // hubo-ach reference mode
+    int board[JOINT_TABLE_SIZE + 1] __attribute__((aligned(CACHE_LINE)));          // hubo-ach board number, or -1
+    int index[JOINT_TABLE_SIZE + 1] __attribute__((aligned(CACHE_LINE)));          // hubo-ach joint index to send references to, or -1
+    bool enabled[JOINT_TABLE_SIZE + 1] __attribute__((aligned(CACHE_LINE)));
+    char kind[JOINT_TABLE_SIZE + 1] __attribute__((aligned(CACHE_LINE)));
+    RobotComponent* component[JOINT_TABLE_SIZE + 1] __attribute__((aligned(CACHE_LINE)));
+
+private:
+    int rows;
+};
+
+#endif /* JOINTTABLE_H_ */
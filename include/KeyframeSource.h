@@ -0,0 +1,93 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * KeyframeSource.h
+ *
+ * A trajectory given as keyframes instead of a frame for every tick. A keyframe file is
+ * a whitespace separated text file, like any other trajectory, ending in ".keys". Its
+ * header names a "time" column, then the joints. Each row is a time in seconds, then a
+ * position for each joint, or "-" where that joint has no keyframe at that time:
+ *
+ *     time  RSP   RSR   REP
+ *     0     0     0     0
+ *     1.5   -.8   -     -1.2
+ *     3     0     0     0
+ *
+ * Between its keyframes, each joint follows a monotone cubic Hermite spline, so it
+ * never overshoots a keyframe, and it is at rest at its first and last ones. Before its
+ * first keyframe and after its last, a joint holds still.
+ *
+ * The spline is evaluated at KEYFRAME_RATE frames per second, one frame per advance(),
+ * so to the rest of the trajectory code this is a source like any other.
+ */
+
+#ifndef KEYFRAMESOURCE_H_
+#define KEYFRAMESOURCE_H_
+
+#include "FrameSource.h"
+
+#define KEYFRAME_EXTENSION ".keys"
+#define KEYFRAME_TIME_COLUMN "time"
+#define KEYFRAME_RATE 200.0     // Frames per second the keyframes are evaluated at. The loop's rate.
+
+bool isKeyframeTrajectory(const string &path);
+
+class KeyframeSource : public FrameSource {
+public:
+    KeyframeSource(const string &path);
+    ~KeyframeSource();
+
+    const double* current();
+    bool advance();
+    bool rewind();
+    bool seek(int frame);
+
+    double rate();
+
+private:
+    /**
+     * The keyframes of one joint, and where playback is among them.
+     */
+    struct Spline {
+        vector< double > times;
+        vector< double > values;
+        vector< double > slopes;    // Per second, at each keyframe
+        int segment;                // The last keyframe at or before the current time
+    };
+
+    bool parse(const string &path);
+    void fit(Spline &spline);
+    void locate(double time);
+    void evaluate(int frame, Frame &values);
+
+    vector< Spline > splines;       // One per column
+    Frame values;                   // The current frame
+    int frame;
+};
+
+#endif /* KEYFRAMESOURCE_H_ */
@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * LatencyHistogram.h
+ *
+ * A fixed size, log-linear (HDR style) histogram of durations in nanoseconds.
+ * Every power of two range is split into SUB_BUCKETS equal buckets, so values are
+ * kept to within about 3% all the way from a few nanoseconds up to seconds.
+ * Recording never allocates, so it can be done from the real time loop.
+ */
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <stdint.h>
+
+#define SUB_BUCKET_BITS 5
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define MAGNITUDES 28       // Up to 2^32 ns, a little over 4 seconds
+#define HISTOGRAM_BUCKETS (MAGNITUDES * SUB_BUCKETS)
+
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(int64_t ns);
+    void reset();
+
+    int64_t count() const;
+    int64_t min() const;
+    int64_t max() const;
+    double mean() const;
+    int64_t percentile(double p) const;
+
+    int numBuckets() const;
+    int64_t bucketCount(int bucket) const;
+    int64_t bucketLowerBound(int bucket) const;
+    int64_t bucketUpperBound(int bucket) const;
+
+private:
+    static int bucketFor(int64_t ns);
+
+    int64_t counts[HISTOGRAM_BUCKETS];
+    int64_t total;
+    int64_t sum;
+    int64_t minimum;
+    int64_t maximum;
+};
+
+#endif /* LATENCYHISTOGRAM_H_ */
@@ -0,0 +1,118 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * LoopLog.h
+ *
+ * Diagnostics from the control loop. A message logged on the loop thread is formatted
+ * into a preallocated slot of a lock-free ring buffer and printed later by a low
+ * priority drain thread, so logging never makes the loop wait on a terminal. Each call
+ * site is rate limited, and messages below the log level are not even formatted.
+ * Messages from any other thread are printed straight away, as before.
+ */
+
+#ifndef LOOPLOG_H_
+#define LOOPLOG_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <boost/thread.hpp>
+
+#include "RingBuffer.h"
+#include "Singleton.h"
+
+#define LOG_RING_SIZE 256               // Must be a power of two
+#define LOG_LINE_LENGTH 200
+#define LOG_BURST 5                     // Messages a call site may log back to back
+#define LOG_REFILL_NS 1000000000LL      // How often a call site gets another message
+#define LOG_DRAIN_PERIOD_US 10000
+
+enum LOG_LEVEL {
+    LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR
+};
+
+/**
+ * The rate limit state of one call site. LOOP_LOG keeps one of these per call.
+ */
+struct LogSite {
+    int64_t refilled;
+    int tokens;
+    int suppressed;
+};
+
+struct LogEntry {
+    LOG_LEVEL level;
+    int suppressed;     // Messages from the same site dropped by the rate limit before this one
+    char text[LOG_LINE_LENGTH];
+};
+
+class LoopLog : public Singleton<LoopLog> {
+    friend class Singleton<LoopLog>;
+
+protected:
+    LoopLog();
+    ~LoopLog();
+
+public:
+    void start();
+    void stop();
+    void setLoopThread();
+
+    void setLevel(LOG_LEVEL level);
+    bool setLevel(const char *name);
+    bool enabled(LOG_LEVEL level);
+
+    void write(LogSite &site, LOG_LEVEL level, const char *format, ...) __attribute__((format(printf, 4, 5)));
+
+    int64_t numDropped();
+
+private:
+    void run();
+    void drain();
+    void print(const LogEntry &entry);
+    static int64_t now();
+
+    RingBuffer< LogEntry, LOG_RING_SIZE > ring;
+    pthread_t loopThread;
+    volatile bool haveLoopThread;
+    volatile bool running;
+    volatile int level;
+    int64_t dropped;    // Messages lost because the ring was full
+    int64_t reported;   // How many of those the drain thread has already mentioned
+    boost::thread thread;
+};
+
+/**
+ * Log a printf style message. On the loop thread this never blocks or allocates.
+ */
+#define LOOP_LOG(level, ...) \
+    do { \
+        static LogSite logSite = {0, LOG_BURST, 0}; \
+        LoopLog::instance()->write(logSite, level, __VA_ARGS__); \
+    } while (0)
+
+#endif /* LOOPLOG_H_ */
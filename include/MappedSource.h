@@ -0,0 +1,67 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * MappedSource.h
+ *
+ * A binary trajectory file, mapped into memory. Opening one only reads the header, so
+ * it is near instant however long the recording is. Files of doubles are played in
+ * place; files of floats have each frame widened once, as it is reached.
+ */
+
+#ifndef MAPPEDSOURCE_H_
+#define MAPPEDSOURCE_H_
+
+#include "FrameSource.h"
+#include "BinaryTrajectory.h"
+
+class MappedSource : public FrameSource {
+public:
+    MappedSource(const string &path);
+    ~MappedSource();
+
+    const double* current();
+    bool advance();
+    bool rewind();
+    bool seek(int frame);
+
+    double rate();
+
+private:
+    void widen();
+    const char* row(int frame);
+
+    void* map;
+    size_t mapSize;
+    const char* data;       // The first frame
+    int valueSize;
+    double _rate;
+    int frame;
+    Frame widened;          // The current frame, when the file holds floats
+};
+
+#endif /* MAPPEDSOURCE_H_ */
@@ -47,7 +47,7 @@ private:
     bool ready;
 
 public:
-    MetaJoint(MetaJointController* controller);
+    MetaJoint(MetaJointController* controller, JointTable& table);
     virtual ~MetaJoint();
 
     virtual bool get(PROPERTY property, double &value);
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * MotionWaiter.h
+ *
+ * A caller waiting for a set of components to reach their goals. The waiter is handed
+ * to the control loop, which checks it once per tick and posts its semaphore as soon
+ * as every component is within tolerance, so the caller wakes within a tick of the
+ * motion finishing instead of polling requiresMotion.
+ */
+
+#ifndef MOTIONWAITER_H_
+#define MOTIONWAITER_H_
+
+#include <semaphore.h>
+
+#include "RobotComponent.h"
+
+#define MOTION_WAIT_COMPONENTS 64
+#define MAX_MOTION_WAITERS 8
+#define DEFAULT_MOTION_TOLERANCE .01
+
+class MotionWaiter {
+public:
+    MotionWaiter(double tolerance);
+    ~MotionWaiter();
+
+    bool add(RobotComponent* component);
+    void clear();
+
+    bool arrived();
+    void finish(bool arrived);
+
+    bool wait(double timeout);
+    bool succeeded();
+
+private:
+    RobotComponent* components[MOTION_WAIT_COMPONENTS];
+    int count;
+    double tolerance;
+    bool result;
+    sem_t done;
+};
+
+#endif /* MOTIONWAITER_H_ */
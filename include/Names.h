@@ -55,38 +55,37 @@ enum COMMAND {
     INITSENSORS,
     UPDATE, ZERO,
     ZEROALL, BALANCEON,
-    BALANCEOFF
+    BALANCEOFF, PROFILEON,
+    PROFILEOFF
 };
 
 
 
+/**
+ * The property and command names are fixed tables sorted by name, so looking one up is
+ * a binary search that never allocates. Aliases added at run time are kept in maps
+ * that are only searched when the name is not in the table.
+ */
 class Names {
 public:
 
     typedef map< string, PROPERTY > Properties;
     typedef map< string, COMMAND > Commands;
 
-    static void initPropertyMap();
-    static void initCommandMap();
-    static bool setAlias(string name, string alias);
-    static Properties & getProps(){
-        return getProperties();
-    }
-    static Commands & getComms(){
-        return getCommands();
-    }
+    static bool lookup(const string &name, PROPERTY &property);
+    static bool lookup(const string &name, COMMAND &command);
+    static bool setAlias(const string &name, const string &alias);
 
-    static string getName(PROPERTY &property);
-    static string getName(COMMAND &command);
+    static const char* getName(PROPERTY property);
+    static const char* getName(COMMAND command);
 
 private:
 
-
-    static Properties & getProperties(){
+    static Properties & getPropertyAliases(){
         static Properties properties;
         return properties;
     }
-    static Commands & getCommands(){
+    static Commands & getCommandAliases(){
         static Commands commands;
         return commands;
     }
@@ -0,0 +1,78 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * PreloadedSource.h
+ *
+ * A trajectory file parsed completely when it is loaded. The frames sit in one
+ * contiguous array, so playing them back is only indexing into it. The parsed file
+ * never changes once it is read, so any number of sources can share it.
+ */
+
+#ifndef PRELOADEDSOURCE_H_
+#define PRELOADEDSOURCE_H_
+
+#include <boost/shared_ptr.hpp>
+
+#include "FrameSource.h"
+
+/**
+ * Everything parsed out of a preloaded file.
+ */
+struct FrameData {
+    FrameSource::HeaderMap header;
+    FrameSource::Header orderedHeader;
+    FrameSource::Frame start;
+    FrameSource::Frame end;
+    vector< double > values;    // frames rows of start.size() values
+    int frames;
+};
+
+class PreloadedSource : public FrameSource {
+public:
+    typedef boost::shared_ptr< const FrameData > Data;
+
+    PreloadedSource(WSVFile &file);
+    PreloadedSource(const Data &data);
+    ~PreloadedSource();
+
+    const double* current();
+    bool advance();
+    bool rewind();
+    bool seek(int frame);
+
+    const Data& data();
+
+private:
+    void use(const Data &data);
+
+    Data parsed;
+    const double* values;       // numFrames() rows of numCols() values
+    int frame;
+};
+
+#endif /* PRELOADEDSOURCE_H_ */
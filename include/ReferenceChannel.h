@@ -41,6 +41,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdint.h>
 #include <sys/types.h>
 #include "Singleton.h"
+#include "JointRegistry.h"
 #include "ach.h"
 #include "hubo.h"
 #include <iostream>
@@ -59,8 +60,6 @@ public:
     typedef hubo_mode_type_t Mode;
 
 private:
-    static const char *urdf_joint_names[];
-
     AchChannel huboReferenceChannel;
     Reference currentReference;
 
@@ -77,6 +76,7 @@ public:
 
     void load(); // Load most recent data
     void setReference(string &joint, double rad, hubo_mode_type_t mode);
+    void setReference(int index, double rad, hubo_mode_type_t mode);
     void update(); // Save modified data
 };
 
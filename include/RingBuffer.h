@@ -0,0 +1,138 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * RingBuffer.h
+ *
+ * A fixed size, single producer / single consumer ring buffer. Neither side ever
+ * blocks or allocates, so it is safe to use from the real time loop.
+ */
+
+#ifndef RINGBUFFER_H_
+#define RINGBUFFER_H_
+
+template <typename T, unsigned long CAPACITY>
+class RingBuffer {
+public:
+    RingBuffer(){
+        // CAPACITY has to be a power of two so the indices can wrap freely.
+        typedef char capacityMustBePowerOfTwo[(CAPACITY & (CAPACITY - 1)) == 0 ? 1 : -1] __attribute__((unused));
+        head = 0;
+        tail = 0;
+    }
+
+    /**
+     * Copy an item into the buffer. Producer side only.
+     * @return False if the buffer is full
+     */
+    bool push(const T& item){
+        T* slot = claim();
+        if (slot == NULL)
+            return false;
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    /**
+     * Copy the oldest item out of the buffer. Consumer side only.
+     * @return False if the buffer is empty
+     */
+    bool pop(T& item){
+        T* slot = front();
+        if (slot == NULL)
+            return false;
+        item = *slot;
+        release();
+        return true;
+    }
+
+    /**
+     * Get the next free slot to fill in place. Producer side only. The slot is not
+     * visible to the consumer until commit() is called.
+     * @return The slot, or NULL if the buffer is full
+     */
+    T* claim(){
+        unsigned long h = head;
+        __sync_synchronize();
+        if (h - tail >= CAPACITY)
+            return NULL;
+        return &items[h & (CAPACITY - 1)];
+    }
+
+    /**
+     * Publish the slot returned by claim()
+     */
+    void commit(){
+        __sync_synchronize();
+        head = head + 1;
+    }
+
+    /**
+     * Peek at the oldest item in place. Consumer side only.
+     * @return The item, or NULL if the buffer is empty
+     */
+    T* front(){
+        unsigned long t = tail;
+        __sync_synchronize();
+        if (t == head)
+            return NULL;
+        __sync_synchronize();
+        return &items[t & (CAPACITY - 1)];
+    }
+
+    /**
+     * Hand the slot returned by front() back to the producer
+     */
+    void release(){
+        __sync_synchronize();
+        tail = tail + 1;
+    }
+
+    unsigned long size(){
+        return head - tail;
+    }
+
+    bool empty(){
+        return head == tail;
+    }
+
+    unsigned long capacity(){
+        return CAPACITY;
+    }
+
+private:
+    // Kept on separate cache lines so the producer and consumer don't fight over them.
+    volatile unsigned long head;
+    char headPad[64 - sizeof(unsigned long)];
+    volatile unsigned long tail;
+    char tailPad[64 - sizeof(unsigned long)];
+
+    T items[CAPACITY];
+};
+
+#endif /* RINGBUFFER_H_ */
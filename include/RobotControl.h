@@ -32,6 +32,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define HARDWARE true
 #define SIMULATION false
 
+#define HANDLE_INDEX_BITS 16
+#define HANDLE_INDEX_MASK ((1 << HANDLE_INDEX_BITS) - 1)
+#define HANDLE_GENERATION_MASK 0x7fff
+
 #include "ros/ros.h"
 
 #include <vector>
@@ -43,6 +47,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sys/time.h>
 #include <string>
 #include <stdio.h>
+#include <stdlib.h>
+#include <utility>
 
 #include "Scheduler.h"
 #include "HuboState.h"
@@ -60,6 +66,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Trajectory.h"
 #include "TrajHandler.h"
 #include "BalanceController.h"
+#include "StageProfiler.h"
+#include "StateSnapshot.h"
+#include "MotionWaiter.h"
 
 using ros::NodeHandle;
 using std::queue;
@@ -72,38 +81,86 @@ using std::ostringstream;
 using std::istringstream;
 using std::cout;
 using std::endl;
+using std::pair;
 
 class RobotControl {
 
 private:
     typedef HuboState::Components Components;
     typedef HuboState::Motors Motors;
+    typedef HuboState::MetaJoints MetaJoints;
     typedef Trajectory::Header Header;
-    typedef Names::Properties Properties;
-    typedef Names::Commands Commands;
 
 public:
+    // Property sets that have been split and looked up already, ready to apply on the loop
+    struct PropertyUpdates {
+        vector<RobotComponent*> components;
+        vector<PROPERTY> properties;
+        vector<double> values;
+    };
+
+    // A getProperties request that has been split and looked up already. The loop fills in the values.
+    struct PropertyQuery {
+        RobotComponent* component;  // NULL for the ZMP
+        vector<int> properties;     // PROPERTY, or the ZMP axis. -1 for ones that do not exist.
+        vector<double> values;
+    };
+
+    // A command that has been looked up already, ready to run on the loop
+    struct Command {
+        COMMAND command;
+        RobotComponent* component;  // The target, for the commands that act on one component
+        string target;
+    };
+
     RobotControl();
     ~RobotControl();
 
     void updateHook();
     void initRobot(string path);
+    void initRobot(xml_document& doc);
+    void buildRobot(xml_document& doc);
+    void swapRobot();
+    bool loadConfig(string path, xml_document& doc);
     void setPeriod(double period);
+    StageProfiler& getProfiler();
+    void snapshotState(StateSnapshot &snapshot);
+    void getStateLayout(StateLayout &layout);
 
     //JOINT MOVEMENT API
-    void set(string name, string property, double value);
+    void set(const string &name, const string &property, double value);
+    void set(RobotComponent* component, PROPERTY property, double value);
     void setProperties(string names, string properties, string values);
+    bool setPropertiesBatch(const vector<string> &names, const vector<string> &properties, const vector<double> &values);
+    bool prepareProperties(const string &names, const string &properties, const string &values, PropertyUpdates &updates);
+    bool prepareProperties(const vector<string> &names, const vector<string> &properties, const vector<double> &values, PropertyUpdates &updates);
+    void setProperties(const PropertyUpdates &updates);
 
     // Control Commands
     void debugControl(int board, int operation);
     void setDelay(int us);
     void command(string name, string target);
+    bool prepareCommand(const string &name, const string &target, Command &comm);
+    void command(const Command &comm);
     //void handleMessage(MaestroCommand message);
 
     // Feedback Commands
     bool requiresMotion(string name);
-    double get(string name, string property);
+    bool requiresMotion(RobotComponent* component);
+    bool addWaiter(MotionWaiter* waiter, const vector<string> &names);
+    void removeWaiter(MotionWaiter* waiter);
+    double get(const string &name, const string &property);
     string getProperties(string name, string properties);
+    void prepareQuery(const string &name, const string &properties, PropertyQuery &query);
+    void query(PropertyQuery &query);
+    string formatQuery(const PropertyQuery &query);
+    RobotComponent* getComponent(const string &name);
+
+    // Handle API. Resolve a component and property once, then set and get by number.
+    int resolveHandle(const string &name, const string &property);
+    int resolveHandle(RobotComponent* component, PROPERTY property);
+    bool setByHandle(int handle, double value);
+    bool getByHandle(int handle, double &value);
     void updateState();
 
     // Feedback for walking
@@ -119,26 +176,45 @@ public:
 
     // Trajectory Commands
     bool loadTrajectory(string name, string path, bool read);
+    bool addTrajectory(string name, Trajectory* traj, Trajectory*& replaced);
     bool ignoreFrom(string name, string col);
     bool ignoreAllFrom(string name);
     bool unignoreFrom(string name, string col);
     bool unignoreAllFrom(string name);
     bool setTrigger(string name, int frame, string target);
-    bool extendTrajectory(string name, string path);
-    void startTrajectory(string name);
+    bool loopTrajectory(string name, bool loop);
+    bool seekTrajectory(string name, int frame);
+    bool seekingTrajectory(string name);
+    bool setTrajectoryRate(string name, double rate);
+    bool extendTrajectory(string name, FrameSource* source);
+    bool startTrajectory(string name);
     void stopTrajectory(string name);
 
     // Configuration Commands
     void setSimType();
     bool setAlias(string name, string alias);
-    vector<string> splitFields(string input);
+    vector<string> splitFields(const string &input);
     string getDefaultInitPath(string path);
 
 
 private:
 
-    
+    struct Handle {
+        RobotComponent* component;
+        PROPERTY property;
+    };
+
+    Handle* findHandle(int handle);
+    void clearHandles();
+
+    void driveMetaJoint(MetaJoint* component);
+    void driveMotor(JointTable& joints, int row);
+    void finishJoint(RobotComponent* component, int row);
+    void checkWaiters();
+    void cancelWaiters();
+
     HuboState *state;
+    HuboState *building;    // Where the next robot is built, off the loop, before swapRobot puts it in use
     PowerControlBoard *power;
     BalanceController *balancer;
 
@@ -147,6 +223,17 @@ private:
     ofstream tempOutput;
     ifstream trajInput;
     TrajHandler trajectories;
+    StageProfiler profiler;
+    Components ftSensors;   // The sensors that go in state snapshots, found when the robot is initialized
+    Components imus;
+    int robotGeneration;
+
+    MotionWaiter* waiters[MAX_MOTION_WAITERS];
+    int numWaiters;
+
+    vector< Handle > handles;
+    map< pair< RobotComponent*, int >, int > handleLookup;
+    int handleGeneration;
 
     CommandChannel *commandChannel;
     ReferenceChannel *referenceChannel;
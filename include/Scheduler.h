@@ -57,6 +57,20 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define FREQ_500HZ  2000000;    // (.002 sec)
 
 #include <time.h>
+#include <stdint.h>
+
+#include "LatencyHistogram.h"
+
+/**
+ * Timing measurements taken by the scheduler, all in nanoseconds.
+ */
+struct TimingStats {
+    int64_t ticks;                  // Number of periods that have been run
+    int64_t overruns;               // Ticks whose work was still going at the next deadline
+    int64_t skipped;                // Periods dropped entirely to catch back up after an overrun
+    LatencyHistogram wakeLatency;   // How late the loop woke up relative to its deadline
+    LatencyHistogram workTime;      // How long each tick spent working before going back to sleep
+};
 
 class Scheduler {
 
@@ -64,6 +78,7 @@ public:
     Scheduler (long period);
     ~Scheduler();
 
+    void start();
     void update();
     void sleep();
 
@@ -73,15 +88,23 @@ public:
     double getPeriod();
     double getFrequency();
 
+    const TimingStats& getStats();
+    void resetStats();
+
 private:
 
     void normalizeTimespec(timespec* t);
     void getTime(timespec* t);
+    int64_t elapsed(const timespec& from, const timespec& to);
 
     long period;
 
     timespec currTime;
     timespec nextShot;
+    timespec wakeTime;
+
+    bool measuring;
+    TimingStats stats;
 
 };
 
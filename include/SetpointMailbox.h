@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * SetpointMailbox.h
+ *
+ * Holds the newest setpoint message streamed in on the setpoints topic until the
+ * control loop picks it up. The subscriber thread overwrites it; the loop only ever
+ * try_locks it, so a post in progress costs the loop one tick of delay rather than a
+ * wait. Both sides copy into fixed arrays, so nothing allocates.
+ */
+
+#ifndef SETPOINTMAILBOX_H_
+#define SETPOINTMAILBOX_H_
+
+#include <time.h>
+#include <stdint.h>
+#include <boost/thread/mutex.hpp>
+
+#define SETPOINT_CAPACITY 128
+
+/**
+ * One batch of setpoints. sent is the ROS time its sender stamped it with, and stamp the
+ * CLOCK_MONOTONIC time it was received, both in nanoseconds. sent is 0 if the sender did
+ * not stamp it.
+ */
+struct Setpoints {
+    int count;
+    int64_t sent;
+    int64_t stamp;
+    int handles[SETPOINT_CAPACITY];
+    double values[SETPOINT_CAPACITY];
+};
+
+class SetpointMailbox {
+public:
+    SetpointMailbox();
+
+    void setTimeout(double seconds);
+
+    bool post(const int *handles, const double *values, int count, int64_t sent);
+    bool take(Setpoints &setpoints);
+
+    int64_t numStale();
+    int64_t numDropped();
+
+    static int64_t now();
+
+private:
+    boost::mutex lock;
+    Setpoints latest;
+    bool fresh;
+
+    int64_t timeout;
+    int64_t stale;      // Messages that were too old by the time the loop saw them
+    int64_t dropped;    // Messages that were overwritten before the loop saw them
+};
+
+#endif /* SETPOINTMAILBOX_H_ */
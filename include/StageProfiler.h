@@ -0,0 +1,126 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * StageProfiler.h
+ *
+ * Times the stages of RobotControl::updateHook(). Each tick's stage durations are
+ * kept in a fixed window of the last PROFILE_WINDOW ticks, so recording never
+ * allocates. When the profiler is off every call is a single branch.
+ */
+
+#ifndef STAGEPROFILER_H_
+#define STAGEPROFILER_H_
+
+#include <time.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PROFILE_WINDOW 1024     // Ticks kept, about five seconds at 200Hz
+
+enum STAGE {
+    STAGE_SIM_LOAD, STAGE_REFERENCE_LOAD, STAGE_STATE_LOAD,
+    STAGE_BALANCE, STAGE_COMPONENTS, STAGE_TRAJECTORY_ADVANCE,
+    STAGE_REFERENCE_UPDATE, STAGE_TOTAL,
+    NUM_STAGES
+};
+
+/**
+ * Summary of one stage over the window, in nanoseconds.
+ */
+struct StageSummary {
+    int64_t min;
+    double mean;
+    int64_t p99;
+    int64_t max;
+};
+
+class StageProfiler {
+public:
+    StageProfiler();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    void reset();
+
+    /**
+     * Start timing a tick. Stages that do not run this tick are recorded as zero.
+     */
+    inline void begin(){
+        if (!enabled)
+            return;
+        memset(samples[next], 0, sizeof(samples[next]));
+        clock_gettime(CLOCK_MONOTONIC, &tickStart);
+        last = tickStart;
+    }
+
+    /**
+     * Charge the time since the last mark (or the start of the tick) to a stage.
+     * @param stage The stage that just finished
+     */
+    inline void mark(STAGE stage){
+        if (!enabled)
+            return;
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        samples[next][stage] += elapsed(last, now);
+        last = now;
+    }
+
+    /**
+     * Finish timing a tick and move on to the next slot in the window.
+     */
+    inline void end(){
+        if (!enabled)
+            return;
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        samples[next][STAGE_TOTAL] = elapsed(tickStart, now);
+        next = (next + 1) % PROFILE_WINDOW;
+        if (filled < PROFILE_WINDOW)
+            filled++;
+    }
+
+    int numSamples() const;
+    bool summarize(STAGE stage, StageSummary& summary) const;
+
+    static const char* stageName(STAGE stage);
+
+private:
+    static inline int64_t elapsed(const timespec& from, const timespec& to){
+        return (int64_t)(to.tv_sec - from.tv_sec) * 1000000000LL + (to.tv_nsec - from.tv_nsec);
+    }
+
+    bool enabled;
+    int next;
+    int filled;
+    timespec tickStart;
+    timespec last;
+    int64_t samples[PROFILE_WINDOW][NUM_STAGES];
+};
+
+#endif /* STAGEPROFILER_H_ */
@@ -44,6 +44,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdint.h>
 #include <sys/types.h>
 #include "Singleton.h"
+#include "JointRegistry.h"
 #include "ach.h"
 #include "hubo.h"
 
@@ -71,8 +72,6 @@ private:
     typedef ach_channel_t AchChannel;
     typedef struct hubo_state State;
 
-    static const char *urdf_joint_names[];
-
     AchChannel huboStateChannel;
     State currentReference;
 
@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * StatePublisher.h
+ *
+ * Publishes the robot_state topic from its own thread. The control loop only fills in
+ * a StateSnapshot and wakes the thread; converting it to a message and handing it to
+ * ROS happens here, off the loop. The loop try_locks the snapshot, so if the thread is
+ * still copying the previous one the loop skips a snapshot instead of waiting.
+ */
+
+#ifndef STATEPUBLISHER_H_
+#define STATEPUBLISHER_H_
+
+#include <semaphore.h>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "ros/ros.h"
+#include "maestor/RobotState.h"
+#include "StateSnapshot.h"
+
+class StatePublisher {
+public:
+    // Fetches the names for the current robot. Called from the publisher thread.
+    typedef bool (*LayoutFetcher)(StateLayout&);
+
+    StatePublisher();
+    ~StatePublisher();
+
+    void start(ros::NodeHandle &n, const std::string &topic, LayoutFetcher fetcher);
+    void stop();
+
+    StateSnapshot* claim();
+    void commit();
+
+    int64_t numSkipped();
+
+private:
+    void run();
+    void fill(const StateSnapshot &snapshot);
+
+    boost::thread thread;
+    boost::mutex lock;
+    sem_t ready;
+    bool running;
+
+    StateSnapshot latest;   // Written by the loop under the lock
+    bool fresh;
+    int64_t skipped;        // Snapshots the loop could not take because the lock was busy
+
+    StateSnapshot sending;  // Everything below is only touched by the publisher thread
+    StateLayout layout;
+    LayoutFetcher fetcher;
+    maestor::RobotState msg;
+    ros::Publisher publisher;
+};
+
+#endif /* STATEPUBLISHER_H_ */
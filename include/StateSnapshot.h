@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * StateSnapshot.h
+ *
+ * A copy of the robot state taken by the control loop for the robot_state topic. The
+ * snapshot is plain fixed size arrays so taking one never allocates; the names that go
+ * with the arrays only change when the robot is initialized, so they are kept apart in
+ * a StateLayout and fetched again only when the generation changes.
+ */
+
+#ifndef STATESNAPSHOT_H_
+#define STATESNAPSHOT_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "JointTable.h"
+
+#define STATE_MAX_SENSORS 8
+
+enum FT_FIELD {
+    FT_M_X, FT_M_Y, FT_F_Z, NUM_FT_FIELDS
+};
+
+enum IMU_FIELD {
+    IMU_X_ACCEL, IMU_Y_ACCEL, IMU_Z_ACCEL, IMU_X_ROTAT, IMU_Y_ROTAT, NUM_IMU_FIELDS
+};
+
+struct StateSnapshot {
+    int generation;         // Which initialization of the robot this was taken from
+    int64_t tick;
+    double stamp;           // ROS time the snapshot was taken, in seconds
+
+    int numJoints;
+    double position[JOINT_TABLE_SIZE];
+    double goal[JOINT_TABLE_SIZE];
+    double step[JOINT_TABLE_SIZE];
+    bool enabled[JOINT_TABLE_SIZE];
+
+    int numFT;
+    double ft[STATE_MAX_SENSORS][NUM_FT_FIELDS];
+
+    int numIMU;
+    double imu[STATE_MAX_SENSORS][NUM_IMU_FIELDS];
+
+    bool balancing;
+    double zmp[2];          // Filtered X and Y
+};
+
+struct StateLayout {
+    int generation;
+    std::vector< std::string > joints;
+    std::vector< std::string > ftSensors;
+    std::vector< std::string > imus;
+};
+
+#endif /* STATESNAPSHOT_H_ */
@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * StreamedSource.h
+ *
+ * A trajectory file too big to preload, or a compressed one. A prefetch thread parses or
+ * decodes it ahead of playback into a ring of PREFETCH_BLOCKS blocks of STREAM_BUFFER_SIZE
+ * frames, so memory stays bounded however long the recording is, and the file is never
+ * touched from the loop.
+ *
+ * The loop only takes blocks that are ready. If the prefetch thread falls behind, the
+ * loop holds the last frame it played and counts an underrun rather than waiting. The
+ * trajectory's frame count holds with it, so triggers stay on the frames they were set for.
+ *
+ * The first block is read when the source is opened and kept for good. Playback, and
+ * every restart, begins from it while the prefetch thread reads on from the second, so a
+ * rewind costs nothing on the loop and never starts with an underrun.
+ *
+ * Seeking past the first block sends the prefetch thread to the frame sought through
+ * the file's line index. The loop holds the frame it was playing until that block is in.
+ */
+
+#ifndef STREAMEDSOURCE_H_
+#define STREAMEDSOURCE_H_
+
+#include <semaphore.h>
+#include <stdint.h>
+#include <boost/thread.hpp>
+
+#include "FrameSource.h"
+
+#define PREFETCH_BLOCKS 4
+
+class StreamedSource : public FrameSource {
+public:
+    StreamedSource(FrameReader* file);
+    ~StreamedSource();
+
+    const double* current();
+    bool advance();
+    bool rewind();
+    bool seek(int frame);
+    bool seeking();
+    bool stalled();
+
+    double rate();
+
+    int64_t numUnderruns();
+    static int64_t totalUnderruns();
+
+private:
+    struct Block {
+        vector< double > values;    // count rows of numCols() values
+        int count;                  // 0 marks the end of the file, or an error
+        int generation;             // The rewind this block was read after
+        bool error;
+        string errorMessage;
+    };
+
+    void run();
+    bool ready(int64_t block);
+    bool take();
+    void discard();
+    void release();
+
+    FrameReader* file;              // Only touched by the prefetch thread once it is started
+    boost::thread thread;
+    sem_t wake;                     // Posted by the loop when it frees a block or rewinds
+    bool running;
+
+    Block blocks[PREFETCH_BLOCKS];
+    int64_t head;                   // Next block the loop will take. Written by the loop.
+    int64_t tail;                   // Next block the prefetcher will fill. Written by the prefetcher.
+    int generation;                 // Bumped by every rewind or seek. Written by the loop.
+    int seekTo;                     // The frame the last generation starts at. Written by the loop before bumping generation.
+
+    double _rate;
+
+    vector< double > lead;          // The first block of the file. Never changes once read.
+    int leadCount;
+
+    bool leading;                   // Everything below is only touched by the loop
+    bool holding;
+    int row;
+    bool ended;
+    bool pending;                   // Waiting for the block a seek asked for
+    bool standing;                  // The last advance() did not move on by a frame
+    Frame held;                     // The frame played while no block is ready
+    int64_t underruns;
+
+    static int64_t allUnderruns;
+};
+
+#endif /* STREAMEDSOURCE_H_ */
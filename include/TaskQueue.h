@@ -0,0 +1,76 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * TaskQueue.h
+ *
+ * Hands work from the ROS service threads to the control loop. Service callbacks
+ * wrap whatever touches the robot in a LoopTask and block in call() while the loop
+ * runs it at the start of the next tick.
+ */
+
+#ifndef TASKQUEUE_H_
+#define TASKQUEUE_H_
+
+#include <semaphore.h>
+#include <boost/thread/mutex.hpp>
+
+#include "RingBuffer.h"
+
+#define TASK_QUEUE_SIZE 16
+
+class LoopTask {
+public:
+    LoopTask();
+    virtual ~LoopTask();
+
+    virtual void run()=0;
+
+    void complete();
+    void wait();
+
+private:
+    sem_t done;
+};
+
+class TaskQueue {
+public:
+    TaskQueue();
+    ~TaskQueue();
+
+    bool call(LoopTask& task);
+
+    int runPending();
+    void shutdown();
+
+private:
+    RingBuffer< LoopTask*, TASK_QUEUE_SIZE > pending;
+    boost::mutex producers;     // Only the (non real time) callers ever take this
+    bool closed;
+};
+
+#endif /* TASKQUEUE_H_ */
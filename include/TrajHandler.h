@@ -52,8 +52,6 @@ using std::string;
 #ifndef TRAJHANDLER_H_
 #define TRAJHANDLER_H_
 
-#define WRITE_KEY "WRITE"
-
 class TrajHandler {
 private:
     typedef map< string, Trajectory* > TrajectoryMap;
@@ -65,18 +63,24 @@ public:
     virtual ~TrajHandler();
 
     bool loadTrajectory(const string &name, const string& path, bool read);
+    bool addTrajectory(const string &name, Trajectory* traj, Trajectory*& replaced);
     bool ignoreFrom(const string &name, const string &col);
     bool ignoreAllFrom(const string &name);
     bool unignoreFrom(const string &name, const string &col);
     bool unignoreAllFrom(const string& name);
-    bool extendTrajectory(const string &name, const string &path);
+    bool extendTrajectory(const string &name, FrameSource* source);
     bool setTrigger(const string &traj, int frame, const string &target);
-    void startTrajectory(const string& name);
+    bool loopTrajectory(const string &name, bool loop);
+    bool seekTrajectory(const string &name, int frame);
+    bool setTrajectoryRate(const string &name, double rate);
+    bool startTrajectory(const string& name);
+    void rebindJoints(JointTable& joints);
     void advanceFrame();
 
     bool hasRunning();
     Trajectory* get(const string& name);
-    Trajectory* inRunning(const string& col);
+    Trajectory* inRunning(int row);
+    Trajectory* getWriting();
     const vector< string >& getRunning();
     queue< string >& getCurrentTriggers();
 
@@ -85,12 +89,17 @@ public:
 
 private:
 
-    void addToCache(Trajectory* traj);
-    void removeFromCache(Trajectory* traj);
+    void claimJoints(Trajectory* traj);
+    void releaseJoints(Trajectory* traj);
 
     TrajectoryMap loaded;
-    TrajectoryMap cache;
     vector< string > running;
+
+    // Joint ownership, by row of the joint table. Running read trajectories each own the
+    // rows they drive, so conflicts and lookups are bit and array operations.
+    JointMask owned;
+    Trajectory* owners[JOINT_TABLE_SIZE + 1];
+    Trajectory* writing;    // The running write-enabled trajectory, if any
     queue< string > triggers;
 };
 
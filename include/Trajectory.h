@@ -45,9 +45,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <math.h>
 
 #include "WSVFile.h"
+#include "FrameSource.h"
+#include "JointTable.h"
+#include "TrajectoryRecorder.h"
 
-#define BUFFER_SIZE 1
-#define DEFAULT_HEADER "RHY RHR RHP RKP RAP RAR LHY LHR LHP LKP LAP LAR RSP RSR RSY REP RWY RWR RWP LSP LSR LSY LEP LWY LWR LWP NKY NK1 NK2 WST RF1 RF2 RF3 RF4 RF5 LF1 LF2 LF3 LF4 LF5"
+#define BINARY_EXTENSION ".bin" // Write-enabled trajectories with this extension are recorded in the binary format
+#define MAX_PLAYBACK_RATE 10.0  // Most frames a trajectory may be played per tick
+#define END_PASSED -2           // Marks a trajectory that has ended, until its end trigger is handed out
 
 using std::string;
 using std::vector;
@@ -63,6 +67,11 @@ public:
     typedef WSVFile::HeaderMap HeaderMap;
 
     Trajectory(const string &baseFile, bool read);
+
+    /**
+     * Creates a read-only Trajectory playing an already opened source. The Trajectory takes ownership of it.
+     */
+    Trajectory(FrameSource* source);
     ~Trajectory();
 
     /**
@@ -78,7 +87,13 @@ public:
     bool extendTrajectory(const string &filename);
 
     /**
-     * Returns the first value in the first WSVFile associated with this Trajectory for column 'joint' if available.
+     * As above, for a source that has already been opened, so that the file can be parsed away from the control loop.
+     * The Trajectory takes ownership of the source on success, but not on failure.
+     */
+    bool extendTrajectory(FrameSource* source);
+
+    /**
+     * Returns the first value in the first source associated with this Trajectory for column 'joint' if available.
      * Will mark the Trajectory as closed and return 0 on any error. (This will not close the file.)
      */
     double startPosition(const string &joint);
@@ -86,9 +101,9 @@ public:
     /**
      * Accesses the position at the current frame in this Trajectory.
      * In read-only Trajectories, the value for column 'joint' at the current frame is placed in position if available.
-     * In write-enabled Trajectories, the value of 'position' is written to the buffer in column 'joint'.
+     * In write-enabled Trajectories, the value of 'position' is written to the frame being recorded in column 'joint'.
      *
-     * Should the Trajectory be errored in any way, or if the current frame does not exist in the buffer, this method will return false.
+     * Should the Trajectory be errored in any way, or if there is no current frame, this method will return false.
      *
      * @param joint: joint to query next position from
      * @param position: location to store the next position. Will not be modified if failed read.
@@ -97,20 +112,45 @@ public:
     bool nextPosition(const string &joint, double& position);
 
     /**
-     * Advances to the next "frame" in the WSVFile buffer.
-     * In write-enabled Trajectories, a new frame is added to the buffer for writing.
+     * As above, for the joint in row 'row' of the joint table given to bindJoints(). This is one array read, so it is what the loop uses.
+     */
+    bool nextPosition(int row, double& position);
+
+    /**
+     * Works out, for every row of the joint table, which column drives that joint, or that none does.
+     * Called when the Trajectory is started. The mapping is redone by the Trajectory itself whenever
+     * it moves on to another source, is reset, or has a joint disabled or enabled.
+     */
+    void bindJoints(JointTable& joints);
+
+    /**
+     * Advances to the next "frame" of the Trajectory.
+     * In write-enabled Trajectories, the frame that was filled in is handed to the recorder and a new one is started.
      *
-     * In read-enabled Trajectories, should the buffer be exhausted, a new one is loaded from the file.
-     * In write-enabled Trajectories, should the buffer be full, the buffer is written to the file and cleared. A new frame is added to the new buffer.
+     * In read-enabled Trajectories, should the current source be exhausted, playback moves on to the next one.
+     * Read-enabled Trajectories move on by their playback rate, which may land between frames or pass over several.
      */
     bool advanceFrame();
 
     /**
      * Returns whether this trajectory can be read from (Whether advanceFrame() or nextPosition() will do anything, pretty much)
      * This can be fixed by reset()
+     * A finished recording is not open until the recorder has written it out and opened it for reading.
      */
     bool is_open();
 
+    /**
+     * Makes a read-only Trajectory start over from its first frame instead of ending, for cyclic motions.
+     * The last frame has to be consistent with the first (to within .01 rad), as for extendTrajectory().
+     * @return false if the Trajectory cannot loop
+     */
+    bool setLooping(bool loop);
+
+    /**
+     * Returns whether the Trajectory starts over when it reaches its end.
+     */
+    bool isLooping();
+
     /**
      * Returns whether this trajectory has been opened for reading.
      */
@@ -123,6 +163,29 @@ public:
 
     int getFrame();
 
+    /**
+     * Moves a read-only Trajectory to frame 'frame', counted across all of its sources as getFrame() and triggers count them.
+     * Nothing before the frame is read. A streamed source reads the frame on its prefetch thread; until it has,
+     * seeking() is true and the frame that was playing is held.
+     * @return false if there is no such frame
+     */
+    bool seek(int frame);
+
+    /**
+     * Returns whether the frame last sought has yet to be read.
+     */
+    bool seeking();
+
+    /**
+     * Sets how many frames a read-only Trajectory moves on by each tick: 1 plays it as recorded, .5 at half speed,
+     * 2 at double speed, 0 holds it where it is. Between frames, positions are interpolated linearly.
+     * Takes effect from the next tick, so it can be changed while the Trajectory runs.
+     * @return false if the rate is not between 0 and MAX_PLAYBACK_RATE
+     */
+    bool setRate(double rate);
+
+    double getRate();
+
     /**
      * Associates the start of another trajectory with name 'target' with frame 'frame'
      */
@@ -131,6 +194,8 @@ public:
     /**
      * Fills 'target' with the name of the trajectory associated with the current frame, if it exists.
      * If such an association exists, returns true.
+     * Frames passed over since the last call, when playing faster than a frame a tick, count as well;
+     * call until it returns false to get every trigger.
      */
     bool getTrigger (string &target);
 
@@ -140,6 +205,21 @@ public:
      */
     bool contains(const string &joint);
 
+    /**
+     * As above, for the joint in row 'row' of the joint table given to bindJoints().
+     */
+    bool contains(int row);
+
+    /**
+     * Returns the rows of the bound joint table that this trajectory drives (or records).
+     */
+    const JointMask& getJoints();
+
+    /**
+     * Returns the column driving row 'row' of the bound joint table, or -1.
+     */
+    int column(int row);
+
     /**
      * Adds 'joint' to the set of columns which should be ignored.
      * Has no effect if 'joint' is already in the set of columns which are ignored.
@@ -154,44 +234,99 @@ public:
 
     /**
      * Returns this Trajectory to its initial state. Does not clear errors. (If this trajectory had an error for any reason, this will not fix it.)
-     * For write-enabled Trajectories, this will write the remaining buffer to the file, close it, and re-open the trajectory as a read-only Trajectory.
+     * For write-enabled Trajectories, this will finish the recording and turn the trajectory into a read-only Trajectory.
+     * The recorder writes out and re-opens the file on its own thread; until it has, is_open() returns false.
      */
     bool reset();
 
     /**
-     * Manually sets the header for the WSVFile. This will determine the number of columns in the file.
-     * Only works in write-enabled Trajectories.
+     * Manually sets the header for the recording, and starts it. This will determine the number of columns in the file.
+     * Only works in write-enabled Trajectories, once.
      */
     void setHeader(const string &header);
 
     /**
-     * Manually sets the header for the WSVFile. This will determine the number of columns in the file.
-     * Only works in write-enabled Trajectories.
+     * Manually sets the header for the recording, and starts it. This will determine the number of columns in the file.
+     * Only works in write-enabled Trajectories, once.
      */
     void setHeader(const Header &header);
 
     /**
-     * Returns the header of the current WSVFile. (This is not guaranteed to always be the same, but it is guaranteed to always have the same members.
+     * Returns the header of the current source (or of the recording). (This is not guaranteed to always be the same, but it is guaranteed to always have the same members.
      */
     const Header& getHeader();
 
 private:
 
     /**
-     * Adds another 'frame' (array of values) to the WSVFile write-buffer
-     * Only works in write-enabled Trajectories.
+     * Fills a column map for each source, or one for the file being written, and switches to the current one.
      */
-    void prepareFrame();
+    void mapColumns();
 
-    vector< WSVFile* > files; // Sequential list of WSVFiles which make up the trajectory
+    /**
+     * Switches to the column map of the current source. Nothing is looked up, so playback can cross sources on the loop.
+     */
+    void useColumns();
+
+    /**
+     * Picks up a finished recording, once the recorder has opened it for reading.
+     */
+    void collectRecording();
+
+    /**
+     * Whether the first frame of the trajectory follows on from the last frame of source 'last'.
+     */
+    bool closesLoop(FrameSource* last);
+
+    /**
+     * Moves a read trajectory on by exactly one frame, to the next source or back to the first as needed.
+     */
+    bool step();
+    void owe();
+
+    /**
+     * Rearranges 'previous' from the columns of source 'last' to those of the current source.
+     */
+    void carry(FrameSource* last);
+
+    /**
+     * The position of column 'col' of the current source at the current point of playback.
+     */
+    double at(const double* to, int col);
+
+    vector< FrameSource* > sources; // Sequential list of sources which make up a read trajectory
+    TrajectoryRecorder* recorder; // Records a write-enabled trajectory, until the recording is collected
+    Header recordHeader; // The columns being recorded
+    HeaderMap recordColumns;
+    double* recordFrame; // The frame being recorded this tick
+    string path; // The file the trajectory was created from
+    Header noHeader; // Returned by getHeader() when there is no file to take a header from
     set< string > disabledJoints; // Set of joints which, for all intents and purposes, are not in this trajectory (even if they are in the header)
     map< int, string > triggers; // Association between frames of a trajectory and the start of another trajectory
-    int bufferIndex;
     int frame;
-    int currentWSV;
+    int currentSource;
+    int passed;                 // The last frame whose triggers have been handed out
+    int owedFrom;               // Triggers on frames in (owedFrom, owedTo], stepped over this tick before the
+    int owedTo;                 // trajectory ended or started over, are still to be handed out
+
+    double rate;                // Frames moved on by each tick
+    double lag;                 // How far, in frames, playback is short of the current frame
+    Frame previous;             // The frame before the current one, in the current source's columns, while lag > 0
+    Frame scratch;
+
+    struct ColumnMap {
+        int columns[JOINT_TABLE_SIZE + 1]; // Column driving each row of the joint table, or -1
+        JointMask mask; // The rows with a column
+    };
+
+    JointTable* joints; // The joint table the columns are mapped for, once started
+    vector< ColumnMap > maps; // One per source, or one for the file being written, once bound to a joint table
+    ColumnMap unmapped; // Used when the current source has no map
+    ColumnMap* mapped; // The map for the current source
 
     bool open;
     bool read;
+    bool looping;
 
 };
 
@@ -0,0 +1,128 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * TrajectoryRecorder.h
+ *
+ * Records a write-enabled trajectory without doing any I/O on the loop. The loop fills
+ * in frames in place in a single producer / single consumer ring, and a writer thread
+ * drains the ring to the file in batches, as text or in the binary or compressed format. If the disk
+ * falls so far behind that the ring fills, frames are dropped and counted rather than
+ * waited for.
+ *
+ * When recording finishes, the writer thread closes the file and opens it again for
+ * reading, so that the trajectory can be played back without parsing it on the loop.
+ */
+
+#ifndef TRAJECTORYRECORDER_H_
+#define TRAJECTORYRECORDER_H_
+
+#include <stdint.h>
+#include <boost/thread.hpp>
+
+#include "RingBuffer.h"
+#include "JointTable.h"
+#include "FrameSource.h"
+#include "BinaryTrajectory.h"
+#include "CompressedTrajectory.h"
+
+#define RECORD_RING_SIZE 1024           // Frames, about 5 seconds at 200 Hz. Must be a power of two.
+#define RECORD_MAX_COLUMNS JOINT_TABLE_SIZE
+#define RECORD_DRAIN_PERIOD_US 10000
+#define RECORD_RATE 200.0               // One frame is recorded per tick of the loop
+#define RETIRED_RING_SIZE 16            // Finished recorders waiting to be deleted off the loop. Must be a power of two.
+
+class TrajectoryRecorder {
+public:
+    enum Format { TEXT, BINARY, COMPRESSED };
+
+    TrajectoryRecorder(const string &path, Format format);
+    ~TrajectoryRecorder();
+
+    bool begin(const vector< string > &columns);
+    double* next();
+    void commit();
+    void finish();
+
+    FrameSource* takeRecording();
+    bool failed();
+
+    int64_t numDropped();
+    static int64_t totalDropped();
+
+    static void retire(TrajectoryRecorder* recorder);
+    static int reap();
+
+private:
+    struct RecordedFrame {
+        double values[RECORD_MAX_COLUMNS];
+    };
+
+    void run();
+    bool openFile();
+    void drain();
+    bool closeFile();
+
+    string path;
+    Format format;
+    boost::thread thread;
+    volatile bool running;
+
+    // Set by the loop, read by the writer thread
+    vector< string > columns;
+    volatile bool begun;
+    volatile bool finishing;
+
+    // Loop side only
+    RingBuffer< RecordedFrame, RECORD_RING_SIZE > ring;
+    RecordedFrame scratch;      // Filled in when the ring is full, and thrown away
+    double* current;
+    bool claimed;
+    int width;
+
+    // Counted by the loop, reported by the writer thread. Only touched atomically.
+    int64_t dropped;
+
+    // Set by the writer thread, read by the loop
+    FrameSource* recording;
+    volatile bool done;
+    volatile bool error;
+
+    // Writer thread only
+    FILE* text;
+    BinaryTrajectoryWriter writer;
+    CompressedTrajectoryWriter compressed;
+    int64_t reported;
+
+    static int64_t allDropped;
+
+    // Loop side pushes, service threads pop
+    static RingBuffer< TrajectoryRecorder*, RETIRED_RING_SIZE > retired;
+    static boost::mutex reaping;
+};
+
+#endif /* TRAJECTORYRECORDER_H_ */
@@ -42,6 +42,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <vector>
 #include <map>
 
+#include "FrameReader.h"
+
 #define DEBUG 0
 
 using std::map;
@@ -54,10 +56,11 @@ using std::stringstream;
 using std::ostringstream;
 
 #define WRITE_WHITESPACE '\t'
+#define INDEX_STRIDE 256    // Data lines between the offsets kept for seek()
 
 // Whitespace Separated Value file reader class.
 // Whitespace is defined by the C++ isspace() function: ' \t\n\r\f\v'
-class WSVFile {
+class WSVFile : public FrameReader {
 private:
     enum TrajLineType { DATA, COMMENT, BLANK };
 
@@ -112,6 +115,14 @@ public:
      */
     void reset();
 
+    /**
+     * Moves to data line 'line' (counted from 0), so that the next loadBuffer() starts with it.
+     * The offset of every INDEX_STRIDE-th data line is noted when the statistics are compiled, so this
+     * skips at most INDEX_STRIDE - 1 lines, without parsing them, whatever the size of the file.
+     * Only works in readable files. Returns false if there is no such line.
+     */
+    bool seek(int line);
+
 
     bool errored();
 
@@ -141,11 +152,34 @@ public:
 
     Frame& end();
 
+    /**
+     * Formats a value for writing with as few digits as will read back as the same double.
+     * Returns 'text', which must hold at least 32 characters.
+     */
+    static const char* format_value(double value, char* text, int size);
+
 
 private:
 
     bool is_numeric(const string& str);
 
+    /**
+     * Finds the next whitespace separated field of a line, starting at 'p'.
+     * On success, [start, end) is the field and 'p' is left just past it.
+     */
+    static bool next_field(const char*& p, const char*& start, const char*& end);
+
+    /**
+     * Parses the field [start, end) as a number. The whole field has to be the number.
+     */
+    static bool to_double(const char* start, const char* end, double& value);
+
+    /**
+     * Parses every field of a data line into 'values', which is reused so that it does not allocate once it has grown.
+     * Returns the number of fields, and sets 'badField' to the first one that is not a number, or -1.
+     */
+    int parse_line(const string& line, Frame& values, int& badField);
+
     /**
      * Determines, from the content of the current line, what type it is.
      * Classifies lines as either blank, a comment, or data
@@ -187,6 +221,12 @@ private:
     Frame _start;                   // Note the assumption that all values in the WSV file will be floating point numbers.
     Frame _end;                     // Note the assumption that all values in the WSV file will be floating point numbers.
 
+    /**  Scratch space for loadBuffer  */
+    string _line;
+
+    /**  Byte offsets of data lines 0, INDEX_STRIDE, 2 * INDEX_STRIDE...  */
+    vector< std::streamoff > _index;
+
 };
 
 #endif
@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <unistd.h>
 
 #include "ros/ros.h"
+#include "ros/callback_queue.h"
 #include "std_msgs/String.h"
 #include <iostream>
 #include <sstream>
@@ -38,6 +39,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <math.h>
 
 #include "Scheduler.h"
+#include "TaskQueue.h"
+#include "SetpointMailbox.h"
+#include "StatePublisher.h"
+#include "LoopLog.h"
+#include "StreamedSource.h"
+#include "FrameCache.h"
 #include "servTest.h"
 #include "RobotControl.h"
 #include "maestor/initRobot.h"
@@ -51,10 +58,24 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "maestor/unignoreFrom.h"
 #include "maestor/unignoreAllFrom.h"
 #include "maestor/setTrigger.h"
+#include "maestor/loopTrajectory.h"
 #include "maestor/extendTrajectory.h"
 #include "maestor/startTrajectory.h"
 #include "maestor/stopTrajectory.h"
+#include "maestor/seekTrajectory.h"
+#include "maestor/startTrajectoryAt.h"
+#include "maestor/setTrajectoryRate.h"
 #include "maestor/setProperty.h"
+#include "maestor/getTimingStats.h"
+#include "maestor/getStageTimes.h"
+#include "maestor/resolveHandles.h"
+#include "maestor/setByHandle.h"
+#include "maestor/getByHandle.h"
+#include "maestor/setPropertiesBatch.h"
+#include "maestor/Setpoints.h"
+#include "maestor/waitForMotion.h"
+
+#define START_AT_TIMEOUT_NS 1000000000     // Longest startTrajectoryAt waits for the frame to be read
 
 using ros::NodeHandle;
 using ros::ServiceServer;
@@ -68,6 +89,7 @@ using std::endl;
 bool initRobot(maestor::initRobot::Request &req, maestor::initRobot::Response &res);
 
 bool setProperties(maestor::setProperties::Request &req, maestor::setProperties::Response &res);
+bool setPropertiesBatch(maestor::setPropertiesBatch::Request &req, maestor::setPropertiesBatch::Response &res);
 
 // Control Commands
 bool command(maestor::command::Request &req, maestor::command::Response &res);
@@ -76,6 +98,7 @@ bool command(maestor::command::Request &req, maestor::command::Response &res);
 // Feedback Commands
 bool requiresMotion(maestor::requiresMotion::Request &req, maestor::requiresMotion::Response &res);
 bool getProperties(maestor::getProperties::Request &req, maestor::getProperties::Response &res);
+bool waitForMotion(maestor::waitForMotion::Request &req, maestor::waitForMotion::Response &res);
 
 // Trajectory Commands
 bool loadTrajectory(maestor::loadTrajectory::Request &req, maestor::loadTrajectory::Response &res);
@@ -84,7 +107,30 @@ bool ignoreAllFrom(maestor::ignoreAllFrom::Request &req, maestor::ignoreAllFrom:
 bool unignoreFrom(maestor::unignoreFrom::Request &req, maestor::unignoreFrom::Response &res);
 bool unignoreAllFrom(maestor::unignoreAllFrom::Request &req, maestor::unignoreAllFrom::Response &res);
 bool setTrigger(maestor::setTrigger::Request &req, maestor::setTrigger::Response &res);
+bool loopTrajectory(maestor::loopTrajectory::Request &req, maestor::loopTrajectory::Response &res);
 bool extendTrajectory(maestor::extendTrajectory::Request &req, maestor::extendTrajectory::Response &res);
 bool startTrajectory(maestor::startTrajectory::Request &req, maestor::startTrajectory::Response &res);
 bool stopTrajectory(maestor::stopTrajectory::Request &req, maestor::stopTrajectory::Response &res);
+bool seekTrajectory(maestor::seekTrajectory::Request &req, maestor::seekTrajectory::Response &res);
+bool startTrajectoryAt(maestor::startTrajectoryAt::Request &req, maestor::startTrajectoryAt::Response &res);
+bool setTrajectoryRate(maestor::setTrajectoryRate::Request &req, maestor::setTrajectoryRate::Response &res);
 bool setProperty(maestor::setProperty::Request &req, maestor::setProperty::Response &res);
+
+// Handle Commands
+bool resolveHandles(maestor::resolveHandles::Request &req, maestor::resolveHandles::Response &res);
+bool setByHandle(maestor::setByHandle::Request &req, maestor::setByHandle::Response &res);
+bool getByHandle(maestor::getByHandle::Request &req, maestor::getByHandle::Response &res);
+
+// Streamed setpoints
+void onSetpoints(const maestor::Setpoints::ConstPtr &msg);
+void applySetpoints();
+
+// Robot state topic
+void publishState(int64_t tick);
+bool fetchStateLayout(StateLayout &layout);
+
+// Diagnostics
+bool getTimingStats(maestor::getTimingStats::Request &req, maestor::getTimingStats::Response &res);
+bool snapshotTimingStats(TimingStats &stats, bool reset);
+void printTimingSummary(const ros::WallTimerEvent &event);
+bool getStageTimes(maestor::getStageTimes::Request &req, maestor::getStageTimes::Response &res);
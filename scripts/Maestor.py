@@ -4,6 +4,7 @@ import sys
 import subprocess
 import time
 from maestor.srv import *
+from maestor.msg import Setpoints, RobotState
 
 class maestor:
 
@@ -20,11 +21,17 @@ class maestor:
         rospy.wait_for_service("unignoreFrom")
         rospy.wait_for_service("unignoreAllFrom")
         rospy.wait_for_service("setTrigger")
+        rospy.wait_for_service("loopTrajectory")
         rospy.wait_for_service("extendTrajectory")
         rospy.wait_for_service("startTrajectory")
         rospy.wait_for_service("stopTrajectory")
+        rospy.wait_for_service("seekTrajectory")
+        rospy.wait_for_service("startTrajectoryAt")
+        rospy.wait_for_service("setTrajectoryRate")
         rospy.wait_for_service("setProperty")
+        rospy.wait_for_service("waitForMotion")
         self.shouldWait = False
+        self.setpointPublisher = rospy.Publisher("setpoints", Setpoints, tcp_nodelay=True)
         print "All services are available"
     
     def initRobot(self, path):
@@ -47,6 +54,20 @@ class maestor:
         except rospy.ServiceException, e:
             print "Service call failed: %s"%e
 
+    def setPropertiesBatch(self, names, properties, values):
+        #Same as setProperties, but takes lists instead of
+        # space separated strings
+        try:
+            service = rospy.ServiceProxy("setPropertiesBatch", setPropertiesBatch)
+            res = service(names, properties, values)
+
+            if self.shouldWait:
+                self.waitForJointList(names)
+
+            return res.success
+        except rospy.ServiceException, e:
+            print "Service call failed: %s"%e
+
     def setProperty(self, name, prop, value):
         try:
             service = rospy.ServiceProxy("setProperty", setProperty)
@@ -129,6 +150,14 @@ class maestor:
         except rospy.ServiceException, e:
             print "Service call failed: %s"%e
 
+    def loopTrajectory(self, name, loop=True):
+        try:
+            service = rospy.ServiceProxy("loopTrajectory", loopTrajectory)
+            res = service(name, loop)
+            return res.success
+        except rospy.ServiceException, e:
+            print "Service call failed: %s"%e
+
     def extendTrajectory(self, name, path):
         try:
             service = rospy.ServiceProxy("extendTrajectory", extendTrajectory)
@@ -150,15 +179,102 @@ class maestor:
         except rospy.ServiceException, e:
             print "Service call failed: %s"%e
 
+    def seekTrajectory(self, name, frame):
+        try:
+            service = rospy.ServiceProxy("seekTrajectory", seekTrajectory)
+            res = service(name, frame)
+            return res.success
+        except rospy.ServiceException, e:
+            print "Service call failed: %s"%e
+
+    def startTrajectoryAt(self, name, frame):
+        try:
+            service = rospy.ServiceProxy("startTrajectoryAt", startTrajectoryAt)
+            res = service(name, frame)
+            return res.success
+        except rospy.ServiceException, e:
+            print "Service call failed: %s"%e
+
+    def setTrajectoryRate(self, name, rate):
+        try:
+            service = rospy.ServiceProxy("setTrajectoryRate", setTrajectoryRate)
+            res = service(name, rate)
+            return res.success
+        except rospy.ServiceException, e:
+            print "Service call failed: %s"%e
+
+    def getStageTimes(self, reset=False):
+        #Per stage timing of the update loop in microseconds. Turn
+        # profiling on first with command("ProfileOn", "")
+        try:
+            service = rospy.ServiceProxy("getStageTimes", getStageTimes)
+            return service(reset)
+        except rospy.ServiceException, e:
+            print "Service call failed: %s"%e
+
+    def resolveHandles(self, names, properties):
+        #Look up lists of joint names and properties once. The
+        # handles can then be used with setByHandle and getByHandle
+        try:
+            service = rospy.ServiceProxy("resolveHandles", resolveHandles)
+            res = service(names, properties)
+            return res.handles
+        except rospy.ServiceException, e:
+            print "Service call failed: %s"%e
+
+    def setByHandle(self, handles, values):
+        try:
+            service = rospy.ServiceProxy("setByHandle", setByHandle)
+            res = service(handles, values)
+            return res.success
+        except rospy.ServiceException, e:
+            print "Service call failed: %s"%e
+
+    def getByHandle(self, handles):
+        try:
+            service = rospy.ServiceProxy("getByHandle", getByHandle)
+            res = service(handles)
+            return res.values
+        except rospy.ServiceException, e:
+            print "Service call failed: %s"%e
+
+    def streamSetpoints(self, handles, values):
+        #Publish goals for handles from resolveHandles without a service
+        # call. Meant to be called at up to the loop rate; MAESTOR only
+        # applies the newest message it has received
+        msg = Setpoints()
+        msg.header.stamp = rospy.Time.now()
+        msg.handles = handles
+        msg.values = values
+        self.setpointPublisher.publish(msg)
+
+    def getRobotState(self, timeout=None):
+        #Get the next message on robot_state. It has the position,
+        # goal and step of every motor, the sensors and the ZMP
+        try:
+            return rospy.wait_for_message("robot_state", RobotState, timeout)
+        except rospy.ROSException, e:
+            print "No robot state received: %s"%e
+
+    def waitForMotion(self, names, tolerance=0, timeout=0):
+        #Block until every joint in names is at its goal. MAESTOR
+        # answers within a tick of them arriving. A tolerance of 0 uses
+        # the requiresMotion tolerance and a timeout of 0 never times out.
+        # Returns False if it timed out
+        try:
+            service = rospy.ServiceProxy("waitForMotion", waitForMotion)
+            res = service(names, tolerance, timeout)
+            return res.arrived
+        except rospy.ServiceException, e:
+            print "Service call failed: %s"%e
+
     def waitForJoint(self, name):
-        while self.requiresMotion(name):
-            pass
+        self.waitForMotion([name])
 
     def waitForJointList(self, jointList):
         #Wait for a list of joints, each element of the list 
         # must be a string
-        for joint in jointList:
-            self.waitForJoint(joint)
+        self.waitForMotion(jointList)
 
     def defaultWaitForJoint(self, shouldWait=False):
         #If should wait becomes true, make it so that 
@@ -8,10 +8,11 @@
 
 /**
  * Create the meta joint by giving it a meta joint controller
+ * @param controller The controller this metajoint is a parameter of
+ * @param table      The joint table to keep the metajoint's goal and step in
  */
-ArmMetaJoint::ArmMetaJoint(MetaJointController* controller): MetaJoint(controller){
+ArmMetaJoint::ArmMetaJoint(MetaJointController* controller, JointTable& table): MetaJoint(controller, table){
     this->controller = controller;
-    currGoal = 0.0;
 }
 
 /**
@@ -5,6 +5,7 @@
  */
 
 #include "../include/ArmWristXYZ.h"
+#include "../include/LoopLog.h"
 
 const int ArmWristXYZ::NUM_PARAMETERS = 3;
 const int ArmWristXYZ::NUM_CONTROLLED = 4;
@@ -99,7 +100,7 @@ void ArmWristXYZ::setInverse(){
     double L = sqrt(LOWER_ARM_X*LOWER_ARM_X + UPPER_ARM_Z*UPPER_ARM_Z);          //Length of the lower arm
 
     if(radius > L + U || radius < ARM_MIN_REACH){
-        cout << "Error: Position is out of arm's reach" << endl;
+        LOOP_LOG(LOG_ERROR, "Error: Position is out of arm's reach");
         unsetAll();
         return;
     }
@@ -131,14 +132,14 @@ void ArmWristXYZ::setInverse(){
 
     // Not entirely sure if this check is necessary
     if(isnan(shoulder_pitch) || isnan(shoulder_roll) || isnan(elbow_pitch)){
-        cout << "Error: inverse solver returned NaN" << endl;
+        LOOP_LOG(LOG_ERROR, "Error: inverse solver returned NaN");
         unsetAll();
         return;
     }
 
     // Check that joint angles are within limits
     if(shoulder_roll > SHOULDER_ROLL_UPPER || shoulder_roll < SHOULDER_ROLL_LOWER || shoulder_pitch > SHOULDER_PITCH_UPPER || shoulder_pitch < SHOULDER_PITCH_LOWER || elbow_pitch > ELBOW_PITCH_UPPER || elbow_pitch < ELBOW_PITCH_LOWER){
-        cout << "Error: One or more joints out of joint limits" << endl;
+        LOOP_LOG(LOG_ERROR, "Error: One or more joints out of joint limits");
         unsetAll();
         return;
     }
@@ -167,7 +168,7 @@ void ArmWristXYZ::checkGoalsReached(){
             return;
         }
     }
-    cout << "Joints set set to false" << endl;
+    LOOP_LOG(LOG_INFO, "Joints set set to false");
     jointsSet = false;
     goalsReached();
 }
@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * but it gets the job done. If I can I will try to clean it up in the future. 
  */
 #include "BalanceController.h"
+#include "LoopLog.h"
 
 /**
  * Create a balance controller
@@ -42,16 +43,22 @@ BalanceController::BalanceController(){
     dampingGain[2] = 0.4f;      dampingGain[5] = 0.5f;
 
     initialized = false;
-
-    balanceComponents[0] = "RFX"; 
-    balanceComponents[2] = "RFY"; 
-    balanceComponents[1] = "RFZ"; 
-    balanceComponents[3] = "LFX"; 
-    balanceComponents[4] = "LFY"; 
-    balanceComponents[5] = "LFZ"; 
-    balanceComponents[6] = "RAT"; 
-    balanceComponents[7] = "LAT"; 
-    balanceComponents[8] = "IMU"; 
+    for (int i = 0; i < 6; i++){
+        zmp[i] = 0;
+        filteredZMP[i] = 0;
+    }
+
+    balanceComponents[BAL_RFX] = "RFX"; 
+    balanceComponents[BAL_RFY] = "RFY"; 
+    balanceComponents[BAL_RFZ] = "RFZ"; 
+    balanceComponents[BAL_LFX] = "LFX"; 
+    balanceComponents[BAL_LFY] = "LFY"; 
+    balanceComponents[BAL_LFZ] = "LFZ"; 
+    balanceComponents[BAL_RAT] = "RAT"; 
+    balanceComponents[BAL_LAT] = "LAT"; 
+    balanceComponents[BAL_IMU] = "IMU"; 
+    for (int i = 0; i < NUM_BALANCE_COMPONENTS; i++)
+        components[i] = NULL;
 
 }
 
@@ -70,17 +77,17 @@ void BalanceController::Balance(){
     DSPControl();
     DampingControl();
 
-    setOffset("RFX", ControlDSP[0][0]);
-    setOffset("RFY", ControlDSP[0][1]);
-    setOffset("LFX", ControlDSP[1][0]);
-    setOffset("LFY", ControlDSP[1][1]);
+    setOffset(BAL_RFX, ControlDSP[0][0]);
+    setOffset(BAL_RFY, ControlDSP[0][1]);
+    setOffset(BAL_LFX, ControlDSP[1][0]);
+    setOffset(BAL_LFY, ControlDSP[1][1]);
     //Active balance attempt
     //If the joint does not require motion then we can set it's new goal as the current position plus 
     //the offset. 
-    double RFx = BalanceController::get("RFX", "position"); 
-    double RFy = BalanceController::get("RFY", "position");
-    double LFx = BalanceController::get("LFX", "position");
-    double LFy = BalanceController::get("LFY", "position");
+    double RFx = BalanceController::get(BAL_RFX, POSITION); 
+    double RFy = BalanceController::get(BAL_RFY, POSITION);
+    double LFx = BalanceController::get(BAL_LFX, POSITION);
+    double LFy = BalanceController::get(BAL_LFY, POSITION);
     //rounded offsets and adjusted 
     double Rx = (-1 * floor(ControlDSP[0][0]*1000) / 1000) - BaseDSP[0][0]; 
     double Ry = (-1 * floor(ControlDSP[0][1]*1000) / 1000) - BaseDSP[0][1];
@@ -107,17 +114,17 @@ void BalanceController::Balance(){
     double Lxpos = LFx + Lx;
     double Lypos = LFy + Ly;
 
-    if(!requiresMotion("RFX") && fabs(Rx) > .005){
-        BalanceController::set("RFX", "position", Rxpos);
+    if(!requiresMotion(BAL_RFX) && fabs(Rx) > .005){
+        BalanceController::set(BAL_RFX, POSITION, Rxpos);
     }
-    if(!requiresMotion("RFY") && fabs(Ry) > .005){
-        BalanceController::set("RFY", "position", Rypos);
+    if(!requiresMotion(BAL_RFY) && fabs(Ry) > .005){
+        BalanceController::set(BAL_RFY, POSITION, Rypos);
     }
-    if(!requiresMotion("LFX") && fabs(Lx) > .005){
-        BalanceController::set("LFX", "position", Lxpos);
+    if(!requiresMotion(BAL_LFX) && fabs(Lx) > .005){
+        BalanceController::set(BAL_LFX, POSITION, Lxpos);
     }
-    if(!requiresMotion("LFY") && fabs(Ly) > .005){
-        BalanceController::set("LFY", "position", Lypos);
+    if(!requiresMotion(BAL_LFY) && fabs(Ly) > .005){
+        BalanceController::set(BAL_LFY, POSITION, Lypos);
     }
 }
 
@@ -146,13 +153,13 @@ void BalanceController::initBalanceController(HuboState& theState){
     state = &theState; 
     if(state == NULL)
     {
-        cout << "Error initializing the Balance Controller, the state was never initalized." << endl;
+        LOOP_LOG(LOG_ERROR, "Error initializing the Balance Controller, the state was never initalized.");
         return; 
     }
     initialized = allComponentsFound(); // Check to see if the hubo state has all of the needed components
 
     if(!initialized){
-        cout << "Error initializing the Balance Controller, Not all of the components needed to balance were found." << endl;
+        LOOP_LOG(LOG_ERROR, "Error initializing the Balance Controller, Not all of the components needed to balance were found.");
         return;
     }
 
@@ -165,14 +172,16 @@ void BalanceController::initBalanceController(HuboState& theState){
  * @return True if all names existed. 
  */
 bool BalanceController::allComponentsFound(){
-    for(int i = 0; i < 9; i++)
+    bool found = true;
+    for(int i = 0; i < NUM_BALANCE_COMPONENTS; i++)
     {
-        if(!state->nameExists(balanceComponents[i])) //If the name does not exist
+        components[i] = state->getComponent(balanceComponents[i]);
+        if(components[i] == NULL) //If the name does not exist
         {
-            return false;
+            found = false;
         }
     }
-    return true; // All names existed
+    return found; // All names existed
 }
 
 /**
@@ -205,18 +214,18 @@ void BalanceController::ZMPcalculation(){
     double pelvis_width = 0.177;
     double alpha = 0.1570796; //alpha  2.0*PI*5.0f*5/1000.0
     
-    double Rx = BalanceController::get("RAT", "m_x");
-    double Ry = BalanceController::get("RAT", "m_y");
-    double Rz = BalanceController::get("RAT", "f_z");
-    double Lx = BalanceController::get("LAT", "m_x");
-    double Ly = BalanceController::get("LAT", "m_y");
-    double Lz = BalanceController::get("LAT", "f_z");
-    double RAx = -1 * BalanceController::get("RFX", "position"); 
-    double RAy = -1 * BalanceController::get("RFY", "position");
-    double RAz = BalanceController::get("RFZ", "position");
-    double LAx = -1 * BalanceController::get("LFX", "position");
-    double LAy = -1 * BalanceController::get("LFY", "position");
-    double LAz = BalanceController::get("LFZ", "position");
+    double Rx = BalanceController::get(BAL_RAT, M_X);
+    double Ry = BalanceController::get(BAL_RAT, M_Y);
+    double Rz = BalanceController::get(BAL_RAT, F_Z);
+    double Lx = BalanceController::get(BAL_LAT, M_X);
+    double Ly = BalanceController::get(BAL_LAT, M_Y);
+    double Lz = BalanceController::get(BAL_LAT, F_Z);
+    double RAx = -1 * BalanceController::get(BAL_RFX, POSITION); 
+    double RAy = -1 * BalanceController::get(BAL_RFY, POSITION);
+    double RAz = BalanceController::get(BAL_RFZ, POSITION);
+    double LAx = -1 * BalanceController::get(BAL_LFX, POSITION);
+    double LAy = -1 * BalanceController::get(BAL_LFY, POSITION);
+    double LAz = BalanceController::get(BAL_LFZ, POSITION);
 
     double totalMX;    // total moment in the x
     double totalMY;    // total moment in the y
@@ -269,8 +278,8 @@ void BalanceController::ZMPcalculation(){
  * calculate the current support phase
  */
 void BalanceController::getCurrentSupportPhase(){
-    double Rz = get("RAT", "f_z");
-    double Lz = get("LAT", "f_z");
+    double Rz = get(BAL_RAT, F_Z);
+    double Lz = get(BAL_LAT, F_Z);
 
     if(Rz > 30 && Lz > 30)
     {
@@ -288,77 +297,95 @@ void BalanceController::getCurrentSupportPhase(){
 
 /**
  * Set the offset of a joint to a value
- * @param name   The joint to set the offset on
+ * @param which  The joint to set the offset on
  * @param offset The offset to set
  */
-void BalanceController::setOffset(string name, double offset){
-    if (!state->nameExists(name)){
-        cout << "Error. No component with name " << name << " registered. Aborting." << endl;
+void BalanceController::setOffset(BalanceComponent which, double offset){
+    if (components[which] == NULL){
+        LOOP_LOG(LOG_ERROR, "Error. No component with name %s registered. Aborting.", balanceComponents[which].c_str());
         return;
     }
 
-
-
-    if (!static_cast<MetaJoint*>(state->getComponent(name))->setOffset(offset)){
-        cout << "Error setting offset of component " << name << endl;
+    if (!static_cast<MetaJoint*>(components[which])->setOffset(offset)){
+        LOOP_LOG(LOG_ERROR, "Error setting offset of component %s", balanceComponents[which].c_str());
         return;
     }
 }
 
 /* Code duplication. I know. I should really fix it */
 double BalanceController::get(string name, string property){
-
-    if (!state->nameExists(name)){
-        cout << "Error. No component with name " << name << " registered. Aborting." << endl;
+    RobotComponent* component = state->getComponent(name);
+    if (component == NULL){
+        LOOP_LOG(LOG_ERROR, "Error. No component with name %s registered. Aborting.", name.c_str());
         return 0;
     }
 
-    Properties properties = Names::getProps();
-
-    if (properties.count(property) == 0){
-        cout << "Error. No property with name " << property << " registered. Aborting." << endl;
+    PROPERTY prop;
+    if (!Names::lookup(property, prop)){
+        LOOP_LOG(LOG_ERROR, "Error. No property with name %s registered. Aborting.", property.c_str());
         return 0;
     }
 
     double result = 0;
 
-    if (!state->getComponent(name)->get(properties[property], result)){
-        cout << "Error getting property " << property << " of component " << name << endl;
+    if (!component->get(prop, result)){
+        LOOP_LOG(LOG_ERROR, "Error getting property %s of component %s", property.c_str(), name.c_str());
         return 0;
     }
 
     return result;
 }
-/* More duplication. I know it's bad :( */
-void BalanceController::set(string name, string property, double value){
-    if (!state->nameExists(name)){
-        cout << "Error. No component with name " << name << " registered. Aborting." << endl;
-        return;
+
+/**
+ * Get a property of one of the balance components. Used every tick, so no names are looked up.
+ * @param  which    The balance component
+ * @param  property The property to get
+ * @return          The value, or 0 on error
+ */
+double BalanceController::get(BalanceComponent which, PROPERTY property){
+    if (components[which] == NULL){
+        LOOP_LOG(LOG_ERROR, "Error. No component with name %s registered. Aborting.", balanceComponents[which].c_str());
+        return 0;
     }
 
-    Properties properties = Names::getProps();
+    double result = 0;
+
+    if (!components[which]->get(property, result)){
+        LOOP_LOG(LOG_ERROR, "Error getting property %s of component %s", Names::getName(property), balanceComponents[which].c_str());
+        return 0;
+    }
 
-    if (properties.count(property) == 0){
-        cout << "Error. No property with name " << property << " registered. Aborting." << endl;
+    return result;
+}
+
+/**
+ * Set a property of one of the balance components
+ * @param which    The balance component
+ * @param property The property to set
+ * @param value    The value to set it to
+ */
+void BalanceController::set(BalanceComponent which, PROPERTY property, double value){
+    if (components[which] == NULL){
+        LOOP_LOG(LOG_ERROR, "Error. No component with name %s registered. Aborting.", balanceComponents[which].c_str());
         return;
     }
 
-    if (!state->getComponent(name)->set(properties[property], value)){
-        cout << "Error setting property " << property << " of component " << name << endl;
+    if (!components[which]->set(property, value)){
+        LOOP_LOG(LOG_ERROR, "Error setting property %s of component %s", Names::getName(property), balanceComponents[which].c_str());
         return;
     }
 }
 
 /* just a little more code duplication. I'll try to fix it when I get something to work */
-bool BalanceController::requiresMotion(string name){
-    RobotComponent* component = state->getComponent(name);
+bool BalanceController::requiresMotion(BalanceComponent which){
+    RobotComponent* component = components[which];
     if (component == NULL){
-        cout << "Error retrieving component with name " << name << endl;
+        LOOP_LOG(LOG_ERROR, "Error retrieving component with name %s", balanceComponents[which].c_str());
         return false;
     }
     double step, goal;
     if (!component->get(POSITION, step) || !component->get(GOAL, goal)){
-        cout << "Error retrieving data from component " << name << endl;
+        LOOP_LOG(LOG_ERROR, "Error retrieving data from component %s", balanceComponents[which].c_str());
         return false;
     }
 
@@ -415,10 +442,10 @@ double BalanceController::DampingControl(){
     float gain[6];
     float controlDampCutoff = 1.0f;
 
-    double roll         = get("IMU", "x_rot");  
-    double pitch        = get("IMU", "y_rot");
-    double roll_vel     = get("IMU", "x_acc"); 
-    double pitch_vel    = get("IMU", "y_acc");
+    double roll         = get(BAL_IMU, X_ROTAT);  
+    double pitch        = get(BAL_IMU, Y_ROTAT);
+    double roll_vel     = get(BAL_IMU, X_ACCEL); 
+    double pitch_vel    = get(BAL_IMU, Y_ACCEL);
     double oldDampingAngle[4];
 
     double alpha = 0.0314159;        //2.0f*PI*controlDampCutoff*INT_TIME/1000.0f
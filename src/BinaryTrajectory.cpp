@@ -0,0 +1,175 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * Writing the binary trajectory format.
+ */
+
+#include <string.h>
+
+#include "BinaryTrajectory.h"
+
+/**
+ * Check whether a file is a binary trajectory, by its magic number
+ * @param  path Path to the file
+ * @return      True if it is
+ */
+bool isBinaryTrajectory(const string &path){
+    FILE* in = fopen(path.c_str(), "rb");
+    if (in == NULL)
+        return false;
+
+    char magic[BINARY_TRAJECTORY_MAGIC_SIZE];
+    bool binary = fread(magic, sizeof(magic), 1, in) == 1
+        && memcmp(magic, BINARY_TRAJECTORY_MAGIC, BINARY_TRAJECTORY_MAGIC_SIZE) == 0;
+    fclose(in);
+    return binary;
+}
+
+/**
+ * Create a writer with no file open
+ */
+BinaryTrajectoryWriter::BinaryTrajectoryWriter(){
+    file = NULL;
+    memset(&header, 0, sizeof(header));
+}
+
+/**
+ * Destructor. Finishes the file if it is still open.
+ */
+BinaryTrajectoryWriter::~BinaryTrajectoryWriter(){
+    close();
+}
+
+/**
+ * Create a file and write the header and column names
+ * @param  path      Path to the file. It is truncated if it exists.
+ * @param  columns   The column names
+ * @param  valueSize sizeof(double) or sizeof(float)
+ * @param  rate      Frames per second, or 0 if unknown
+ * @return           True on success
+ */
+bool BinaryTrajectoryWriter::open(const string &path, const vector< string > &columns, int valueSize, double rate){
+    close();
+    if (valueSize != sizeof(double) && valueSize != sizeof(float))
+        return fail("Values must be doubles or floats.");
+    if (columns.empty())
+        return fail("A binary trajectory needs at least one column.");
+
+    this->path = path;
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+        return fail("Unable to open file '" + path + "' for writing.");
+
+    string names;
+    for (int i = 0; i < columns.size(); i++){
+        names += columns[i];
+        names += '\0';
+    }
+    names.resize((names.size() + 7) & ~(size_t)7, '\0');
+
+    memcpy(header.magic, BINARY_TRAJECTORY_MAGIC, BINARY_TRAJECTORY_MAGIC_SIZE);
+    header.version = BINARY_TRAJECTORY_VERSION;
+    header.valueSize = valueSize;
+    header.numCols = columns.size();
+    header.namesSize = names.size();
+    header.numFrames = 0;
+    header.rate = rate;
+    floats.resize(valueSize == sizeof(float) ? columns.size() : 0);
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(names.data(), names.size(), 1, file) != 1)
+        return fail("Unable to write header to '" + path + "'.");
+    return true;
+}
+
+/**
+ * Append a frame
+ * @param  frame One value per column
+ * @return       True on success
+ */
+bool BinaryTrajectoryWriter::write(const double* frame){
+    if (file == NULL)
+        return false;
+
+    size_t written;
+    if (header.valueSize == sizeof(double))
+        written = fwrite(frame, sizeof(double), header.numCols, file);
+    else {
+        for (int i = 0; i < header.numCols; i++)
+            floats[i] = frame[i];
+        written = fwrite(&floats[0], sizeof(float), header.numCols, file);
+    }
+
+    if (written != header.numCols)
+        return fail("Unable to write frame to '" + path + "'.");
+    header.numFrames++;
+    return true;
+}
+
+/**
+ * Fill in the frame count and close the file
+ * @return True on success, or if no file was open
+ */
+bool BinaryTrajectoryWriter::close(){
+    if (file == NULL)
+        return true;
+
+    bool ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    file = NULL;
+    if (!ok)
+        errorMessage = "Unable to finish '" + path + "'.";
+    return ok;
+}
+
+/**
+ * @return The number of frames written so far
+ */
+uint64_t BinaryTrajectoryWriter::numFrames(){
+    return header.numFrames;
+}
+
+/**
+ * @return What went wrong, after a failure
+ */
+const string& BinaryTrajectoryWriter::getError(){
+    return errorMessage;
+}
+
+/**
+ * Give up on the file
+ * @param  message What went wrong
+ * @return         False
+ */
+bool BinaryTrajectoryWriter::fail(const string &message){
+    errorMessage = "Trajectory Error: " + message;
+    if (file != NULL){
+        fclose(file);
+        file = NULL;
+    }
+    return false;
+}
@@ -30,21 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
 #include "CommandChannel.h"
-
-/**
- * List of all the joints
- */
-const char *CommandChannel::urdf_joint_names[] = {
-    "WST", "NKY", "NK1", "NK2",
-    "LSP", "LSR", "LSY", "LEP", "LWY", "LWR", "LWP",
-    "RSP", "RSR", "RSY", "REP", "RWY", "RWR", "RWP",
-    "UNUSED1",
-    "LHY", "LHR", "LHP", "LKP", "LAP", "LAR",
-    "UNUSED2",
-    "RHY", "RHR", "RHP", "RKP", "RAP", "RAR",
-    "RF1", "RF2", "RF3", "RF4", "RF5",
-    "LF1", "LF2", "LF3", "LF4", "LF5",
-    "unknown1", "unknown2", "unknown3", "unknown4", "unknown5", "unknown6", "unknown7", "unknown8"};
+#include "LoopLog.h"
 
 /**
  * Create the command channel 
@@ -60,16 +46,8 @@ CommandChannel::CommandChannel(){
  */
 CommandChannel::~CommandChannel() {}
 
-int CommandChannel::indexLookup(string &joint) {
-    if (joint.length() != 3)
-        return -1;
-    int best_match = -1;
-
-    for (int i = 0; i < HUBO_JOINT_COUNT; i++) {
-        if (strcmp(joint.c_str(), urdf_joint_names[i]) == 0)
-            best_match = i;
-    }
-    return best_match;
+int CommandChannel::indexLookup(const string &joint) {
+    return JointRegistry::instance()->indexOf(joint);
 }
 
 /**
@@ -77,7 +55,7 @@ int CommandChannel::indexLookup(string &joint) {
  * @param  joint The joint to enable
  * @return       True on success
  */
-bool CommandChannel::enable(string joint){
+bool CommandChannel::enable(const string &joint){
     BoardCommand command;
     memset(&command, 0, sizeof(command));
     int jointNum = 0;
@@ -96,7 +74,7 @@ bool CommandChannel::enable(string joint){
     int r = ach_put(&huboBoardCommandChannel, &command, sizeof(command));
 
     if (ACH_OK != r) {
-        cerr << "Error! Command enable failed with state " << r << endl;
+        LOOP_LOG(LOG_ERROR, "Error! Command enable failed with state %d", r);
         return false;
     }
     return true;
@@ -107,7 +85,7 @@ bool CommandChannel::enable(string joint){
  * @param  joint The joint you want to disable 
  * @return       True on success
  */
-bool CommandChannel::disable(string joint){
+bool CommandChannel::disable(const string &joint){
     BoardCommand command;
     memset(&command, 0, sizeof(command));
     int jointNum = 0;
@@ -126,7 +104,7 @@ bool CommandChannel::disable(string joint){
     int r = ach_put(&huboBoardCommandChannel, &command, sizeof(command));
 
     if (ACH_OK != r) {
-        cerr << "Error! Command disable failed with state " << r << endl;
+        LOOP_LOG(LOG_ERROR, "Error! Command disable failed with state %d", r);
         return false;
     }
     return true;
@@ -137,7 +115,7 @@ bool CommandChannel::disable(string joint){
  * @param  joint The joint to home
  * @return       True on success
  */
-bool CommandChannel::home(string joint){
+bool CommandChannel::home(const string &joint){
     BoardCommand command;
     memset(&command, 0, sizeof(command));
     int jointNum = 0;
@@ -154,7 +132,7 @@ bool CommandChannel::home(string joint){
     int r = ach_put(&huboBoardCommandChannel, &command, sizeof(command));
 
     if (ACH_OK != r) {
-        cerr << "Error! Command home failed with state " << r << endl;
+        LOOP_LOG(LOG_ERROR, "Error! Command home failed with state %d", r);
         return false;
     }
     return true;
@@ -165,7 +143,7 @@ bool CommandChannel::home(string joint){
  * @param  joint The joint to reset
  * @return       True on successs
  */
-bool CommandChannel::reset(string &joint){
+bool CommandChannel::reset(const string &joint){
     BoardCommand command;
     memset(&command, 0, sizeof(command));
     int jointNum = 0;
@@ -180,7 +158,7 @@ bool CommandChannel::reset(string &joint){
     int r = ach_put(&huboBoardCommandChannel, &command, sizeof(command));
 
     if (ACH_OK != r) {
-        cerr << "Error! Command reset failed with state " << r << endl;
+        LOOP_LOG(LOG_ERROR, "Error! Command reset failed with state %d", r);
         return false;
     }
     return true;
@@ -199,7 +177,7 @@ bool CommandChannel::initializeSensors(){
     int r = ach_put(&huboBoardCommandChannel, &command, sizeof(command));
 
     if (ACH_OK != r) {
-        cerr << "Error! Command initializeSensors failed with state " << r << endl;
+        LOOP_LOG(LOG_ERROR, "Error! Command initializeSensors failed with state %d", r);
         return false;
     }
     return true;
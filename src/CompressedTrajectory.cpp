@@ -0,0 +1,450 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * Writing and reading the compressed trajectory format.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include "CompressedTrajectory.h"
+
+#define MAX_QUANTA 4.0e18   // Largest multiple of the quantum that fits in an int64_t, with room to spare
+
+/**
+ * Check whether a file is a compressed trajectory, by its magic number
+ * @param  path Path to the file
+ * @return      True if it is
+ */
+bool isCompressedTrajectory(const string &path){
+    FILE* in = fopen(path.c_str(), "rb");
+    if (in == NULL)
+        return false;
+
+    char magic[COMPRESSED_TRAJECTORY_MAGIC_SIZE];
+    bool compressed = fread(magic, sizeof(magic), 1, in) == 1
+        && memcmp(magic, COMPRESSED_TRAJECTORY_MAGIC, COMPRESSED_TRAJECTORY_MAGIC_SIZE) == 0;
+    fclose(in);
+    return compressed;
+}
+
+/**
+ * Append a signed value as a zigzag encoded varint
+ * @param value The value
+ * @param out   Where to append it
+ */
+static void putVarint(int64_t value, vector< unsigned char > &out){
+    uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    while (zigzag >= 0x80){
+        out.push_back((unsigned char)(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    out.push_back((unsigned char)zigzag);
+}
+
+/**
+ * Read a zigzag encoded varint
+ * @param  p     The next byte. Left just past the varint.
+ * @param  end   Past the last byte there is
+ * @param  value Set to the value
+ * @return       False if the bytes run out first
+ */
+static inline bool getVarint(const unsigned char* &p, const unsigned char* end, int64_t &value){
+    uint64_t zigzag = 0;
+    for (int shift = 0; p != end && shift < 64; shift += 7){
+        unsigned char byte = *p++;
+        zigzag |= (uint64_t)(byte & 0x7f) << shift;
+        if (byte < 0x80){
+            value = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Create a writer with no file open
+ */
+CompressedTrajectoryWriter::CompressedTrajectoryWriter(){
+    file = NULL;
+    offset = 0;
+    memset(&header, 0, sizeof(header));
+}
+
+/**
+ * Destructor. Finishes the file if it is still open.
+ */
+CompressedTrajectoryWriter::~CompressedTrajectoryWriter(){
+    close();
+}
+
+/**
+ * Create a file and write the header and column names
+ * @param  path    Path to the file. It is truncated if it exists.
+ * @param  columns The column names
+ * @param  rate    Frames per second, or 0 if unknown
+ * @param  quantum Values are rounded to a multiple of this
+ * @return         True on success
+ */
+bool CompressedTrajectoryWriter::open(const string &path, const vector< string > &columns, double rate, double quantum){
+    close();
+    if (columns.empty())
+        return fail("A compressed trajectory needs at least one column.");
+    if (!(quantum > 0))
+        return fail("The quantum of a compressed trajectory must be more than 0.");
+
+    this->path = path;
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+        return fail("Unable to open file '" + path + "' for writing.");
+
+    string names;
+    for (int i = 0; i < columns.size(); i++){
+        names += columns[i];
+        names += '\0';
+    }
+    names.resize((names.size() + 7) & ~(size_t)7, '\0');
+
+    memcpy(header.magic, COMPRESSED_TRAJECTORY_MAGIC, COMPRESSED_TRAJECTORY_MAGIC_SIZE);
+    header.version = COMPRESSED_TRAJECTORY_VERSION;
+    header.numCols = columns.size();
+    header.namesSize = names.size();
+    header.blockFrames = COMPRESSED_BLOCK_FRAMES;
+    header.numFrames = 0;
+    header.indexOffset = 0;
+    header.rate = rate;
+    header.quantum = quantum;
+    offset = sizeof(header) + names.size();
+    index.clear();
+    last.assign(columns.size(), 0);
+    bytes.reserve(columns.size() * 10);
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(names.data(), names.size(), 1, file) != 1)
+        return fail("Unable to write header to '" + path + "'.");
+    return true;
+}
+
+/**
+ * Append a frame. It is stored whole if it starts a block, and as differences from the
+ * frame before otherwise.
+ * @param  frame One value per column
+ * @return       True on success
+ */
+bool CompressedTrajectoryWriter::write(const double* frame){
+    if (file == NULL)
+        return false;
+
+    bool whole = header.numFrames % header.blockFrames == 0;
+    if (whole)
+        index.push_back(offset);
+
+    bytes.clear();
+    for (int i = 0; i < header.numCols; i++){
+        double quanta = frame[i] / header.quantum;
+        if (!(fabs(quanta) < MAX_QUANTA))
+            return fail("Cannot store the value of a column in '" + path + "'. It is not a number, or too big for the quantum.");
+
+        int64_t value = llrint(quanta);
+        putVarint(whole ? value : value - last[i], bytes);
+        last[i] = value;
+    }
+
+    if (fwrite(&bytes[0], bytes.size(), 1, file) != 1)
+        return fail("Unable to write frame to '" + path + "'.");
+    offset += bytes.size();
+    header.numFrames++;
+    return true;
+}
+
+/**
+ * Write the block offsets, fill in the header and close the file
+ * @return True on success, or if no file was open
+ */
+bool CompressedTrajectoryWriter::close(){
+    if (file == NULL)
+        return true;
+
+    header.indexOffset = offset;
+    bool ok = index.empty() || fwrite(&index[0], sizeof(uint64_t), index.size(), file) == index.size();
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    file = NULL;
+    if (!ok)
+        errorMessage = "Unable to finish '" + path + "'.";
+    return ok;
+}
+
+/**
+ * @return The number of frames written so far
+ */
+uint64_t CompressedTrajectoryWriter::numFrames(){
+    return header.numFrames;
+}
+
+/**
+ * @return What went wrong, after a failure
+ */
+const string& CompressedTrajectoryWriter::getError(){
+    return errorMessage;
+}
+
+/**
+ * Give up on the file
+ * @param  message What went wrong
+ * @return         False
+ */
+bool CompressedTrajectoryWriter::fail(const string &message){
+    errorMessage = "Trajectory Error: " + message;
+    if (file != NULL){
+        fclose(file);
+        file = NULL;
+    }
+    return false;
+}
+
+/**
+ * Open a compressed trajectory and read its header, block offsets, and first and last
+ * frames. Check errored() afterwards.
+ * @param path       Path to the file
+ * @param bufferSize Most frames each loadBuffer() decodes
+ */
+CompressedTrajectoryReader::CompressedTrajectoryReader(const string &path, int bufferSize){
+    this->path = path;
+    _bufferSize = bufferSize;
+    _error = false;
+    used = 0;
+    frame = 0;
+    steps = 0;
+    memset(&info, 0, sizeof(info));
+
+    file = fopen(path.c_str(), "rb");
+    if (file == NULL){
+        fail("Unable to open file '" + path + "'");
+        return;
+    }
+
+    if (fread(&info, sizeof(info), 1, file) != 1
+            || memcmp(info.magic, COMPRESSED_TRAJECTORY_MAGIC, COMPRESSED_TRAJECTORY_MAGIC_SIZE) != 0
+            || info.version != COMPRESSED_TRAJECTORY_VERSION){
+        fail("'" + path + "' is not a compressed trajectory this version can read.");
+        return;
+    }
+    if (info.numCols == 0 || info.blockFrames == 0 || !(info.quantum > 0) || info.numFrames == 0 || info.numFrames > 0x7fffffff){
+        fail("'" + path + "' has a bad header, or no frames.");
+        return;
+    }
+
+    vector< char > names(info.namesSize + 1, '\0');
+    if (info.namesSize > 0 && fread(&names[0], info.namesSize, 1, file) != 1){
+        fail("'" + path + "' is too short for its column names.");
+        return;
+    }
+    const char* name = &names[0];
+    for (int i = 0; i < info.numCols; i++){
+        if (name >= &names[0] + info.namesSize){
+            fail("'" + path + "' is missing column names.");
+            return;
+        }
+        _header[name] = i;
+        _orderedHeader.push_back(name);
+        name += strlen(name) + 1;
+    }
+
+    int64_t blocks = (info.numFrames + info.blockFrames - 1) / info.blockFrames;
+    index.resize(blocks);
+    if (fseeko(file, info.indexOffset, SEEK_SET) != 0 || fread(&index[0], sizeof(uint64_t), blocks, file) != blocks){
+        fail("'" + path + "' is too short for its block offsets.");
+        return;
+    }
+    for (int64_t b = 0; b < blocks; b++){
+        if (index[b] > info.indexOffset || (b > 0 && index[b] < index[b - 1])){
+            fail("'" + path + "' has bad block offsets.");
+            return;
+        }
+    }
+
+    // Dividing by a whole number of quanta gives back the nearest double to a value
+    // written in decimal, where multiplying by the quantum may be a bit off.
+    steps = floor(1 / info.quantum + .5);
+    if (fabs(steps * info.quantum - 1) > 1e-12)
+        steps = 0;
+
+    last.resize(info.numCols);
+    if (!seek(info.numFrames - 1) || !decode(_end) || !seek(0) || !decode(_start))
+        return;
+    reset();
+}
+
+/**
+ * Destructor
+ */
+CompressedTrajectoryReader::~CompressedTrajectoryReader(){
+    if (file != NULL)
+        fclose(file);
+}
+
+/**
+ * Decode the next frames into the buffer
+ * @return True if any frames were decoded
+ */
+bool CompressedTrajectoryReader::loadBuffer(){
+    if (_error)
+        return false;
+
+    int count = std::min((int64_t)_bufferSize, (int64_t)info.numFrames - frame);
+    if (count <= 0)
+        return false;
+
+    _buffer.resize(count);
+    for (int r = 0; r < count; r++){
+        if (!decode(_buffer[r]))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Go back to the first frame
+ */
+void CompressedTrajectoryReader::reset(){
+    frame = 0;
+}
+
+/**
+ * Move to a frame, so that the next loadBuffer() starts with it. Only the block it is in
+ * is read, and the frames before it in the block decoded.
+ * @param  frame The frame, counted from 0
+ * @return       False if there is no such frame, or on error
+ */
+bool CompressedTrajectoryReader::seek(int frame){
+    if (_error || frame < 0 || frame >= info.numFrames)
+        return false;
+
+    this->frame = frame - frame % info.blockFrames;
+    Frame skipped(info.numCols);
+    while (this->frame < frame){
+        if (!decode(skipped))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Read a block into memory
+ * @param  block The block
+ * @return       True on success
+ */
+bool CompressedTrajectoryReader::readBlock(int64_t block){
+    uint64_t begin = index[block];
+    uint64_t end = block + 1 < index.size() ? index[block + 1] : info.indexOffset;
+    bytes.resize(end - begin);
+    used = 0;
+    if (fseeko(file, begin, SEEK_SET) != 0 || (!bytes.empty() && fread(&bytes[0], bytes.size(), 1, file) != 1))
+        return fail("Unable to read '" + path + "'.");
+    return true;
+}
+
+/**
+ * Decode the next frame, reading its block first if it starts one
+ * @param  values Set to the frame
+ * @return        True on success
+ */
+bool CompressedTrajectoryReader::decode(Frame &values){
+    bool whole = frame % info.blockFrames == 0;
+    if (whole && !readBlock(frame / info.blockFrames))
+        return false;
+
+    const unsigned char* p = bytes.empty() ? NULL : &bytes[0] + used;
+    const unsigned char* end = p + (bytes.size() - used);
+    values.resize(info.numCols);
+    for (int i = 0; i < info.numCols; i++){
+        int64_t value;
+        if (!getVarint(p, end, value))
+            return fail("'" + path + "' is corrupt.");
+        last[i] = whole ? value : last[i] + value;
+        values[i] = steps > 0 ? last[i] / steps : last[i] * info.quantum;
+    }
+    used = p - &bytes[0];
+    frame++;
+    return true;
+}
+
+/**
+ * @return Frames per second the file was recorded at, or 0 if it does not say
+ */
+double CompressedTrajectoryReader::rate(){
+    return info.rate;
+}
+
+CompressedTrajectoryReader::Buffer& CompressedTrajectoryReader::buffer(){
+    return _buffer;
+}
+
+CompressedTrajectoryReader::HeaderMap& CompressedTrajectoryReader::header(){
+    return _header;
+}
+
+CompressedTrajectoryReader::Header& CompressedTrajectoryReader::orderedHeader(){
+    return _orderedHeader;
+}
+
+CompressedTrajectoryReader::Frame& CompressedTrajectoryReader::start(){
+    return _start;
+}
+
+CompressedTrajectoryReader::Frame& CompressedTrajectoryReader::end(){
+    return _end;
+}
+
+int CompressedTrajectoryReader::numLines(){
+    return info.numFrames;
+}
+
+int CompressedTrajectoryReader::numCols(){
+    return info.numCols;
+}
+
+bool CompressedTrajectoryReader::errored(){
+    return _error;
+}
+
+string CompressedTrajectoryReader::getError(){
+    return errorMessage;
+}
+
+/**
+ * Give up on the file. Every read fails from now on.
+ * @param  message What went wrong
+ * @return         False
+ */
+bool CompressedTrajectoryReader::fail(const string &message){
+    _error = true;
+    errorMessage = "Trajectory Error: " + message;
+    return false;
+}
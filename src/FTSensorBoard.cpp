@@ -25,6 +25,7 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "FTSensorBoard.h"
+#include "LoopLog.h"
 
 /**
  * Create a Force Torque sensor board
@@ -47,7 +48,7 @@ bool FTSensorBoard::get(PROPERTY property, double& value){
         // Chooses whether to use the name of the board or the board number to request the property from the state channel
         // Prints an error if the request fails
         if ( ( boardNum != -1 ? !stateChannel->getFTProperty(boardNum, property, value) : !stateChannel->getFTProperty(getName(), property, value) ) ){
-            cout << "Error getting " << Names::getName(property) << " from " << getName() << endl;
+            LOOP_LOG(LOG_ERROR, "Error getting %s from %s", Names::getName(property), getName().c_str());
             return false;
         }
         break;
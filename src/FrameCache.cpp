@@ -0,0 +1,195 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * The cache of parsed trajectory files. Only used off the loop, from wherever files are opened.
+ */
+
+#include <sys/stat.h>
+
+#include "FrameCache.h"
+
+boost::mutex FrameCache::lock;
+map< string, FrameCache::Entry > FrameCache::entries;
+list< string > FrameCache::uses;
+size_t FrameCache::bytes = 0;
+size_t FrameCache::limit = DEFAULT_CACHE_LIMIT;
+int64_t FrameCache::hits = 0;
+int64_t FrameCache::misses = 0;
+
+/**
+ * @param  other Another stamp
+ * @return       True if both stamps are of the same version of the same file
+ */
+bool FrameCache::Stamp::operator==(const Stamp &other) const {
+    return device == other.device && inode == other.inode && size == other.size
+        && seconds == other.seconds && nanoseconds == other.nanoseconds;
+}
+
+/**
+ * Take the stamp of a file
+ * @param  path  Path to the file
+ * @param  stamp Set to the file's stamp
+ * @return       True on success
+ */
+bool FrameCache::stamp(const string &path, Stamp &stamp){
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0)
+        return false;
+
+    stamp.device = info.st_dev;
+    stamp.inode = info.st_ino;
+    stamp.size = info.st_size;
+    stamp.seconds = info.st_mtim.tv_sec;
+    stamp.nanoseconds = info.st_mtim.tv_nsec;
+    return true;
+}
+
+/**
+ * Look up a parsed file
+ * @param  path  Path to the file, as it is loaded
+ * @param  stamp The stamp of the file as it is now
+ * @return       The parsed frames, or nothing if this version of the file has not been parsed
+ */
+FrameCache::Data FrameCache::find(const string &path, const Stamp &stamp){
+    boost::mutex::scoped_lock guard(lock);
+
+    map< string, Entry >::iterator found = entries.find(path);
+    if (found == entries.end()){
+        misses++;
+        return Data();
+    }
+
+    Entry& entry = found->second;
+    if (!(entry.stamp == stamp)){
+        // The file has changed since it was parsed.
+        bytes -= entry.bytes;
+        uses.erase(entry.use);
+        entries.erase(found);
+        misses++;
+        return Data();
+    }
+
+    uses.splice(uses.begin(), uses, entry.use);
+    hits++;
+    return entry.data;
+}
+
+/**
+ * Keep a parsed file
+ * @param path  Path to the file, as it is loaded
+ * @param stamp The stamp the file had before it was parsed
+ * @param data  The parsed frames
+ */
+void FrameCache::store(const string &path, const Stamp &stamp, const Data &data){
+    boost::mutex::scoped_lock guard(lock);
+
+    size_t size = data->values.size() * sizeof(double);
+    if (size > limit)
+        return;
+
+    map< string, Entry >::iterator found = entries.find(path);
+    if (found != entries.end()){
+        bytes -= found->second.bytes;
+        uses.erase(found->second.use);
+        entries.erase(found);
+    }
+
+    uses.push_front(path);
+    Entry& entry = entries[path];
+    entry.stamp = stamp;
+    entry.data = data;
+    entry.bytes = size;
+    entry.use = uses.begin();
+    bytes += size;
+
+    trim();
+}
+
+/**
+ * Set how many bytes of parsed frames are kept between loads
+ * @param bytes The limit. 0 turns the cache off.
+ */
+void FrameCache::setLimit(size_t bytes){
+    boost::mutex::scoped_lock guard(lock);
+    limit = bytes;
+    trim();
+}
+
+/**
+ * @return How many bytes of parsed frames are kept between loads
+ */
+size_t FrameCache::getLimit(){
+    boost::mutex::scoped_lock guard(lock);
+    return limit;
+}
+
+/**
+ * @return How many bytes of parsed frames are kept now
+ */
+size_t FrameCache::size(){
+    boost::mutex::scoped_lock guard(lock);
+    return bytes;
+}
+
+/**
+ * @return How many loads found their file already parsed
+ */
+int64_t FrameCache::numHits(){
+    boost::mutex::scoped_lock guard(lock);
+    return hits;
+}
+
+/**
+ * @return How many loads had to parse their file
+ */
+int64_t FrameCache::numMisses(){
+    boost::mutex::scoped_lock guard(lock);
+    return misses;
+}
+
+/**
+ * Forget every parsed file. Trajectories playing them keep them until they are deleted.
+ */
+void FrameCache::clear(){
+    boost::mutex::scoped_lock guard(lock);
+    entries.clear();
+    uses.clear();
+    bytes = 0;
+}
+
+/**
+ * Drop the least recently loaded files until the cache is under its limit. Called with the lock held.
+ */
+void FrameCache::trim(){
+    while (bytes > limit && !uses.empty()){
+        map< string, Entry >::iterator oldest = entries.find(uses.back());
+        bytes -= oldest->second.bytes;
+        entries.erase(oldest);
+        uses.pop_back();
+    }
+}
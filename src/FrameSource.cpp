@@ -0,0 +1,266 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * The common part of every trajectory frame source, and the choice of which kind of
+ * source a file gets.
+ */
+
+#include "FrameSource.h"
+#include "PreloadedSource.h"
+#include "StreamedSource.h"
+#include "MappedSource.h"
+#include "KeyframeSource.h"
+#include "CompressedTrajectory.h"
+#include "FrameCache.h"
+
+size_t FrameSource::preloadLimit = DEFAULT_PRELOAD_LIMIT;
+
+/**
+ * Open a trajectory file for reading. Binary files are mapped, and keyframe files are
+ * fitted with splines that are evaluated as they play. Compressed files are always
+ * streamed, and decoded by the prefetch thread. Text files whose frames
+ * fit in the preload limit are parsed completely now, unless the same version of the
+ * file has been parsed before and is still cached; bigger ones are streamed by a
+ * prefetch thread as they play.
+ * @param  path  Path to the file
+ * @param  error Set to what went wrong on failure
+ * @return       The source, or NULL on failure
+ */
+FrameSource* FrameSource::open(const string &path, string &error){
+    if (isBinaryTrajectory(path)){
+        FrameSource* source = new MappedSource(path);
+        if (source->errored()){
+            error = "Error initializing trajectory file " + path + ". " + source->getError();
+            delete source;
+            return NULL;
+        }
+        return source;
+    }
+
+    if (isKeyframeTrajectory(path)){
+        FrameSource* source = new KeyframeSource(path);
+        if (source->errored()){
+            error = "Error initializing trajectory file " + path + ". " + source->getError();
+            delete source;
+            return NULL;
+        }
+        return source;
+    }
+
+    if (isCompressedTrajectory(path)){
+        CompressedTrajectoryReader* file = new CompressedTrajectoryReader(path, STREAM_BUFFER_SIZE);
+        if (file->errored()){
+            error = "Error initializing trajectory file " + path + ". " + file->getError();
+            delete file;
+            return NULL;
+        }
+
+        FrameSource* source = new StreamedSource(file);
+        if (source->errored() || source->current() == NULL){
+            error = "Error loading buffer for trajectory file " + path + ". " + source->getError();
+            delete source;
+            return NULL;
+        }
+        return source;
+    }
+
+    // Stamp the file before it is read, so that a change made while it is parsed is
+    // noticed the next time it is loaded.
+    FrameCache::Stamp stamp;
+    bool stamped = FrameCache::stamp(path, stamp);
+    if (stamped){
+        FrameCache::Data data = FrameCache::find(path, stamp);
+        if (data)
+            return new PreloadedSource(data);
+    }
+
+    WSVFile* file = new WSVFile(path, true, STREAM_BUFFER_SIZE);
+    if (file->errored()){
+        error = "Error initializing trajectory file " + path + ". " + file->getError();
+        delete file;
+        return NULL;
+    }
+
+    // If the file doesn't supply a header, and has 40 columns, assume the default header.
+    if (!file->headerSupplied() && file->numCols() == 40)
+        file->setHeader(DEFAULT_HEADER);
+
+    FrameSource* source;
+    if ((size_t)file->numLines() * file->numCols() * sizeof(double) <= preloadLimit){
+        PreloadedSource* preloaded = new PreloadedSource(*file);
+        delete file;
+        if (stamped && !preloaded->errored() && preloaded->current() != NULL)
+            FrameCache::store(path, stamp, preloaded->data());
+        source = preloaded;
+    } else {
+        source = new StreamedSource(file);
+    }
+
+    if (source->errored() || source->current() == NULL){
+        error = "Error loading buffer for trajectory file " + path + ". " + source->getError();
+        delete source;
+        return NULL;
+    }
+    return source;
+}
+
+/**
+ * Set how many bytes of frames a file may have and still be preloaded.
+ * @param bytes The limit. 0 means nothing is preloaded.
+ */
+void FrameSource::setPreloadLimit(size_t bytes){
+    preloadLimit = bytes;
+}
+
+/**
+ * @return How many bytes of frames a file may have and still be preloaded
+ */
+size_t FrameSource::getPreloadLimit(){
+    return preloadLimit;
+}
+
+/**
+ * Create a source with no columns
+ */
+FrameSource::FrameSource(){
+    _frames = 0;
+    _error = false;
+}
+
+/**
+ * Destructor
+ */
+FrameSource::~FrameSource(){}
+
+/**
+ * Take the columns and the first and last frames from a file that has been opened.
+ * @param file The file
+ */
+void FrameSource::describe(FrameReader &file){
+    _header = file.header();
+    _orderedHeader = file.orderedHeader();
+    _start = file.start();
+    _end = file.end();
+    _frames = file.numLines();
+}
+
+/**
+ * Mark the source as errored
+ * @param message What went wrong
+ */
+void FrameSource::fail(const string &message){
+    _error = true;
+    errorMessage = message;
+}
+
+/**
+ * @return False, as most sources have every frame to hand
+ */
+bool FrameSource::seeking(){
+    return false;
+}
+
+/**
+ * @return False, as most sources always have the next frame to hand
+ */
+bool FrameSource::stalled(){
+    return false;
+}
+
+/**
+ * @return 0, as text files do not record their rate
+ */
+double FrameSource::rate(){
+    return 0;
+}
+
+/**
+ * @return Map from column name to column index
+ */
+FrameSource::HeaderMap& FrameSource::header(){
+    return _header;
+}
+
+/**
+ * @return The column names in order
+ */
+const FrameSource::Header& FrameSource::orderedHeader(){
+    return _orderedHeader;
+}
+
+/**
+ * Find a column by name
+ * @param  name The column name
+ * @return      The column index, or -1 if there is no such column
+ */
+int FrameSource::column(const string &name){
+    HeaderMap::iterator it = _header.find(name);
+    return it == _header.end() ? -1 : it->second;
+}
+
+/**
+ * @return The number of columns
+ */
+int FrameSource::numCols(){
+    return _start.size();
+}
+
+/**
+ * @return The number of frames
+ */
+int FrameSource::numFrames(){
+    return _frames;
+}
+
+/**
+ * @return The first frame
+ */
+const FrameSource::Frame& FrameSource::start(){
+    return _start;
+}
+
+/**
+ * @return The last frame
+ */
+const FrameSource::Frame& FrameSource::end(){
+    return _end;
+}
+
+/**
+ * @return True if reading the source has failed
+ */
+bool FrameSource::errored(){
+    return _error;
+}
+
+/**
+ * @return What went wrong, if the source has errored
+ */
+const string& FrameSource::getError(){
+    return errorMessage;
+}
@@ -25,12 +25,24 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "HuboState.h"
+#include "LoopLog.h"
 
 /**
  * Constructor for the hubo state. The Hubo state is what manages all of the robot components
  */
 HuboState::HuboState(){}
 
+/**
+ * A second hubo state, for building a new robot in while the control loop still drives
+ * the one from instance(). Function static for the same reason as instance(), so the
+ * joint table stays cache aligned.
+ * @return The spare state
+ */
+HuboState* HuboState::spare(){
+    static HuboState state;
+    return &state;
+}
+
 /**
  * Destructor for HuboState
  */
@@ -45,22 +57,49 @@ HuboState::~HuboState(){
  * @return       True on success. 
  */
 bool HuboState::setAlias(string name, string alias){
+    if (!addAlias(name, alias))
+        return false;
+
+    JointRegistry::instance()->setAlias(name, alias);
+
+    return true;
+}
+
+/**
+ * Give a component a second name in this state only. The joint registry is shared with
+ * the state the loop is driving, so aliases from the config wait for registerAliases.
+ * @param  name  The name of the RobotComponent
+ * @param  alias The alias to have for the RobotComponent
+ * @return       True on success
+ */
+bool HuboState::addAlias(const string &name, const string &alias){
     if (!nameExists(name) || nameExists(alias)){
-        cout << "Alias " << alias << "Already exists. returning false" << endl;
+        LOOP_LOG(LOG_WARN, "Alias %s already exists. Returning false.", alias.c_str());
         return false;
     }
 
     index[alias] = index[name];
-
+    registryAliases.push_back(pair< string, string >(name, alias));
     return true;
 }
 
+/**
+ * Replace the aliases in the joint registry with the ones from this state's config. Call
+ * it once this state is the one in use.
+ */
+void HuboState::registerAliases(){
+    JointRegistry* registry = JointRegistry::instance();
+    registry->clearAliases();
+    for (int i = 0; i < registryAliases.size(); i++)
+        registry->setAlias(registryAliases[i].first, registryAliases[i].second);
+}
+
 /**
  * Check to see if the name exists in the hubo state
  * @param  name The name to check for existance
  * @return      True if the name exists
  */
-bool HuboState::nameExists(string name){
+bool HuboState::nameExists(const string &name){
     return index.count(name) == 1;
 }
 
@@ -69,10 +108,11 @@ bool HuboState::nameExists(string name){
  * @param  name Name of the robot component
  * @return      The Robot component object
  */
-RobotComponent* HuboState::getComponent(string name){
-    if (nameExists(name))
-        return index[name];
-    return NULL;
+RobotComponent* HuboState::getComponent(const string &name){
+    map< string, RobotComponent* >::const_iterator it = index.find(name);
+    if (it == index.end())
+        return NULL;
+    return it->second;
 }
 
 /**
@@ -91,6 +131,22 @@ const HuboState::Motors& HuboState::getMotors(){
     return motors;
 }
 
+/**
+ * Get all of the metajoints in the hubo state, in the order they are in the components
+ * @return All of the metajoints in the Hubo state
+ */
+const HuboState::MetaJoints& HuboState::getMetaJoints(){
+    return metaJoints;
+}
+
+/**
+ * Get the table the motors and metajoints keep their goal, step, velocity and mode in
+ * @return The joint table
+ */
+JointTable& HuboState::getJointTable(){
+    return joints;
+}
+
 /**
  * Initialize hubo with the default values as specified by an xml configuartion file
  * @param path      Path to the config file
@@ -99,9 +155,19 @@ const HuboState::Motors& HuboState::getMotors(){
 void HuboState::initHuboWithDefaults(string path, double frequency){
     xml_document doc;
     if (!doc.load_file(path.c_str())){
-        cout << "No such file, " << path.c_str() << endl;
+        LOOP_LOG(LOG_ERROR, "No such file, %s", path.c_str());
         return;
     }
+    initHuboFromDocument(doc, frequency);
+}
+
+/**
+ * Initialize hubo from an xml configuration that has already been parsed. This lets the
+ * file be read somewhere other than the control loop.
+ * @param doc       The parsed config file
+ * @param frequency Frequency MAESTOR operates at
+ */
+void HuboState::initHuboFromDocument(xml_document& doc, double frequency){
     reset();
     xml_node robot = doc.child("robot");
 
@@ -110,13 +176,17 @@ void HuboState::initHuboWithDefaults(string path, double frequency){
         xml_node node = *it;
         string type = node.attribute("type").as_string();       
         if (strcmp(type.c_str(), "HuboMotor") == 0){
-            RobotComponent* component = HuboMotorFromXML(node, new HuboMotor(), frequency);
+            if (joints.full()){
+                LOOP_LOG(LOG_WARN, "Too many joints. Skipping %s", node.attribute("name").as_string());
+                continue;
+            }
+            RobotComponent* component = HuboMotorFromXML(node, new HuboMotor(joints), frequency);
             if (component == NULL){
-                cout << "Error instantiating " << type << " in initialization." << endl;
+                LOOP_LOG(LOG_ERROR, "Error instantiating %s in initialization.", type.c_str());
                 continue;
             }
             if (!addComponentFromXML(node, component, true)){
-                cout << "Error adding component " << component->getName() << endl;
+                LOOP_LOG(LOG_ERROR, "Error adding component %s", component->getName().c_str());
                 delete component;
                 continue;
             }
@@ -125,12 +195,12 @@ void HuboState::initHuboWithDefaults(string path, double frequency){
         } else if (strcmp(type.c_str(), "FTSensor") == 0) {
             RobotComponent* component = FTSensorFromXML(node, new FTSensorBoard());
             if (component == NULL){
-                cout << "Error instantiating " << type << " in initialization." << endl;
+                LOOP_LOG(LOG_ERROR, "Error instantiating %s in initialization.", type.c_str());
                 continue;
             }
 
             if (!addComponentFromXML(node, component, true)){
-                cout << "Error adding component " << component->getName() << endl;
+                LOOP_LOG(LOG_ERROR, "Error adding component %s", component->getName().c_str());
                 delete component;
                 continue;
             }
@@ -138,12 +208,12 @@ void HuboState::initHuboWithDefaults(string path, double frequency){
         } else if (strcmp(type.c_str(), "IMUSensor") == 0) {
             RobotComponent* component = IMUSensorFromXML(node, new IMUBoard());
             if (component == NULL){
-                cout << "Error instantiating " << type << " in initialization." << endl;
+                LOOP_LOG(LOG_ERROR, "Error instantiating %s in initialization.", type.c_str());
                 continue;
             }
 
             if (!addComponentFromXML(node, component, true)){
-                cout << "Error adding component " << component->getName() << endl;
+                LOOP_LOG(LOG_ERROR, "Error adding component %s", component->getName().c_str());
                 delete component;
                 continue;
             }
@@ -169,7 +239,7 @@ void HuboState::initHuboWithDefaults(string path, double frequency){
             addMetaJointControllerFromXML(node, controller, type, frequency);
 
         } else {
-            cout << "Skipping unknown type " << type << endl;
+            LOOP_LOG(LOG_WARN, "Skipping unknown type %s", type.c_str());
             continue;
         }
     }
@@ -208,6 +278,12 @@ RobotComponent* HuboState::HuboMotorFromXML(xml_node node, HuboMotor* component,
     component->setFrequency(frequency);
     component->setName(node.attribute("name").as_string());
 
+    // Look the joint up now so the channels never have to search for it by name.
+    int huboIndex = JointRegistry::instance()->indexOf(component->getName());
+    joints.index[component->getRow()] = huboIndex;
+    if (node.attribute("boardNum").empty())
+        component->setBoardNum(huboIndex);
+
     return component;
 }
 
@@ -263,6 +339,7 @@ RobotComponent* HuboState::MetaJointFromXML(xml_node node, MetaJoint* component,
     }
 
     component->setName(node.attribute("name").as_string());
+    joints.index[component->getRow()] = JointRegistry::instance()->indexOf(component->getName());
 
     if (!node.attribute("default").empty())
         component->setGoal(node.attribute("default").as_double());
@@ -280,7 +357,7 @@ RobotComponent* HuboState::MetaJointFromXML(xml_node node, MetaJoint* component,
  */
 bool HuboState::addComponentFromXML(xml_node node, RobotComponent* component, bool back){
     if (nameExists(component->getName())){
-        cout << "Skipping duplicate component with name " << component->getName() << endl;
+        LOOP_LOG(LOG_WARN, "Skipping duplicate component with name %s", component->getName().c_str());
         return false;
     }
 
@@ -297,7 +374,7 @@ bool HuboState::addComponentFromXML(xml_node node, RobotComponent* component, bo
     xml_node aliases = node.child("aliases");
     for (xml_node::iterator values = aliases.begin(); values != aliases.end(); values++){
         string alias = (*values).child_value();
-        setAlias(component->getName(), alias);
+        addAlias(component->getName(), alias);
     }
 
     if(index[component->getName()] == NULL)
@@ -324,16 +401,19 @@ bool HuboState::addMetaJointControllerFromXML(xml_node node, MetaJointController
     for (xml_node::iterator it = node.begin(); it != node.end(); it++) {
         if (strcmp((*it).name(), "parameter") == 0){
             RobotComponent* component;
-            if(strcmp((*it).attribute("type").as_string(),"ARM") == 0){
-                component = MetaJointFromXML(*it, new ArmMetaJoint(controller), frequency);
+            if (joints.full()){
+                LOOP_LOG(LOG_ERROR, "Too many joints to add parameters of %s", type.c_str());
+                component = NULL;
+            } else if(strcmp((*it).attribute("type").as_string(),"ARM") == 0){
+                component = MetaJointFromXML(*it, new ArmMetaJoint(controller, joints), frequency);
             } else {
-                component = MetaJointFromXML(*it, new MetaJoint(controller), frequency);
+                component = MetaJointFromXML(*it, new MetaJoint(controller, joints), frequency);
             }
             if (component == NULL){
-                cout << "Error instantiating parameter of " << type << " in initialization." << endl;
+                LOOP_LOG(LOG_ERROR, "Error instantiating parameter of %s in initialization.", type.c_str());
                 return false;
             } else if (nameExists(component->getName())){
-                cout << "Parameter name " << component->getName() << " of " << type << " already exists." << endl;
+                LOOP_LOG(LOG_ERROR, "Parameter name %s of %s already exists.", component->getName().c_str(), type.c_str());
                 delete component;
                 return false;
             }
@@ -342,7 +422,7 @@ bool HuboState::addMetaJointControllerFromXML(xml_node node, MetaJointController
 
         } else if (strcmp((*it).name(), "controlled") == 0){
             if ((*it).attribute("name").empty()){
-                cout << "Error instantiating controlled joint of " << type << " in initialization." << endl;
+                LOOP_LOG(LOG_ERROR, "Error instantiating controlled joint of %s in initialization.", type.c_str());
                 return false;
             }
 
@@ -350,7 +430,7 @@ bool HuboState::addMetaJointControllerFromXML(xml_node node, MetaJointController
 
             RobotComponent* component = getComponent(name);
             if (component == NULL){
-                cout << "Could not find component " << name << " for type " << type << endl;
+                LOOP_LOG(LOG_ERROR, "Could not find component %s for type %s", name.c_str(), type.c_str());
                 return false;
             }
 
@@ -360,13 +440,13 @@ bool HuboState::addMetaJointControllerFromXML(xml_node node, MetaJointController
 
     bool errorFound = false;
     if (controller->getNumParameters() != parameters.size()) {
-        cout << "Incorrect number of parameters passed to " << type << endl;
+        LOOP_LOG(LOG_ERROR, "Incorrect number of parameters passed to %s", type.c_str());
         errorFound = true;
     } else if (controller->getNumControlled() != controlled.size()){
-        cout << "Incorrect number of controlled joints passed to " << type << endl;
+        LOOP_LOG(LOG_ERROR, "Incorrect number of controlled joints passed to %s", type.c_str());
         errorFound = true;
     } else if (parameters.size() != parameterNodes.size()){
-        cout << "The unlikeliest error seems to have occurred.... abort mission? " << endl;
+        LOOP_LOG(LOG_ERROR, "The unlikeliest error seems to have occurred.... abort mission?");
         errorFound = true;
     }
 
@@ -382,6 +462,7 @@ bool HuboState::addMetaJointControllerFromXML(xml_node node, MetaJointController
 
         //Theoretically there's no way this can fail, so I don't check for errors here.
         addComponentFromXML(parameterNodes[i], parameters[i], false);
+        metaJoints.insert(metaJoints.begin(), static_cast<MetaJoint*>(parameters[i]));
     }
 
     for (int i = 0; i < controlled.size(); i++)
@@ -406,6 +487,9 @@ void HuboState::reset(){
 
     components.clear();
     motors.clear();
+    metaJoints.clear();
     controllers.clear();
     index.clear();
+    joints.clear();
+    registryAliases.clear();
 }
@@ -25,6 +25,7 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "IMUBoard.h"
+#include "LoopLog.h"
 
 /**
  * Constructor for the IMU Board
@@ -47,7 +48,7 @@ bool IMUBoard::get(PROPERTY property, double &value){
     case X_ROTAT:
     case Y_ROTAT:
         if ( ( boardNum != -1 ? !stateChannel->getIMUProperty(boardNum, property, value) : !stateChannel->getIMUProperty(getName(), property, value) ) ){
-            cout << "Error getting " << Names::getName(property) << " from " << getName() << endl;
+            LOOP_LOG(LOG_ERROR, "Error getting %s from %s", Names::getName(property), getName().c_str());
             return false;
         }
         break;
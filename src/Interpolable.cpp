@@ -30,8 +30,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /**
  * Create an Interpolable object. This is mostly a class that objects 
  * that can interpolate inherit from. 
+ * @param table The joint table to keep the goal, step and velocity in
+ * @param kind  What sort of joint this is
  */
-Interpolable::Interpolable() {
+Interpolable::Interpolable(JointTable& table, JOINT_KIND kind) :
+        table(table),
+        row(table.add(kind)),
+        currGoal(table.goal[row]),
+        interStep(table.step[row]),
+        interVel(table.velocity[row]) {
     currGoal = 0;
     interStep = 0;
     interVel = .3;
@@ -51,6 +58,15 @@ Interpolable::Interpolable() {
  * Destructor
  */
 Interpolable::~Interpolable() {
+    table.release(row);
+}
+
+/**
+ * Get the row of the joint table this object lives in
+ * @return The row
+ */
+int Interpolable::getRow(){
+    return row;
 }
 
 /**
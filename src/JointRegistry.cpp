@@ -0,0 +1,107 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * The registry of hubo-ach joint names. See JointRegistry.h
+ */
+
+#include "JointRegistry.h"
+
+/**
+ * List of all the joints, in hubo-ach order
+ */
+const char *JointRegistry::urdf_joint_names[] = {
+        "WST", "NKY", "NK1", "NK2",
+        "LSP", "LSR", "LSY", "LEP", "LWY", "LWR", "LWP",
+        "RSP", "RSR", "RSY", "REP", "RWY", "RWR", "RWP",
+        "UNUSED1",
+        "LHY", "LHR", "LHP", "LKP", "LAP", "LAR",
+        "UNUSED2",
+        "RHY", "RHR", "RHP", "RKP", "RAP", "RAR",
+        "RF1", "RF2", "RF3", "RF4", "RF5",
+        "LF1", "LF2", "LF3", "LF4", "LF5",
+        "unknown1", "unknown2", "unknown3", "unknown4", "unknown5", "unknown6", "unknown7", "unknown8"};
+
+/**
+ * Build the name map. Only three letter names are real joints; the placeholders
+ * were never matched by the old lookups, so they are left out here too.
+ */
+JointRegistry::JointRegistry(){
+    for (int i = 0; i < HUBO_JOINT_COUNT; i++){
+        string name = urdf_joint_names[i];
+        if (name.length() == 3)
+            names[name] = i;
+    }
+}
+
+/**
+ * Look up the hubo-ach index of a joint
+ * @param  name Name or alias of the joint
+ * @return      The index of the joint, or -1 if there is no such joint
+ */
+int JointRegistry::indexOf(const string &name) const {
+    map< string, int >::const_iterator it = names.find(name);
+    if (it != names.end())
+        return it->second;
+
+    it = aliases.find(name);
+    if (it != aliases.end())
+        return it->second;
+    return -1;
+}
+
+/**
+ * Get the hubo-ach name of a joint
+ * @param  index The hubo-ach index of the joint
+ * @return       The name, or NULL if the index is out of range
+ */
+const char* JointRegistry::nameOf(int index) const {
+    if (index < 0 || index >= HUBO_JOINT_COUNT)
+        return NULL;
+    return urdf_joint_names[index];
+}
+
+/**
+ * Let a joint be found by another name. Aliases of names that are not joints are ignored.
+ * @param  name  The joint's name
+ * @param  alias The other name
+ * @return       True if the alias now refers to a joint
+ */
+bool JointRegistry::setAlias(const string &name, const string &alias){
+    int index = indexOf(name);
+    if (index == -1 || names.count(alias) != 0)
+        return false;
+    aliases[alias] = index;
+    return true;
+}
+
+/**
+ * Forget all aliases. Done when the robot is reloaded.
+ */
+void JointRegistry::clearAliases(){
+    aliases.clear();
+}
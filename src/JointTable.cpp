@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * Table of per joint state used by the control loop. See JointTable.h
+ */
+
+#include "JointTable.h"
+
+#include <string.h>
+#include <iostream>
+
+using std::cout;
+using std::endl;
+
+/**
+ * Create an empty joint table
+ */
+JointTable::JointTable(){
+    clear();
+}
+
+/**
+ * Take a row for a new joint. If the table is full this hands back a spare row past
+ * the end, which keeps the joint usable through get and set but out of the loop.
+ * @param  kind What sort of joint owns the row
+ * @return      The row
+ */
+int JointTable::add(JOINT_KIND kind){
+    int row = rows;
+    bool spare = full();
+    if (spare)
+        cout << "Joint table is full. Joints past " << JOINT_TABLE_SIZE << " will not be driven." << endl;
+    else
+        rows++;
+
+    goal[row] = 0;
+    step[row] = 0;
+    velocity[row] = 0;
+    mode[row] = 0;
+    board[row] = -1;
+    index[row] = -1;
+    enabled[row] = false;
+    this->kind[row] = spare ? JOINT_FREE : kind;
+    component[row] = NULL;
+    return row;
+}
+
+/**
+ * Give a row back when its joint is destroyed. Rows are not reused until the table
+ * is cleared.
+ * @param row The row to release
+ */
+void JointTable::release(int row){
+    if (row < 0 || row > JOINT_TABLE_SIZE)
+        return;
+    kind[row] = JOINT_FREE;
+    component[row] = NULL;
+}
+
+/**
+ * Empty the table
+ */
+void JointTable::clear(){
+    rows = 0;
+    memset(kind, JOINT_FREE, sizeof(kind));
+    memset(component, 0, sizeof(component));
+}
+
+/**
+ * Get the number of rows handed out, including released ones
+ * @return The number of rows to look through
+ */
+int JointTable::size() const {
+    return rows;
+}
+
+/**
+ * See if the table has room for another joint
+ * @return True if it does not
+ */
+bool JointTable::full() const {
+    return rows >= JOINT_TABLE_SIZE;
+}
@@ -0,0 +1,295 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * Trajectories made of keyframes, evaluated a frame at a time.
+ */
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "KeyframeSource.h"
+
+/**
+ * @param  path Path to a trajectory file
+ * @return      True if the file is named as a keyframe trajectory
+ */
+bool isKeyframeTrajectory(const string &path){
+    size_t length = strlen(KEYFRAME_EXTENSION);
+    return path.size() >= length && path.compare(path.size() - length, length, KEYFRAME_EXTENSION) == 0;
+}
+
+/**
+ * @param  field A field of a keyframe file
+ * @return       True if the field starts a comment, which runs to the end of the line
+ */
+static bool isComment(const string &field){
+    return field[0] == '#' || field.compare(0, 2, "//") == 0;
+}
+
+/**
+ * Read a keyframe file and fit its splines. Check errored() afterwards.
+ * @param path Path to the file
+ */
+KeyframeSource::KeyframeSource(const string &path){
+    frame = 0;
+    if (!parse(path))
+        return;
+
+    double duration = 0;
+    for (int c = 0; c < splines.size(); c++){
+        fit(splines[c]);
+        duration = std::max(duration, splines[c].times.back());
+    }
+    _frames = (int)floor(duration * KEYFRAME_RATE + 1e-9) + 1;
+
+    evaluate(_frames - 1, _end);
+    locate(0);
+    evaluate(0, _start);
+    values = _start;
+}
+
+/**
+ * Destructor
+ */
+KeyframeSource::~KeyframeSource(){}
+
+/**
+ * @return The current frame, or NULL past the end
+ */
+const double* KeyframeSource::current(){
+    if (_error || frame >= _frames)
+        return NULL;
+    return &values[0];
+}
+
+/**
+ * Move to the next frame, evaluating every joint's spline at its time
+ * @return False past the end
+ */
+bool KeyframeSource::advance(){
+    if (_error || frame >= _frames)
+        return false;
+    frame++;
+    if (frame >= _frames)
+        return false;
+    evaluate(frame, values);
+    return true;
+}
+
+/**
+ * Go back to the first frame
+ * @return False on error
+ */
+bool KeyframeSource::rewind(){
+    return seek(0);
+}
+
+/**
+ * Go to a frame
+ * @param  frame The frame
+ * @return       False if there is no such frame, or on error
+ */
+bool KeyframeSource::seek(int frame){
+    if (_error || frame < 0 || frame >= _frames)
+        return false;
+    this->frame = frame;
+    locate(frame / KEYFRAME_RATE);
+    evaluate(frame, values);
+    return true;
+}
+
+/**
+ * @return Frames per second the keyframes are evaluated at
+ */
+double KeyframeSource::rate(){
+    return KEYFRAME_RATE;
+}
+
+/**
+ * Read the header and keyframes of a file
+ * @param  path Path to the file
+ * @return      True on success
+ */
+bool KeyframeSource::parse(const string &path){
+    std::ifstream file(path.c_str());
+    if (!file.is_open()){
+        fail("Trajectory Error: Unable to open keyframe file '" + path + "'");
+        return false;
+    }
+
+    string line;
+    string field;
+    int lineNumber = 0;
+    double last = -1;
+    while (getline(file, line)){
+        lineNumber++;
+        std::istringstream fields(line);
+        if (!(fields >> field) || isComment(field))
+            continue;
+
+        if (_orderedHeader.empty()){
+            if (field != KEYFRAME_TIME_COLUMN){
+                fail("Trajectory Error: The first column of keyframe file '" + path + "' must be " KEYFRAME_TIME_COLUMN);
+                return false;
+            }
+            while (fields >> field && !isComment(field)){
+                _header[field] = _orderedHeader.size();
+                _orderedHeader.push_back(field);
+            }
+            if (_orderedHeader.empty()){
+                fail("Trajectory Error: Keyframe file '" + path + "' has no joints");
+                return false;
+            }
+            splines.resize(_orderedHeader.size());
+            continue;
+        }
+
+        std::ostringstream where;
+        where << " In '" << path << "' [line " << lineNumber << "]";
+
+        char* end;
+        double time = strtod(field.c_str(), &end);
+        if (*end != '\0' || !(time >= 0) || time == HUGE_VAL || time <= last){
+            fail("Trajectory Error: Keyframe times must be numbers that go up from 0." + where.str());
+            return false;
+        }
+        if (!(time * KEYFRAME_RATE <= INT_MAX - 1)){
+            fail("Trajectory Error: Keyframe time is too long for a trajectory." + where.str());
+            return false;
+        }
+        last = time;
+
+        int col = 0;
+        for (; fields >> field && !isComment(field); col++){
+            if (col >= splines.size() || field == "-")
+                continue;
+
+            double value = strtod(field.c_str(), &end);
+            if (*end != '\0' || !(value == value) || fabs(value) == HUGE_VAL){
+                fail("Trajectory Error: Cannot convert '" + field + "' to a position." + where.str());
+                return false;
+            }
+            splines[col].times.push_back(time);
+            splines[col].values.push_back(value);
+        }
+        if (col != splines.size()){
+            std::ostringstream message;
+            message << "Trajectory Error: Wrong number of columns. Expected " << splines.size() + 1 << "." << where.str();
+            fail(message.str());
+            return false;
+        }
+    }
+
+    if (_orderedHeader.empty()){
+        fail("Trajectory Error: Keyframe file '" + path + "' has no header");
+        return false;
+    }
+    for (int c = 0; c < splines.size(); c++){
+        if (splines[c].times.empty()){
+            fail("Trajectory Error: Joint " + _orderedHeader[c] + " has no keyframes in '" + path + "'");
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Choose the slope at each keyframe of a joint. Slopes are the Fritsch-Carlson ones, so
+ * the spline is monotone between keyframes, and 0 at the first and last keyframes.
+ * @param spline The joint's keyframes
+ */
+void KeyframeSource::fit(Spline &spline){
+    int n = spline.times.size();
+    spline.slopes.assign(n, 0);
+    spline.segment = 0;
+
+    for (int k = 1; k + 1 < n; k++){
+        double before = spline.times[k] - spline.times[k - 1];
+        double after = spline.times[k + 1] - spline.times[k];
+        double rising = (spline.values[k] - spline.values[k - 1]) / before;
+        double falling = (spline.values[k + 1] - spline.values[k]) / after;
+
+        // A turning point, or flat on one side: stop there.
+        if (rising * falling <= 0)
+            continue;
+
+        double w1 = 2 * after + before;
+        double w2 = after + 2 * before;
+        spline.slopes[k] = (w1 + w2) / (w1 / rising + w2 / falling);
+    }
+}
+
+/**
+ * Find every joint's segment for a time
+ * @param time Seconds from the start
+ */
+void KeyframeSource::locate(double time){
+    for (int c = 0; c < splines.size(); c++){
+        Spline& spline = splines[c];
+        int after = std::upper_bound(spline.times.begin(), spline.times.end(), time) - spline.times.begin();
+        spline.segment = std::max(after - 1, 0);
+    }
+}
+
+/**
+ * Evaluate every joint at a frame. Segments only move forward, so playing frames in
+ * order costs a comparison or two per joint.
+ * @param frame  The frame
+ * @param values Set to the position of each joint
+ */
+void KeyframeSource::evaluate(int frame, Frame &values){
+    double time = frame / KEYFRAME_RATE;
+    values.resize(splines.size());
+
+    for (int c = 0; c < splines.size(); c++){
+        Spline& spline = splines[c];
+        int last = spline.times.size() - 1;
+        int& k = spline.segment;
+        while (k < last && spline.times[k + 1] <= time)
+            k++;
+
+        if (k == last || time <= spline.times[k]){
+            values[c] = spline.values[k];
+            continue;
+        }
+
+        double h = spline.times[k + 1] - spline.times[k];
+        double s = (time - spline.times[k]) / h;
+        double s2 = s * s;
+        double s3 = s2 * s;
+        values[c] = (2 * s3 - 3 * s2 + 1) * spline.values[k]
+            + (s3 - 2 * s2 + s) * h * spline.slopes[k]
+            + (-2 * s3 + 3 * s2) * spline.values[k + 1]
+            + (s3 - s2) * h * spline.slopes[k + 1];
+    }
+}
@@ -0,0 +1,187 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * A log-linear histogram for timing measurements. See LatencyHistogram.h
+ */
+
+#include "LatencyHistogram.h"
+
+#include <string.h>
+
+/**
+ * Create an empty histogram
+ */
+LatencyHistogram::LatencyHistogram(){
+    reset();
+}
+
+/**
+ * Add a measurement. Negative values are counted as zero and values past the top
+ * of the range end up in the last bucket.
+ * @param ns The measurement in nanoseconds
+ */
+void LatencyHistogram::record(int64_t ns){
+    if (ns < 0)
+        ns = 0;
+
+    counts[bucketFor(ns)]++;
+    sum += ns;
+    if (total == 0 || ns < minimum)
+        minimum = ns;
+    if (ns > maximum)
+        maximum = ns;
+    total++;
+}
+
+/**
+ * Clear all measurements
+ */
+void LatencyHistogram::reset(){
+    memset(counts, 0, sizeof(counts));
+    total = 0;
+    sum = 0;
+    minimum = 0;
+    maximum = 0;
+}
+
+/**
+ * Get the number of measurements
+ * @return The number of measurements
+ */
+int64_t LatencyHistogram::count() const {
+    return total;
+}
+
+/**
+ * Get the smallest measurement (exact, not bucketed)
+ * @return The smallest measurement in ns, 0 if empty
+ */
+int64_t LatencyHistogram::min() const {
+    return minimum;
+}
+
+/**
+ * Get the largest measurement (exact, not bucketed)
+ * @return The largest measurement in ns, 0 if empty
+ */
+int64_t LatencyHistogram::max() const {
+    return maximum;
+}
+
+/**
+ * Get the mean of all measurements (exact, not bucketed)
+ * @return The mean in ns, 0 if empty
+ */
+double LatencyHistogram::mean() const {
+    return total == 0 ? 0 : (double)sum / total;
+}
+
+/**
+ * Get the value below which the given fraction of measurements fall.
+ * @param  p The fraction, 0 to 1. (.99 for the 99th percentile)
+ * @return   The upper bound of the bucket holding that percentile in ns, capped at the max
+ */
+int64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0)
+        return 0;
+
+    int64_t target = (int64_t)(p * total + .5);
+    if (target < 1)
+        target = 1;
+
+    int64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++){
+        seen += counts[i];
+        if (seen >= target){
+            int64_t value = bucketUpperBound(i);
+            return value > maximum ? maximum : value;
+        }
+    }
+    return maximum;
+}
+
+/**
+ * Get the number of buckets
+ * @return The number of buckets
+ */
+int LatencyHistogram::numBuckets() const {
+    return HISTOGRAM_BUCKETS;
+}
+
+/**
+ * Get the number of measurements in one bucket
+ * @param  bucket The bucket index
+ * @return        The count
+ */
+int64_t LatencyHistogram::bucketCount(int bucket) const {
+    return counts[bucket];
+}
+
+/**
+ * Get the smallest value that lands in a bucket
+ * @param  bucket The bucket index
+ * @return        The lower bound in ns
+ */
+int64_t LatencyHistogram::bucketLowerBound(int bucket) const {
+    int magnitude = bucket / SUB_BUCKETS;
+    int64_t offset = bucket % SUB_BUCKETS;
+    if (magnitude == 0)
+        return offset;
+    return (SUB_BUCKETS + offset) << (magnitude - 1);
+}
+
+/**
+ * Get the largest value that lands in a bucket
+ * @param  bucket The bucket index
+ * @return        The upper bound in ns
+ */
+int64_t LatencyHistogram::bucketUpperBound(int bucket) const {
+    int magnitude = bucket / SUB_BUCKETS;
+    if (magnitude == 0)
+        return bucketLowerBound(bucket);
+    return bucketLowerBound(bucket) + ((int64_t)1 << (magnitude - 1)) - 1;
+}
+
+/**
+ * Find the bucket a value belongs in. Values below SUB_BUCKETS get a bucket each,
+ * above that each power of two is split into SUB_BUCKETS buckets.
+ * @param  ns The value
+ * @return    The bucket index
+ */
+int LatencyHistogram::bucketFor(int64_t ns){
+    if (ns < SUB_BUCKETS)
+        return (int)ns;
+
+    int msb = 63 - __builtin_clzll((unsigned long long)ns);
+    int magnitude = msb - SUB_BUCKET_BITS + 1;
+    if (magnitude >= MAGNITUDES)
+        return HISTOGRAM_BUCKETS - 1;
+
+    int offset = (int)(ns >> (msb - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+    return magnitude * SUB_BUCKETS + offset;
+}
@@ -0,0 +1,240 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * The control loop's log. The loop is the only producer of the ring buffer and the
+ * drain thread the only consumer, so neither side takes a lock.
+ */
+
+#include "LoopLog.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <iostream>
+
+using std::cout;
+using std::endl;
+
+static const char *LEVEL_NAMES[] = {"debug", "info", "warn", "error"};
+static const char *LEVEL_TAGS[] = {"Debug: ", "", "", ""};
+
+/**
+ * Create the log. Until setLoopThread() is called everything is printed directly.
+ */
+LoopLog::LoopLog(){
+    haveLoopThread = false;
+    running = false;
+    level = LOG_INFO;
+    dropped = 0;
+    reported = 0;
+}
+
+/**
+ * Destructor
+ */
+LoopLog::~LoopLog(){
+    stop();
+}
+
+/**
+ * Start the drain thread. Start it before the loop makes itself real time, so that the
+ * thread keeps a normal priority.
+ */
+void LoopLog::start(){
+    if (running)
+        return;
+    running = true;
+    thread = boost::thread(&LoopLog::run, this);
+}
+
+/**
+ * Stop the drain thread, printing whatever is still queued. Messages from the loop are
+ * printed directly again afterwards.
+ */
+void LoopLog::stop(){
+    if (!running)
+        return;
+    running = false;
+    thread.join();
+    haveLoopThread = false;
+    drain();
+}
+
+/**
+ * Mark the calling thread as the loop. Its messages go through the ring buffer from
+ * now on, as long as the drain thread is running.
+ */
+void LoopLog::setLoopThread(){
+    loopThread = pthread_self();
+    __sync_synchronize();
+    haveLoopThread = true;
+}
+
+/**
+ * Set the lowest level that gets logged
+ * @param level The level
+ */
+void LoopLog::setLevel(LOG_LEVEL level){
+    this->level = level;
+}
+
+/**
+ * Set the lowest level that gets logged
+ * @param  name debug, info, warn or error
+ * @return      False if the name is not a level
+ */
+bool LoopLog::setLevel(const char *name){
+    for (int i = LOG_DEBUG; i <= LOG_ERROR; i++){
+        if (strcasecmp(name, LEVEL_NAMES[i]) == 0){
+            level = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @param  level A level
+ * @return       True if messages at that level are logged
+ */
+bool LoopLog::enabled(LOG_LEVEL level){
+    return level >= this->level;
+}
+
+/**
+ * Log a message. On the loop thread the message is formatted straight into the ring
+ * buffer; if its call site has used up its burst, or the ring is full, it is counted
+ * and dropped. On any other thread it is printed.
+ * @param site   The call site's rate limit state
+ * @param level  How serious it is
+ * @param format printf style format
+ */
+void LoopLog::write(LogSite &site, LOG_LEVEL level, const char *format, ...){
+    if (!enabled(level))
+        return;
+
+    va_list args;
+    if (!running || !haveLoopThread || !pthread_equal(pthread_self(), loopThread)){
+        char text[LOG_LINE_LENGTH];
+        va_start(args, format);
+        vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        cout << LEVEL_TAGS[level] << text << endl;
+        return;
+    }
+
+    int64_t t = now();
+    if (site.tokens < LOG_BURST && t - site.refilled >= LOG_REFILL_NS){
+        int64_t earned = (t - site.refilled) / LOG_REFILL_NS;
+        site.tokens = earned >= LOG_BURST - site.tokens ? LOG_BURST : site.tokens + (int)earned;
+        site.refilled = t;
+    }
+    if (site.tokens == 0){
+        site.suppressed++;
+        return;
+    }
+
+    LogEntry* entry = ring.claim();
+    if (entry == NULL){
+        dropped++;
+        return;
+    }
+    if (site.tokens == LOG_BURST)
+        site.refilled = t;  // The refill clock starts with the first message of a burst
+    site.tokens--;
+
+    entry->level = level;
+    entry->suppressed = site.suppressed;
+    site.suppressed = 0;
+    va_start(args, format);
+    vsnprintf(entry->text, sizeof(entry->text), format, args);
+    va_end(args);
+    ring.commit();
+}
+
+/**
+ * @return The number of messages lost because the ring buffer was full
+ */
+int64_t LoopLog::numDropped(){
+    return dropped;
+}
+
+/**
+ * The drain thread. Prints what the loop has logged every LOG_DRAIN_PERIOD_US.
+ */
+void LoopLog::run(){
+    while (running){
+        drain();
+        usleep(LOG_DRAIN_PERIOD_US);
+    }
+}
+
+/**
+ * Print everything in the ring buffer. Consumer side only.
+ */
+void LoopLog::drain(){
+    LogEntry* entry;
+    bool printed = false;
+    while ((entry = ring.front()) != NULL){
+        print(*entry);
+        ring.release();
+        printed = true;
+    }
+
+    int64_t lost = dropped;
+    if (lost != reported){
+        cout << "Warning: Loop log full. " << lost - reported << " messages lost." << endl;
+        reported = lost;
+        printed = true;
+    }
+    if (printed)
+        cout.flush();
+}
+
+/**
+ * Print one message
+ * @param entry The message
+ */
+void LoopLog::print(const LogEntry &entry){
+    cout << LEVEL_TAGS[entry.level] << entry.text;
+    if (entry.suppressed != 0)
+        cout << " (" << entry.suppressed << " similar messages suppressed)";
+    cout << '\n';
+}
+
+/**
+ * @return The CLOCK_MONOTONIC time in nanoseconds
+ */
+int64_t LoopLog::now(){
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
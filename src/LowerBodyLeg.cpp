@@ -33,6 +33,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
 #include "../include/LowerBodyLeg.h"
+#include "../include/LoopLog.h"
 
 const int LowerBodyLeg::NUM_PARAMETERS = 6;
 const int LowerBodyLeg::NUM_CONTROLLED = 6;
@@ -188,12 +189,12 @@ void LowerBodyLeg::setHipRollXYZ(double foot_x, double foot_y, double foot_z, do
     ankle_pitch = -hip_pitch - knee_pitch;
 
     if ( isnan(foot_yaw) || isnan(hip_roll) || isnan(hip_pitch) || isnan(knee_pitch) || isnan(ankle_pitch) || isnan(ankle_roll) ){
-        cout << "Error: Inverse solver returned NaN" << endl;
+        LOOP_LOG(LOG_ERROR, "Error: Inverse solver returned NaN");
         return;
     }
 
     if (hip_roll < HIP_ROLL_LOWER || hip_roll > HIP_ROLL_UPPER || hip_pitch < HIP_PITCH_LOWER || hip_pitch > HIP_PITCH_UPPER || knee_pitch < KNEE_PITCH_LOWER || knee_pitch > KNEE_PITCH_UPPER || ankle_pitch < ANKLE_PITCH_LOWER || ankle_pitch > ANKLE_PITCH_UPPER || ankle_roll < ANKLE_ROLL_LOWER || ankle_roll > ANKLE_ROLL_UPPER){
-        cout << "Error: One or more joints out of joint limits" << endl;
+        LOOP_LOG(LOG_ERROR, "Error: One or more joints out of joint limits");
         return;
     }
 
@@ -0,0 +1,203 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * A binary trajectory file read through mmap.
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MappedSource.h"
+
+/**
+ * Map a binary trajectory file and check its header. Check errored() afterwards.
+ * @param path Path to the file
+ */
+MappedSource::MappedSource(const string &path){
+    map = MAP_FAILED;
+    mapSize = 0;
+    data = NULL;
+    valueSize = sizeof(double);
+    _rate = 0;
+    frame = 0;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        fail("Trajectory Error: Unable to open file '" + path + "'");
+        return;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size >= sizeof(BinaryTrajectoryHeader)){
+        mapSize = info.st_size;
+        map = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (map == MAP_FAILED){
+        fail("Trajectory Error: Unable to map file '" + path + "'");
+        return;
+    }
+
+    const BinaryTrajectoryHeader* header = (const BinaryTrajectoryHeader*)map;
+    if (memcmp(header->magic, BINARY_TRAJECTORY_MAGIC, BINARY_TRAJECTORY_MAGIC_SIZE) != 0
+            || header->version != BINARY_TRAJECTORY_VERSION){
+        fail("Trajectory Error: '" + path + "' is not a binary trajectory this version can read");
+        return;
+    }
+
+    valueSize = header->valueSize;
+    size_t dataOffset = sizeof(BinaryTrajectoryHeader) + header->namesSize;
+    if ((valueSize != sizeof(double) && valueSize != sizeof(float)) || header->numCols == 0
+            || header->numFrames == 0 || dataOffset % sizeof(double) != 0 || dataOffset > mapSize
+            || header->numFrames > (mapSize - dataOffset) / ((size_t)header->numCols * valueSize)){
+        fail("Trajectory Error: '" + path + "' is truncated or malformed");
+        return;
+    }
+
+    // Column names are '\0' terminated, one after the other.
+    const char* name = (const char*)map + sizeof(BinaryTrajectoryHeader);
+    const char* namesEnd = name + header->namesSize;
+    for (int i = 0; i < header->numCols; i++){
+        const char* end = (const char*)memchr(name, '\0', namesEnd - name);
+        if (end == NULL){
+            fail("Trajectory Error: '" + path + "' has a malformed header");
+            return;
+        }
+        _orderedHeader.push_back(string(name, end));
+        _header[_orderedHeader.back()] = i;
+        name = end + 1;
+    }
+
+    data = (const char*)map + dataOffset;
+    _frames = header->numFrames;
+    _rate = header->rate;
+
+    // Start reading the frames in now, so the loop does not fault on them later.
+    madvise(map, mapSize, MADV_SEQUENTIAL);
+    madvise(map, mapSize, MADV_WILLNEED);
+
+    int cols = header->numCols;
+    _start.resize(cols);
+    _end.resize(cols);
+    widened.resize(cols);
+    for (int i = 0; i < cols; i++){
+        if (valueSize == sizeof(double)){
+            _start[i] = ((const double*)row(0))[i];
+            _end[i] = ((const double*)row(_frames - 1))[i];
+        } else {
+            _start[i] = ((const float*)row(0))[i];
+            _end[i] = ((const float*)row(_frames - 1))[i];
+        }
+    }
+    widen();
+}
+
+/**
+ * Destructor. Unmaps the file.
+ */
+MappedSource::~MappedSource(){
+    if (map != MAP_FAILED)
+        munmap(map, mapSize);
+}
+
+/**
+ * @return The current frame, or NULL past the end
+ */
+const double* MappedSource::current(){
+    if (_error || frame >= _frames)
+        return NULL;
+    if (valueSize == sizeof(double))
+        return (const double*)row(frame);
+    return &widened[0];
+}
+
+/**
+ * Move to the next frame
+ * @return False past the end
+ */
+bool MappedSource::advance(){
+    if (_error || frame >= _frames)
+        return false;
+    frame++;
+    widen();
+    return frame < _frames;
+}
+
+/**
+ * Go back to the first frame
+ * @return False on error
+ */
+bool MappedSource::rewind(){
+    if (_error)
+        return false;
+    frame = 0;
+    widen();
+    return true;
+}
+
+/**
+ * Go to a frame. Its offset in the file follows from its number.
+ * @param  frame The frame
+ * @return       False if there is no such frame, or on error
+ */
+bool MappedSource::seek(int frame){
+    if (_error || frame < 0 || frame >= _frames)
+        return false;
+    this->frame = frame;
+    widen();
+    return true;
+}
+
+/**
+ * @return Frames per second the file was recorded at, or 0 if unknown
+ */
+double MappedSource::rate(){
+    return _rate;
+}
+
+/**
+ * Convert the current frame to doubles, if the file holds floats
+ */
+void MappedSource::widen(){
+    if (valueSize != sizeof(float) || frame >= _frames)
+        return;
+    const float* values = (const float*)row(frame);
+    for (int i = 0; i < widened.size(); i++)
+        widened[i] = values[i];
+}
+
+/**
+ * @param  frame A frame number
+ * @return       Where that frame starts in the map
+ */
+const char* MappedSource::row(int frame){
+    return data + (size_t)frame * _start.size() * valueSize;
+}
@@ -34,8 +34,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /**
  * Create a metajoint and tell it it's controller
+ * @param controller The controller this metajoint is a parameter of
+ * @param table      The joint table to keep the metajoint's goal and step in
  */
-MetaJoint::MetaJoint(MetaJointController* controller){
+MetaJoint::MetaJoint(MetaJointController* controller, JointTable& table) : Interpolable(table, JOINT_META) {
+    table.component[row] = this;
     this->controller = controller;
     this->position = 0;
     this->ready = false;
@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
 #include "MetaJointController.h"
+#include "LoopLog.h"
 
 /**
  * Create a meta joint controller
@@ -54,7 +55,7 @@ void MetaJointController::addParameter(RobotComponent* parameter){
     if (parameters.size() < NUM_PARAMETERS)
         parameters.push_back(parameter);
     else
-        cout << "Attempt to add parameter " << parameter->getName() << " to already full meta joint controller." << endl;
+        LOOP_LOG(LOG_ERROR, "Attempt to add parameter %s to already full meta joint controller.", parameter->getName().c_str());
 }
 
 /**
@@ -65,7 +66,7 @@ void MetaJointController::addControlledJoint(RobotComponent* controlledJoint){
     if (controlledJoints.size() < NUM_CONTROLLED)
         controlledJoints.push_back(controlledJoint);
     else
-        cout << "Attempt to add joint " << controlledJoint->getName() << " to already full meta joint controller." << endl;
+        LOOP_LOG(LOG_ERROR, "Attempt to add joint %s to already full meta joint controller.", controlledJoint->getName().c_str());
 }
 
 /**
@@ -0,0 +1,147 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * A caller blocked until the control loop sees a set of components reach their goals.
+ */
+
+#include "MotionWaiter.h"
+
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+#include "ros/ros.h"
+
+// How often a waiter with no timeout checks whether it should give up anyway
+#define MOTION_WAIT_SLICE .1
+
+/**
+ * Create a waiter with no components.
+ * @param tolerance How close to its goal a component has to be. 0 or less uses
+ *                  the same tolerance as requiresMotion.
+ */
+MotionWaiter::MotionWaiter(double tolerance){
+    this->tolerance = tolerance > 0 ? tolerance : DEFAULT_MOTION_TOLERANCE;
+    count = 0;
+    result = false;
+    sem_init(&done, 0, 0);
+}
+
+/**
+ * Destructor
+ */
+MotionWaiter::~MotionWaiter(){
+    sem_destroy(&done);
+}
+
+/**
+ * Add a component to wait for.
+ * @param  component The component
+ * @return           False if the waiter already has MOTION_WAIT_COMPONENTS of them
+ */
+bool MotionWaiter::add(RobotComponent* component){
+    if (count >= MOTION_WAIT_COMPONENTS)
+        return false;
+    components[count++] = component;
+    return true;
+}
+
+/**
+ * Forget the components, for when they are about to be deleted.
+ */
+void MotionWaiter::clear(){
+    count = 0;
+}
+
+/**
+ * Check whether every component is within tolerance of its goal. Loop side only.
+ * @return True if they all are
+ */
+bool MotionWaiter::arrived(){
+    double position, goal;
+    for (int i = 0; i < count; i++){
+        if (!components[i]->get(POSITION, position) || !components[i]->get(GOAL, goal))
+            return false;
+        if (fabs(position - goal) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Wake the caller. sem_post never blocks, so this is safe to call from the loop.
+ * @param arrived Whether the components got to their goals
+ */
+void MotionWaiter::finish(bool arrived){
+    result = arrived;
+    sem_post(&done);
+}
+
+/**
+ * Block until the loop calls finish() or the timeout runs out. Not for the loop.
+ * @param  timeout Seconds to wait. 0 or less waits until ROS shuts down.
+ * @return         True if finish() was called, false on timeout
+ */
+bool MotionWaiter::wait(double timeout){
+    timespec start;
+    clock_gettime(CLOCK_REALTIME, &start);
+    double waited = 0;
+
+    while (true){
+        double slice = MOTION_WAIT_SLICE;
+        if (timeout > 0 && timeout - waited < slice)
+            slice = timeout - waited;
+
+        timespec until = start;
+        double end = waited + slice;
+        until.tv_sec += (time_t)end;
+        until.tv_nsec += (long)((end - floor(end)) * 1e9);
+        if (until.tv_nsec >= 1000000000){
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000;
+        }
+
+        if (sem_timedwait(&done, &until) == 0)
+            return true;
+        if (errno == EINTR)
+            continue;
+
+        waited = end;
+        if (timeout > 0 && waited >= timeout)
+            return false;
+        if (!ros::ok())
+            return false;
+    }
+}
+
+/**
+ * @return Whether the loop reported the components as arrived
+ */
+bool MotionWaiter::succeeded(){
+    return result;
+}
@@ -32,63 +32,143 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "Names.h"
 
+#include <string.h>
+
+namespace {
+
+struct PropertyName {
+    const char* name;
+    PROPERTY property;
+};
+
+struct CommandName {
+    const char* name;
+    COMMAND command;
+};
+
+// Both tables must stay sorted by strcmp (capitals before lower case), since they
+// are binary searched.
+const PropertyName PROPERTY_NAMES[] = {
+    {"PWMSaturatedError", PWM_SATURATED_ERROR},
+    {"accelerationError", ACCELERATION_ERROR},
+    {"bigError", BIG_ERROR},
+    {"driveFaultError", DRIVE_FAULT_ERROR},
+    {"enabled", ENABLED},
+    {"encoderError", ENC_ERROR},
+    {"errored", ERRORED},
+    {"f_z", F_Z},
+    {"goal", GOAL},
+    {"goal_time", GOAL_TIME},
+    {"homed", HOMED},
+    {"inter_step", INTERPOLATION_STEP},
+    {"jamError", JAM_ERROR},
+    {"m_x", M_X},
+    {"m_y", M_Y},
+    {"meta_value", META_VALUE},
+    {"motion_type", MOTION_TYPE},
+    {"posMaxError", POS_MAX_ERROR},
+    {"posMinError", POS_MIN_ERROR},
+    {"position", POSITION},
+    {"ready", READY},
+    {"speed", SPEED},
+    {"temp", TEMPERATURE},
+    {"tempError", TEMP_ERROR},
+    {"velocity", VELOCITY},
+    {"velocityError", VELOCITY_ERROR},
+    {"x_acc", X_ACCEL},
+    {"x_rot", X_ROTAT},
+    {"y_acc", Y_ACCEL},
+    {"y_rot", Y_ROTAT},
+    {"z_acc", Z_ACCEL},
+    {"zeroed", ZEROED}
+};
+
+const CommandName COMMAND_NAMES[] = {
+    {"BalanceOff", BALANCEOFF},
+    {"BalanceOn", BALANCEON},
+    {"Disable", DISABLE},
+    {"DisableAll", DISABLEALL},
+    {"Enable", ENABLE},
+    {"EnableAll", ENABLEALL},
+    {"Home", HOME},
+    {"HomeAll", HOMEALL},
+    {"InitializeSensors", INITSENSORS},
+    {"ProfileOff", PROFILEOFF},
+    {"ProfileOn", PROFILEON},
+    {"ResetAll", RESETALL},
+    {"ResetJoint", RESET},
+    {"Update", UPDATE},
+    {"Zero", ZERO},
+    {"ZeroAll", ZEROALL}
+};
+
+const int NUM_PROPERTY_NAMES = sizeof(PROPERTY_NAMES) / sizeof(PROPERTY_NAMES[0]);
+const int NUM_COMMAND_NAMES = sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]);
+
 /**
- * Initialize all of the properties
+ * Binary search one of the name tables
+ * @param  table The table, sorted by name
+ * @param  size  Number of entries in the table
+ * @param  name  The name to find
+ * @return       The index of the entry, or -1 if it is not there
  */
-void Names::initPropertyMap(){
-    std::cout << "Called initPropertyMap" << std::endl;
-    getProperties()["position"] = POSITION;
-    getProperties()["goal"] = GOAL;
-    getProperties()["speed"] = SPEED;
-    getProperties()["inter_step"] = INTERPOLATION_STEP;
-    getProperties()["velocity"] = VELOCITY;
-    getProperties()["goal_time"] = GOAL_TIME;
-    getProperties()["motion_type"] = MOTION_TYPE;
-    getProperties()["temp"] = TEMPERATURE;
-    getProperties()["homed"] = HOMED;
-    getProperties()["zeroed"] = ZEROED;
-    getProperties()["enabled"] = ENABLED;
-    getProperties()["errored"] = ERRORED;
-    getProperties()["jamError"] = JAM_ERROR;
-    getProperties()["PWMSaturatedError"] = PWM_SATURATED_ERROR;
-    getProperties()["bigError"] = BIG_ERROR;
-    getProperties()["encoderError"] = ENC_ERROR;
-    getProperties()["driveFaultError"] = DRIVE_FAULT_ERROR;
-    getProperties()["posMinError"] = POS_MIN_ERROR;
-    getProperties()["posMaxError"] = POS_MAX_ERROR;
-    getProperties()["velocityError"] = VELOCITY_ERROR;
-    getProperties()["accelerationError"] = ACCELERATION_ERROR;
-    getProperties()["tempError"] = TEMP_ERROR;
-    getProperties()["x_acc"] = X_ACCEL;
-    getProperties()["y_acc"] = Y_ACCEL;
-    getProperties()["z_acc"] = Z_ACCEL;
-    getProperties()["x_rot"] = X_ROTAT;
-    getProperties()["y_rot"] = Y_ROTAT;
-    getProperties()["m_x"] = M_X;
-    getProperties()["m_y"] = M_Y;
-    getProperties()["f_z"] = F_Z;
-    getProperties()["meta_value"] = META_VALUE;
-    getProperties()["ready"] = READY;
+template <typename Entry>
+int search(const Entry* table, int size, const char* name){
+    int low = 0;
+    int high = size - 1;
+    while (low <= high){
+        int mid = (low + high) / 2;
+        int cmp = strcmp(table[mid].name, name);
+        if (cmp == 0)
+            return mid;
+        if (cmp < 0)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return -1;
+}
+
 }
 
 /**
- * Initialize all of the commands
+ * Find the property with the given name or alias
+ * @param  name     The name of the property
+ * @param  property Set to the property if it is found
+ * @return          True if the name is a property
  */
-void Names::initCommandMap(){
-    getCommands()["Enable"] = ENABLE;
-    getCommands()["EnableAll"] = ENABLEALL;
-    getCommands()["Disable"] = DISABLE;
-    getCommands()["DisableAll"] = DISABLEALL;
-    getCommands()["ResetJoint"] = RESET;
-    getCommands()["ResetAll"] = RESETALL;
-    getCommands()["Home"] = HOME;
-    getCommands()["HomeAll"] = HOMEALL;
-    getCommands()["InitializeSensors"] = INITSENSORS;
-    getCommands()["Update"] = UPDATE;
-    getCommands()["Zero"] = ZERO;
-    getCommands()["ZeroAll"] = ZEROALL;
-    getCommands()["BalanceOn"] = BALANCEON;
-    getCommands()["BalanceOff"] = BALANCEOFF;
+bool Names::lookup(const string &name, PROPERTY &property){
+    int i = search(PROPERTY_NAMES, NUM_PROPERTY_NAMES, name.c_str());
+    if (i != -1){
+        property = PROPERTY_NAMES[i].property;
+        return true;
+    }
+
+    Properties::const_iterator it = getPropertyAliases().find(name);
+    if (it == getPropertyAliases().end())
+        return false;
+    property = it->second;
+    return true;
+}
+
+/**
+ * Find the command with the given name or alias
+ * @param  name    The name of the command
+ * @param  command Set to the command if it is found
+ * @return         True if the name is a command
+ */
+bool Names::lookup(const string &name, COMMAND &command){
+    int i = search(COMMAND_NAMES, NUM_COMMAND_NAMES, name.c_str());
+    if (i != -1){
+        command = COMMAND_NAMES[i].command;
+        return true;
+    }
+
+    Commands::const_iterator it = getCommandAliases().find(name);
+    if (it == getCommandAliases().end())
+        return false;
+    command = it->second;
+    return true;
 }
 
 /**
@@ -97,12 +177,17 @@ void Names::initCommandMap(){
  * @param  alias The alias to replace it with 
  * @return       True on success
  */
-bool Names::setAlias(string name, string alias){
-    if (getProperties().count(name) == 1 && getProperties().count(alias) == 0) {
-        getProperties()[alias] = getProperties()[name];
+bool Names::setAlias(const string &name, const string &alias){
+    PROPERTY property;
+    COMMAND command;
+    if (lookup(alias, property) || lookup(alias, command))
+        return false;
+
+    if (lookup(name, property)) {
+        getPropertyAliases()[alias] = property;
         return true;
-    } else if (getCommands().count(name) == 1 && getProperties().count(alias) == 0) {
-        getCommands()[alias] = getCommands()[name];
+    } else if (lookup(name, command)) {
+        getCommandAliases()[alias] = command;
         return true;
     }
     return false;
@@ -113,10 +198,10 @@ bool Names::setAlias(string name, string alias){
  * @param  property The enum version of the property
  * @return          The string representation of the property
  */
-string Names::getName(PROPERTY &property){
-    for (Properties::iterator it = getProperties().begin(); it != getProperties().end(); it++){
-        if (it->second == property)
-            return it->first;
+const char* Names::getName(PROPERTY property){
+    for (int i = 0; i < NUM_PROPERTY_NAMES; i++){
+        if (PROPERTY_NAMES[i].property == property)
+            return PROPERTY_NAMES[i].name;
     }
     return "NULL PROPERTY";
 }
@@ -126,10 +211,10 @@ string Names::getName(PROPERTY &property){
  * @param  command The enum version of the command
  * @return          The string representation of the command
  */
-string Names::getName(COMMAND &command){
-    for (Commands::iterator it = getCommands().begin(); it != getCommands().end(); it++){
-        if (it->second == command)
-            return it->first;
+const char* Names::getName(COMMAND command){
+    for (int i = 0; i < NUM_COMMAND_NAMES; i++){
+        if (COMMAND_NAMES[i].command == command)
+            return COMMAND_NAMES[i].name;
     }
-    return "NUlL COMMAND";
+    return "NULL COMMAND";
 }
@@ -0,0 +1,140 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * A trajectory file held entirely in memory.
+ */
+
+#include "PreloadedSource.h"
+
+/**
+ * Parse every frame of a file. Check errored() afterwards.
+ * @param file The file, opened for reading. It can be closed once this returns.
+ */
+PreloadedSource::PreloadedSource(WSVFile &file){
+    describe(file);
+    frame = 0;
+    values = NULL;
+
+    FrameData* data = new FrameData;
+    int cols = file.numCols();
+    data->values.reserve((size_t)file.numLines() * cols);
+    while (file.loadBuffer()){
+        WSVFile::Buffer& buffer = file.buffer();
+        for (int r = 0; r < buffer.size(); r++)
+            data->values.insert(data->values.end(), buffer[r].begin(), buffer[r].end());
+    }
+
+    if (file.errored()){
+        delete data;
+        fail(file.getError());
+        return;
+    }
+    _frames = cols == 0 ? 0 : data->values.size() / cols;
+
+    data->header = _header;
+    data->orderedHeader = _orderedHeader;
+    data->start = _start;
+    data->end = _end;
+    data->frames = _frames;
+    use(Data(data));
+}
+
+/**
+ * Play frames that have already been parsed, sharing them with every other source that does.
+ * @param data The parsed file
+ */
+PreloadedSource::PreloadedSource(const Data &data){
+    _header = data->header;
+    _orderedHeader = data->orderedHeader;
+    _start = data->start;
+    _end = data->end;
+    _frames = data->frames;
+    frame = 0;
+    use(data);
+}
+
+/**
+ * Destructor
+ */
+PreloadedSource::~PreloadedSource(){}
+
+/**
+ * @return The current frame, or NULL past the end
+ */
+const double* PreloadedSource::current(){
+    if (frame >= _frames)
+        return NULL;
+    return values + (size_t)frame * _start.size();
+}
+
+/**
+ * Move to the next frame
+ * @return False past the end
+ */
+bool PreloadedSource::advance(){
+    if (frame < _frames)
+        frame++;
+    return frame < _frames;
+}
+
+/**
+ * Go back to the first frame
+ * @return True
+ */
+bool PreloadedSource::rewind(){
+    frame = 0;
+    return !_error;
+}
+
+/**
+ * Go to a frame
+ * @param  frame The frame
+ * @return       False if there is no such frame
+ */
+bool PreloadedSource::seek(int frame){
+    if (_error || frame < 0 || frame >= _frames)
+        return false;
+    this->frame = frame;
+    return true;
+}
+
+/**
+ * @return The parsed file, or nothing if parsing failed
+ */
+const PreloadedSource::Data& PreloadedSource::data(){
+    return parsed;
+}
+
+/**
+ * Play from parsed frames
+ * @param data The parsed file
+ */
+void PreloadedSource::use(const Data &data){
+    parsed = data;
+    values = data->values.empty() ? NULL : &data->values[0];
+}
@@ -31,21 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
 #include "../include/ReferenceChannel.h"
-
-/**
- * list of all the joints 
- */
-const char *ReferenceChannel::urdf_joint_names[] = {
-        "WST", "NKY", "NK1", "NK2",
-        "LSP", "LSR", "LSY", "LEP", "LWY", "LWR", "LWP",
-        "RSP", "RSR", "RSY", "REP", "RWY", "RWR", "RWP",
-        "UNUSED1",
-        "LHY", "LHR", "LHP", "LKP", "LAP", "LAR",
-        "UNUSED2",
-        "RHY", "RHR", "RHP", "RKP", "RAP", "RAR",
-        "RF1", "RF2", "RF3", "RF4", "RF5",
-        "LF1", "LF2", "LF3", "LF4", "LF5",
-        "unknown1", "unknown2", "unknown3", "unknown4", "unknown5", "unknown6", "unknown7", "unknown8"};
+#include "../include/LoopLog.h"
 
 /**
  * Constructor that initializes the ach channel
@@ -72,15 +58,7 @@ ReferenceChannel::~ReferenceChannel() {}
  * @return       The index of the joint
  */
 int ReferenceChannel::indexLookup(string &joint) {
-    if (joint.length() != 3)
-        return -1;
-    int best_match = -1;
-
-    for (int i = 0; i < HUBO_JOINT_COUNT; i++) {
-        if (strcmp(joint.c_str(), urdf_joint_names[i]) == 0)
-            best_match = i;
-    }
-    return best_match;
+    return JointRegistry::instance()->indexOf(joint);
 }
 
 /**
@@ -95,11 +73,11 @@ void ReferenceChannel::load(){
     int r = ach_get(&huboReferenceChannel, &temp, sizeof(temp), &fs, NULL, ACH_O_LAST);
 
     if(ACH_OK != r && ACH_MISSED_FRAME != r && ACH_STALE_FRAMES != r) {
-        cout << "Error! Reference Channel failed with state " << r << endl;
+        LOOP_LOG(LOG_ERROR, "Error! Reference Channel failed with state %d", r);
         errored = true;
     } else if (ACH_STALE_FRAMES != r){
         if (sizeof(temp) != fs) {
-            cout << "Error! File size inconsistent with state struct! fs = " << fs << " sizeof currentReference: " << sizeof(temp) << endl;
+            LOOP_LOG(LOG_ERROR, "Error! File size inconsistent with state struct! fs = %lu sizeof currentReference: %lu", (unsigned long)fs, (unsigned long)sizeof(temp));
             errored = true;
             return;
         }
@@ -117,11 +95,21 @@ void ReferenceChannel::load(){
  */
 void ReferenceChannel::setReference(string &joint, double rad, Mode mode){
 	if (errored) return;
-	int index = indexLookup(joint);
-	if (index != -1){
-		currentReference.ref[index] = rad;
-        currentReference.mode[index] = 1;
-    }
+	setReference(indexLookup(joint), rad, mode);
+}
+
+/**
+ * Set the reference of a joint to a position in radians. This is the one to use from
+ * the loop, with the index looked up beforehand in the JointRegistry.
+ * 
+ * @param index The hubo-ach index of the joint, or -1 to do nothing
+ * @param rad   The position in radians
+ * @param mode  The mode of joint operation
+ */
+void ReferenceChannel::setReference(int index, double rad, Mode mode){
+	if (errored || index < 0 || index >= HUBO_JOINT_COUNT) return;
+	currentReference.ref[index] = rad;
+    currentReference.mode[index] = 1;
 }
 
 /**
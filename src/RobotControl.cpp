@@ -25,6 +25,7 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "RobotControl.h"
+#include "LoopLog.h"
 
 /**
  * Creates the Robot Control object. This initializes a lot of the important variables but it does not
@@ -42,6 +43,9 @@ RobotControl::RobotControl(){
     }
 
     this->state = HuboState::instance();
+    this->building = HuboState::spare();
+    ftSensors.reserve(STATE_MAX_SENSORS);
+    imus.reserve(STATE_MAX_SENSORS);
 
 
     this->written = 0;
@@ -51,9 +55,6 @@ RobotControl::RobotControl(){
     this->interpolation = true;    //Interpret all commands as a final destination with given velocity.
     this->override = true;        //Force homing before allowing enabling. (currently disabled)
     this->balanceOn = false;
-    
-    Names::initPropertyMap();
-    Names::initCommandMap();
 
     //ostringstream logfile;
     //logfile << "RobotControl.log";
@@ -65,6 +66,9 @@ RobotControl::RobotControl(){
 
     frames = 0;
     trajStarted = false;
+    handleGeneration = 0;
+    robotGeneration = 0;
+    numWaiters = 0;
 }
 
 /**
@@ -83,84 +87,44 @@ RobotControl::~RobotControl(){
 void RobotControl::updateHook(){
     if (state == NULL)
         return;
+    profiler.begin();
     if(RUN_TYPE == SIMULATION){
         simChannels->load();
+        profiler.mark(STAGE_SIM_LOAD);
     }
     referenceChannel->load();
+    profiler.mark(STAGE_REFERENCE_LOAD);
     stateChannel->load();
+    profiler.mark(STAGE_STATE_LOAD);
 
     trajStarted = trajectories.hasRunning();
 
-    Components components = state->getComponents();
-    Trajectory* traj = NULL;
-    RobotComponent* component = NULL;
+    const Components& components = state->getComponents();
 
     if (!components.empty()) {
         if(balanceOn){
             balancer->Balance();
+            profiler.mark(STAGE_BALANCE);
         }
-        for (int i = 0; i < components.size(); i++){
-            component = components[i];
-            double enabled;
-            if (!component->get(ENABLED, enabled))
-                continue;
-            traj = trajectories.inRunning(component->getName());
-
-            if ((bool)enabled){
-                double pos = 0;
-
-                double mode = HUBO_REF_MODE_REF_FILTER;
-                component->get(MOTION_TYPE, mode);
-                if ((hubo_mode_type_t)mode == HUBO_REF_MODE_COMPLIANT){
-                    // Compliance
-                    component->get(POSITION, pos);
-                    component->set(INTERPOLATION_STEP, pos);
-                    component->set(GOAL, pos);
-                } else if (trajStarted && traj){
-                    // Trajectory Playback
-                    component->get(GOAL, pos);
-                    component->set(MOTION_TYPE, HUBO_REF_MODE_REF);
-                    if (!traj->nextPosition(component->getName(), pos) && !traj->hasNext()){
-                        cout << "Reading of trajectory positions has terminated." << endl << "> ";
-                        cout.flush(); 
-                        trajectories.stopTrajectory(traj);
-                        trajStarted = trajectories.hasRunning();
-                    }
-                    component->set(GOAL, pos);
-                    component->get(INTERPOLATION_STEP, pos);
-
-                } else if (interpolation){
-                    component->get(INTERPOLATION_STEP, pos);
-                    power->addMotionPower(component->getName(), 1/PERIOD); 
-                    component->set(MOTION_TYPE, HUBO_REF_MODE_REF);
-                } else {
-                    component->get(GOAL, pos);
-                }
-                component->get(MOTION_TYPE, mode);
-                //tempOutput << component->getName() << ": " << pos << endl;
-                referenceChannel->setReference(component->getName(), pos, (hubo_mode_type_t)mode);
-                string key(WRITE_KEY);
-                traj = trajectories.get(key);
-                if (trajStarted && traj){
-                    double currPos = 0;
-                    component->get(POSITION, currPos);
-
-                    if (traj->contains(component->getName()) && !traj->nextPosition(component->getName(), currPos)){
-                        cout << "Writing of trajectory positions has terminated." << endl << "> ";
-                        cout.flush(); // Fixing flushing issue with the deployer, maybe....
-                        trajectories.stopTrajectory(traj);
-                        trajStarted = trajectories.hasRunning();
-                    }
-                }
 
-                while (!trajectories.getCurrentTriggers().empty()){
-                    startTrajectory(trajectories.getCurrentTriggers().front());
-                    trajectories.getCurrentTriggers().pop();
-                }
-            }   
+        // Metajoints go first, since they set the goals of the motors they control.
+        const MetaJoints& metaJoints = state->getMetaJoints();
+        for (int i = 0; i < metaJoints.size(); i++)
+            driveMetaJoint(metaJoints[i]);
+
+        // Then a straight pass down the motor rows of the joint table. Motors are not
+        // checked for being enabled: HuboMotor::get(ENABLED) has always reported true, so
+        // every motor has always been driven.
+        JointTable& joints = state->getJointTable();
+        for (int row = 0; row < joints.size(); row++){
+            if (joints.kind[row] == JOINT_MOTOR)
+                driveMotor(joints, row);
         }
-        if (trajStarted)
+        profiler.mark(STAGE_COMPONENTS);
+        if (trajStarted){
             trajectories.advanceFrame();
+            profiler.mark(STAGE_TRAJECTORY_ADVANCE);
+        }
     }
 
     power->addMotionPower("IDLE", PERIOD); 
@@ -168,6 +132,197 @@ void RobotControl::updateHook(){
 
     //Write out a message if we have one
     referenceChannel->update();
+    profiler.mark(STAGE_REFERENCE_UPDATE);
+    checkWaiters();
+    profiler.end();
+}
+
+/**
+ * Get the profiler that times the stages of the update hook. Only touch it from the loop.
+ * @return The profiler
+ */
+StageProfiler& RobotControl::getProfiler(){
+    return profiler;
+}
+
+/**
+ * Copy the state of the motors, the sensors and the balance controller into a snapshot.
+ * Metajoints are left out, since reading their position runs the forward kinematics.
+ * Only call this from the loop. It does not allocate.
+ * @param snapshot Filled with the state, in the order given by getStateLayout
+ */
+void RobotControl::snapshotState(StateSnapshot &snapshot){
+    snapshot.generation = robotGeneration;
+    snapshot.numJoints = 0;
+    snapshot.numFT = 0;
+    snapshot.numIMU = 0;
+
+    JointTable& joints = state->getJointTable();
+    for (int row = 0; row < joints.size(); row++){
+        if (joints.kind[row] != JOINT_MOTOR)
+            continue;
+        int i = snapshot.numJoints++;
+        if (!joints.component[row]->get(POSITION, snapshot.position[i]))
+            snapshot.position[i] = 0;
+        snapshot.goal[i] = joints.goal[row];
+        snapshot.step[i] = joints.step[row];
+        snapshot.enabled[i] = joints.enabled[row];
+    }
+
+    static const PROPERTY ftFields[NUM_FT_FIELDS] = {M_X, M_Y, F_Z};
+    for (int i = 0; i < ftSensors.size(); i++){
+        for (int f = 0; f < NUM_FT_FIELDS; f++){
+            if (!ftSensors[i]->get(ftFields[f], snapshot.ft[i][f]))
+                snapshot.ft[i][f] = 0;
+        }
+    }
+    snapshot.numFT = ftSensors.size();
+
+    static const PROPERTY imuFields[NUM_IMU_FIELDS] = {X_ACCEL, Y_ACCEL, Z_ACCEL, X_ROTAT, Y_ROTAT};
+    for (int i = 0; i < imus.size(); i++){
+        for (int f = 0; f < NUM_IMU_FIELDS; f++){
+            if (!imus[i]->get(imuFields[f], snapshot.imu[i][f]))
+                snapshot.imu[i][f] = 0;
+        }
+    }
+    snapshot.numIMU = imus.size();
+
+    snapshot.balancing = balanceOn;
+    snapshot.zmp[0] = balancer->getZMP(0);
+    snapshot.zmp[1] = balancer->getZMP(1);
+}
+
+/**
+ * Get the names that go with the values in snapshotState.
+ * @param layout Filled with the names and the generation they belong to
+ */
+void RobotControl::getStateLayout(StateLayout &layout){
+    layout.generation = robotGeneration;
+    layout.joints.clear();
+    layout.ftSensors.clear();
+    layout.imus.clear();
+
+    JointTable& joints = state->getJointTable();
+    for (int row = 0; row < joints.size(); row++){
+        if (joints.kind[row] == JOINT_MOTOR)
+            layout.joints.push_back(joints.component[row]->getName());
+    }
+    for (int i = 0; i < ftSensors.size(); i++)
+        layout.ftSensors.push_back(ftSensors[i]->getName());
+    for (int i = 0; i < imus.size(); i++)
+        layout.imus.push_back(imus[i]->getName());
+}
+
+/**
+ * Work out this tick's reference for a metajoint and send it. Metajoints go through the
+ * general get/set interface, since asking for their step is what runs their controller.
+ * @param component The metajoint
+ */
+void RobotControl::driveMetaJoint(MetaJoint* component){
+    double enabled;
+    if (!component->get(ENABLED, enabled) || !(bool)enabled)
+        return;
+
+    Trajectory* traj = trajStarted ? trajectories.inRunning(component->getRow()) : NULL;
+    double pos = 0;
+
+    double mode = HUBO_REF_MODE_REF_FILTER;
+    component->get(MOTION_TYPE, mode);
+    if ((hubo_mode_type_t)mode == HUBO_REF_MODE_COMPLIANT){
+        // Compliance
+        component->get(POSITION, pos);
+        component->set(INTERPOLATION_STEP, pos);
+        component->set(GOAL, pos);
+    } else if (trajStarted && traj){
+        // Trajectory Playback
+        component->get(GOAL, pos);
+        component->set(MOTION_TYPE, HUBO_REF_MODE_REF);
+        if (!traj->nextPosition(component->getRow(), pos) && !traj->hasNext()){
+            LOOP_LOG(LOG_INFO, "Reading of trajectory positions has terminated.");
+            trajectories.stopTrajectory(traj);
+            trajStarted = trajectories.hasRunning();
+        }
+        component->set(GOAL, pos);
+        component->get(INTERPOLATION_STEP, pos);
+
+    } else if (interpolation){
+        component->get(INTERPOLATION_STEP, pos);
+        power->addMotionPower(component->getName(), 1/PERIOD); 
+        component->set(MOTION_TYPE, HUBO_REF_MODE_REF);
+    } else {
+        component->get(GOAL, pos);
+    }
+    component->get(MOTION_TYPE, mode);
+    referenceChannel->setReference(state->getJointTable().index[component->getRow()], pos, (hubo_mode_type_t)mode);
+
+    finishJoint(component, component->getRow());
+}
+
+/**
+ * Work out this tick's reference for a motor and send it. The goal, step and mode come
+ * straight out of the joint table.
+ * @param joints The joint table
+ * @param row    The motor's row
+ */
+void RobotControl::driveMotor(JointTable& joints, int row){
+    HuboMotor* motor = static_cast<HuboMotor*>(joints.component[row]);
+    Trajectory* traj = trajStarted ? trajectories.inRunning(row) : NULL;
+    double pos = 0;
+
+    if (joints.mode[row] == HUBO_REF_MODE_COMPLIANT){
+        // Compliance
+        motor->get(POSITION, pos);
+        motor->set(INTERPOLATION_STEP, pos);
+        motor->set(GOAL, pos);
+    } else if (trajStarted && traj){
+        // Trajectory Playback
+        pos = joints.goal[row];
+        joints.mode[row] = HUBO_REF_MODE_REF;
+        if (!traj->nextPosition(row, pos) && !traj->hasNext()){
+            LOOP_LOG(LOG_INFO, "Reading of trajectory positions has terminated.");
+            trajectories.stopTrajectory(traj);
+            trajStarted = trajectories.hasRunning();
+        }
+        motor->set(GOAL, pos);
+        pos = motor->interpolate();
+
+    } else if (interpolation){
+        pos = motor->interpolate();
+        power->addMotionPower(motor->getName(), 1/PERIOD); 
+        joints.mode[row] = HUBO_REF_MODE_REF;
+    } else {
+        pos = joints.goal[row];
+    }
+    referenceChannel->setReference(joints.index[row], pos, (hubo_mode_type_t)joints.mode[row]);
+
+    finishJoint(motor, row);
+}
+
+/**
+ * Record a joint's position to the trajectory being written, if there is one, and start
+ * any trajectories that have been triggered.
+ * @param component The joint that was just driven
+ * @param row       Its row in the joint table
+ */
+void RobotControl::finishJoint(RobotComponent* component, int row){
+    if (trajStarted){
+        Trajectory* traj = trajectories.getWriting();
+        if (traj){
+            double currPos = 0;
+            component->get(POSITION, currPos);
+
+            if (traj->contains(row) && !traj->nextPosition(row, currPos)){
+                LOOP_LOG(LOG_INFO, "Writing of trajectory positions has terminated.");
+                trajectories.stopTrajectory(traj);
+                trajStarted = trajectories.hasRunning();
+            }
+        }
+    }
+
+    while (!trajectories.getCurrentTriggers().empty()){
+        startTrajectory(trajectories.getCurrentTriggers().front());
+        trajectories.getCurrentTriggers().pop();
+    }
 }
 
 /**
@@ -189,6 +344,17 @@ bool RobotControl::loadTrajectory(string name, string path, bool read){
     return trajectories.loadTrajectory(name, path, read);
 }
 
+/**
+ * Add a trajectory that has already been loaded under the given name. 
+ * @param  name     The name to give the trajectory
+ * @param  traj     The loaded trajectory. Owned by maestor on success.
+ * @param  replaced Set to any trajectory that was loaded under the same name, for the caller to delete
+ * @return          true on success
+ */
+bool RobotControl::addTrajectory(string name, Trajectory* traj, Trajectory*& replaced){
+    return trajectories.addTrajectory(name, traj, replaced);
+}
+
 /**
  * Ignore the column from the trajectory
  * @param  name The name of the trajcetory
@@ -239,27 +405,78 @@ bool RobotControl::setTrigger(string name, int frame, string target){
 }
 
 /**
- * Extend the trajectory that is all ready loaded by the trajectory that 
- * is located at the path specified. 
+ * Make a loaded trajectory play over and over
  * @param  name Name of the loaded trajectory
- * @param  path The path to the trajectory that you want at the end of the first
+ * @param  loop True to loop, false to let it end
  * @return      True on success
  */
-bool RobotControl::extendTrajectory(string name, string path){
-    return trajectories.extendTrajectory(name, path);
+bool RobotControl::loopTrajectory(string name, bool loop){
+    return trajectories.loopTrajectory(name, loop);
 }
 
 /**
- * Start a loaded trajectory. 
- * @param name The name of the trajectory to start. 
+ * Send a loaded trajectory to a frame
+ * @param  name  Name of the loaded trajectory
+ * @param  frame The frame to play next
+ * @return       True on success
  */
-void RobotControl::startTrajectory(string name){
+bool RobotControl::seekTrajectory(string name, int frame){
+    return trajectories.seekTrajectory(name, frame);
+}
+
+/**
+ * Set how fast a loaded trajectory plays
+ * @param  name Name of the loaded trajectory
+ * @param  rate Frames to play each tick. 1 plays it as recorded.
+ * @return      True on success
+ */
+bool RobotControl::setTrajectoryRate(string name, double rate){
+    return trajectories.setTrajectoryRate(name, rate);
+}
+
+/**
+ * Check whether a loaded trajectory is still reading the frame it was sent to
+ * @param  name Name of the loaded trajectory
+ * @return      True until the frame has been read
+ */
+bool RobotControl::seekingTrajectory(string name){
+    Trajectory* traj = trajectories.get(name);
+    return traj != NULL && traj->seeking();
+}
+
+/**
+ * Extend the trajectory that is all ready loaded by a trajectory file that 
+ * has already been opened. 
+ * @param  name   Name of the loaded trajectory
+ * @param  source The opened file that you want at the end of the first. Owned by the trajectory on success.
+ * @return        True on success
+ */
+bool RobotControl::extendTrajectory(string name, FrameSource* source){
+    return trajectories.extendTrajectory(name, source);
+}
+
+/**
+ * Start a loaded trajectory from the frame it is at (the first, unless it was sent elsewhere).
+ * @param  name The name of the trajectory to start.
+ * @return      True if it was started
+ */
+bool RobotControl::startTrajectory(string name){
     Trajectory* traj = NULL;
 
     traj = trajectories.get(name);
     if (traj == NULL){
-        std::cout << "No trajectory with name " << name << " loaded." << endl;
-        return;
+        LOOP_LOG(LOG_WARN, "No trajectory with name %s loaded.", name.c_str());
+        return false;
+    }
+
+    if (!traj->is_open()){
+        LOOP_LOG(LOG_ERROR, "Cannot start non-open trajectory %s. A recording may still be being written.", name.c_str());
+        return false;
+    }
+
+    if (traj->seeking()){
+        LOOP_LOG(LOG_ERROR, "Cannot start trajectory %s. The frame it was sent to has not been read yet.", name.c_str());
+        return false;
     }
 
     Components components = state->getComponents();
@@ -275,14 +492,17 @@ void RobotControl::startTrajectory(string name){
                     continue;
 
                 if (!(bool)enabled){
-                    cout << "Cannot start trajectory: references disabled motor " << name << endl;
-                    return;
+                    LOOP_LOG(LOG_ERROR, "Cannot start trajectory: references disabled motor %s", name.c_str());
+                    return false;
                 }
                 double pos;
+                double from;
                 component->get(POSITION, pos);
-                if (fabs(pos - traj->startPosition(name)) > .1){
-                    cout << "Cannot start trajectory: motor " << name << " should be at " << traj->startPosition(name) << endl;
-                    return;
+                if (!traj->nextPosition(name, from))
+                    from = traj->startPosition(name);
+                if (fabs(pos - from) > .1){
+                    LOOP_LOG(LOG_ERROR, "Cannot start trajectory: motor %s should be at %g", name.c_str(), from);
+                    return false;
                 }
             }
         }
@@ -303,7 +523,8 @@ void RobotControl::startTrajectory(string name){
         traj->setHeader(header);
     }
 
-    trajectories.startTrajectory(name);
+    traj->bindJoints(state->getJointTable());
+    return trajectories.startTrajectory(name);
 }
 
 /**
@@ -332,7 +553,7 @@ string RobotControl::getDefaultInitPath(string path){
         getline(is, temp, '\n');
         is.close();
     } else
-        cout << "Error. Config file nonexistent. Aborting." << endl;
+        LOOP_LOG(LOG_ERROR, "Error. Config file nonexistent. Aborting.");
 
     return temp;
 }
@@ -343,42 +564,114 @@ string RobotControl::getDefaultInitPath(string path){
  * @param path The path to the xml config file
  */
 void RobotControl::initRobot(string path){
-    if (strcmp(path.c_str(), "") == 0)
-    {
-        path = getDefaultInitPath(CONFIG_PATH);
-    }
-    
-    this->state->initHuboWithDefaults(path, 1/PERIOD);  
+    xml_document doc;
+    if (!loadConfig(path, doc))
+        return;
+
+    initRobot(doc);
+}
+
+/**
+ * Initialize the MAESTOR system from an XML configuration that has already been read
+ * with loadConfig.
+ * @param doc The parsed xml config file
+ */
+void RobotControl::initRobot(xml_document& doc){
+    buildRobot(doc);
+    swapRobot();
+}
+
+/**
+ * Build the robot from an XML configuration into the spare state. The loop never touches
+ * the spare, so this can be done off the loop. It also deletes the robot that was in use
+ * before the last swapRobot.
+ * @param doc The parsed xml config file
+ */
+void RobotControl::buildRobot(xml_document& doc){
+    building->initHuboFromDocument(doc, 1/PERIOD);
+}
+
+/**
+ * Put the robot from buildRobot in use, and point everything that referred to the old one
+ * at it instead. The old one becomes the spare, to be deleted by the next buildRobot.
+ */
+void RobotControl::swapRobot(){
+    clearHandles(); // The components they point to are no longer in use
+    cancelWaiters();
+    HuboState* old = this->state;
+    this->state = building;
+    building = old;
+    this->state->registerAliases();
     balancer->initBalanceController(*(this->state));
+    trajectories.rebindJoints(this->state->getJointTable());
+
+    ftSensors.clear();
+    imus.clear();
+    const Components& components = state->getComponents();
+    for (int i = 0; i < components.size(); i++){
+        if (dynamic_cast<FTSensorBoard*>(components[i]) != NULL && ftSensors.size() < STATE_MAX_SENSORS)
+            ftSensors.push_back(components[i]);
+        else if (dynamic_cast<IMUBoard*>(components[i]) != NULL && imus.size() < STATE_MAX_SENSORS)
+            imus.push_back(components[i]);
+    }
+    robotGeneration++;
 
     if (this->state == NULL)
     {
-        std::cout << "Error. Initializing robot failed. Robot state is null." << std::endl;
+        LOOP_LOG(LOG_ERROR, "Error. Initializing robot failed. Robot state is null.");
     }
 
 }
 
+/**
+ * Read and parse an XML configuration file. This does not touch the robot, so it can
+ * be done away from the control loop. Empty string defaults to the default config path.
+ * @param  path The path to the xml config file
+ * @param  doc  The document to parse the file into
+ * @return      True on success
+ */
+bool RobotControl::loadConfig(string path, xml_document& doc){
+    if (strcmp(path.c_str(), "") == 0)
+    {
+        path = getDefaultInitPath(CONFIG_PATH);
+    }
+
+    if (!doc.load_file(path.c_str())){
+        LOOP_LOG(LOG_ERROR, "No such file, %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
 /**
  * This is the set properties method. It sets a components property to the value. 
  * @param name     The name of the robot component
  * @param property Name of the property to be set
  * @param value    Value to set to the property
  */
-void RobotControl::set(string name, string property, double value){
-    if (!state->nameExists(name)){
-        cout << "Error. No component with name " << name << " registered. Aborting." << endl;
+void RobotControl::set(const string &name, const string &property, double value){
+    PROPERTY prop;
+    if (!Names::lookup(property, prop)){
+        LOOP_LOG(LOG_ERROR, "Error. No property with name %s registered. Aborting.", property.c_str());
         return;
     }
 
-    Properties properties = Names::getProps();
-
-    if (properties.count(property) == 0){
-        cout << "Error. No property with name " << property << " registered. Aborting." << endl;
+    RobotComponent* component = getComponent(name);
+    if (component == NULL)
         return;
-    }
 
-    if (!state->getComponent(name)->set(properties[property], value)){
-        cout << "Error setting property " << property << " of component " << name << endl;
+    set(component, prop, value);
+}
+
+/**
+ * Set a property of a component that have both been looked up already
+ * @param component The robot component
+ * @param property  The property to be set
+ * @param value     Value to set to the property
+ */
+void RobotControl::set(RobotComponent* component, PROPERTY property, double value){
+    if (!component->set(property, value)){
+        LOOP_LOG(LOG_ERROR, "Error setting property %s of component %s", Names::getName(property), component->getName().c_str());
         return;
     }
 }
@@ -391,23 +684,96 @@ void RobotControl::set(string name, string property, double value){
  * @param values     Space delimited string of values
  */
 void RobotControl::setProperties(string names, string properties, string values){
+    PropertyUpdates updates;
+    if (prepareProperties(names, properties, values, updates))
+        setProperties(updates);
+}
+
+/**
+ * Set multiple properties on multiple robot components to multiple values, given as arrays
+ * so nothing has to be split or parsed. All three must be the same length.
+ * @param names      Names of the robot components
+ * @param properties Names of the properties
+ * @param values     Values to set the properties to
+ * @return           False if the sizes do not match
+ */
+bool RobotControl::setPropertiesBatch(const vector<string> &names, const vector<string> &properties, const vector<double> &values){
+    PropertyUpdates updates;
+    if (!prepareProperties(names, properties, values, updates))
+        return false;
+
+    setProperties(updates);
+    return true;
+}
+
+/**
+ * Split and parse the space delimited form of setProperties, and look the components and
+ * properties up. Nothing on the robot is changed, so it can be done off the loop.
+ * @param names      Space delimited string of robot component names
+ * @param properties Space delimited string of properties
+ * @param values     Space delimited string of values
+ * @param updates    Filled with the sets to make. Unknown components and properties are left out.
+ * @return           False if the sizes do not match
+ */
+bool RobotControl::prepareProperties(const string &names, const string &properties, const string &values, PropertyUpdates &updates){
     vector<string> namesList = splitFields(names);
     vector<string> propertiesList = splitFields(properties);
     vector<string> valuesList = splitFields(values);
     if (namesList.size() != propertiesList.size()
             || namesList.size() != valuesList.size()
             || propertiesList.size() != valuesList.size()){
-        cout << "Error! Size of entered fields not consistent. Aborting." << endl;
-        return;
+        LOOP_LOG(LOG_ERROR, "Error! Size of entered fields not consistent. Aborting.");
+        return false;
     }
 
-    for (int i = 0; i < namesList.size(); i++){
-        istringstream data(valuesList[i]);
-        double value = 0;
-        data >> value;
+    vector<double> parsed(valuesList.size());
+    for (int i = 0; i < valuesList.size(); i++)
+        parsed[i] = strtod(valuesList[i].c_str(), NULL);
+    return prepareProperties(namesList, propertiesList, parsed, updates);
+}
 
-        set(namesList[i], propertiesList[i], value);
+/**
+ * Look up the components and properties for a batch of sets. Nothing on the robot is
+ * changed, so it can be done off the loop.
+ * @param names      Names of the robot components
+ * @param properties Names of the properties
+ * @param values     Values to set the properties to
+ * @param updates    Filled with the sets to make. Unknown components and properties are left out.
+ * @return           False if the sizes do not match
+ */
+bool RobotControl::prepareProperties(const vector<string> &names, const vector<string> &properties, const vector<double> &values, PropertyUpdates &updates){
+    if (names.size() != properties.size() || names.size() != values.size()){
+        LOOP_LOG(LOG_ERROR, "Error! Size of entered fields not consistent. Aborting.");
+        return false;
     }
+
+    updates.components.reserve(names.size());
+    updates.properties.reserve(names.size());
+    updates.values.reserve(names.size());
+    for (int i = 0; i < names.size(); i++){
+        PROPERTY prop;
+        if (!Names::lookup(properties[i], prop)){
+            LOOP_LOG(LOG_ERROR, "Error. No property with name %s registered. Aborting.", properties[i].c_str());
+            continue;
+        }
+        RobotComponent* component = getComponent(names[i]);
+        if (component == NULL)
+            continue;
+
+        updates.components.push_back(component);
+        updates.properties.push_back(prop);
+        updates.values.push_back(values[i]);
+    }
+    return true;
+}
+
+/**
+ * Make sets that prepareProperties has already looked up
+ * @param updates The sets to make
+ */
+void RobotControl::setProperties(const PropertyUpdates &updates){
+    for (int i = 0; i < updates.components.size(); i++)
+        set(updates.components[i], updates.properties[i], updates.values[i]);
 }
 
 /**
@@ -416,7 +782,7 @@ void RobotControl::setProperties(string names, string properties, string values)
  * @param  property Name of the property
  * @return          Value of the property for that robot component
  */
-double RobotControl::get(string name, string property){
+double RobotControl::get(const string &name, const string &property){
     
     double result = 0;
 
@@ -428,27 +794,27 @@ double RobotControl::get(string name, string property){
             result = balancer->getZMP(1);
         }
         else{
-            cout << "Error getting property " << property << " of component " << name << endl;
+            LOOP_LOG(LOG_ERROR, "Error getting property %s of component %s", property.c_str(), name.c_str());
             return 0;
         }
         return result;
     }
 
 
-    if (!state->nameExists(name)){
-        cout << "Error. No component with name " << name << " registered. Aborting." << endl;
+    RobotComponent* component = state->getComponent(name);
+    if (component == NULL){
+        LOOP_LOG(LOG_ERROR, "Error. No component with name %s registered. Aborting.", name.c_str());
         return 0;
     }
 
-    Properties properties = Names::getProps();
-
-    if (properties.count(property) == 0){
-        cout << "Error. No property with name " << property << " registered. Aborting." << endl;
+    PROPERTY prop;
+    if (!Names::lookup(property, prop)){
+        LOOP_LOG(LOG_ERROR, "Error. No property with name %s registered. Aborting.", property.c_str());
         return 0;
     }
 
-    if (!state->getComponent(name)->get(properties[property], result)){
-        cout << "Error getting property " << property << " of component " << name << endl;
+    if (!component->get(prop, result)){
+        LOOP_LOG(LOG_ERROR, "Error getting property %s of component %s", property.c_str(), name.c_str());
         return 0;
     }
 
@@ -464,13 +830,81 @@ double RobotControl::get(string name, string property){
  * @return            A space delimited string of values for each property it found
  */
 string RobotControl::getProperties(string name, string properties) {
+    PropertyQuery propertyQuery;
+    prepareQuery(name, properties, propertyQuery);
+    query(propertyQuery);
+    return formatQuery(propertyQuery);
+}
+
+/**
+ * Split and look up a getProperties request. Nothing on the robot is read, so it can be
+ * done off the loop.
+ * @param name       Name of the robot component, or ZMP
+ * @param properties Space delimited string of properties, or X and Y for the ZMP
+ * @param query      Filled with what to read. Values start out as 0.
+ */
+void RobotControl::prepareQuery(const string &name, const string &properties, PropertyQuery &query){
     vector<string> propertyList = splitFields(properties);
+    query.properties.assign(propertyList.size(), -1);
+    query.values.assign(propertyList.size(), 0);
+
+    if (name.compare("ZMP") == 0){
+        query.component = NULL;
+        for (int i = 0; i < propertyList.size(); i++){
+            if (propertyList[i].compare("X") == 0)
+                query.properties[i] = 0;
+            else if (propertyList[i].compare("Y") == 0)
+                query.properties[i] = 1;
+            else
+                LOOP_LOG(LOG_ERROR, "Error getting property %s of component %s", propertyList[i].c_str(), name.c_str());
+        }
+        return;
+    }
+
+    // With no component, every property stays -1 and reads as 0.
+    query.component = getComponent(name);
+    if (query.component == NULL)
+        return;
+
+    for (int i = 0; i < propertyList.size(); i++){
+        PROPERTY prop;
+        if (Names::lookup(propertyList[i], prop))
+            query.properties[i] = prop;
+        else
+            LOOP_LOG(LOG_ERROR, "Error. No property with name %s registered. Aborting.", propertyList[i].c_str());
+    }
+}
+
+/**
+ * Read the values for a query from prepareQuery
+ * @param query The query. Its values are filled in.
+ */
+void RobotControl::query(PropertyQuery &query){
+    for (int i = 0; i < query.properties.size(); i++){
+        if (query.properties[i] == -1)
+            continue;
+
+        if (query.component == NULL){
+            query.values[i] = balancer->getZMP(query.properties[i]);
+        } else if (!query.component->get((PROPERTY)query.properties[i], query.values[i])){
+            LOOP_LOG(LOG_ERROR, "Error getting property %s of component %s",
+                Names::getName((PROPERTY)query.properties[i]), query.component->getName().c_str());
+            query.values[i] = 0;
+        }
+    }
+}
+
+/**
+ * Format the values of a query as getProperties returns them
+ * @param  query The query, after query()
+ * @return       The values, separated by commas
+ */
+string RobotControl::formatQuery(const PropertyQuery &query){
     ostringstream values;
-    for (int i = 0; i < propertyList.size(); ++i)
+    for (int i = 0; i < query.values.size(); ++i)
     {
-        double tmp = get(name, propertyList[i]);
-        values << tmp;
-        if(i + 1 != propertyList.size())
+        values << query.values[i];
+        if(i + 1 != query.values.size())
         {
             values << ", ";
         }
@@ -478,39 +912,172 @@ string RobotControl::getProperties(string name, string properties) {
     return values.str();
 }
 
+/**
+ * Find a robot component by name. Apart from the loop, only the service thread that
+ * initRobot and setAlias are called from may use this, since only calls from that thread
+ * change which components there are.
+ * @param  name Name of the robot component
+ * @return      The component, or NULL if there is none by that name
+ */
+RobotComponent* RobotControl::getComponent(const string &name){
+    RobotComponent* component = state->getComponent(name);
+    if (component == NULL)
+        LOOP_LOG(LOG_ERROR, "Error. No component with name %s registered. Aborting.", name.c_str());
+    return component;
+}
+
+/**
+ * Resolve a component and property to a handle that can be used with setByHandle and
+ * getByHandle. Asking for the same pair again gives the same handle. Handles stop
+ * working when the robot is initialized again.
+ * @param  name     Name of the robot component
+ * @param  property Name of the property
+ * @return          The handle, or -1 if the component or property does not exist
+ */
+int RobotControl::resolveHandle(const string &name, const string &property){
+    PROPERTY prop;
+    if (!Names::lookup(property, prop)){
+        LOOP_LOG(LOG_ERROR, "Error. No property with name %s registered. Aborting.", property.c_str());
+        return -1;
+    }
+
+    RobotComponent* component = getComponent(name);
+    if (component == NULL)
+        return -1;
+
+    return resolveHandle(component, prop);
+}
+
+/**
+ * Resolve a component and a property that have both been looked up already to a handle
+ * @param  component The robot component
+ * @param  prop      The property
+ * @return           The handle, or -1 if there are no handles left
+ */
+int RobotControl::resolveHandle(RobotComponent* component, PROPERTY prop){
+    pair< RobotComponent*, int > key(component, prop);
+    int index;
+    map< pair< RobotComponent*, int >, int >::iterator it = handleLookup.find(key);
+    if (it != handleLookup.end()){
+        index = it->second;
+    } else {
+        if (handles.size() > HANDLE_INDEX_MASK){
+            LOOP_LOG(LOG_ERROR, "Error. Out of handles. Aborting.");
+            return -1;
+        }
+        Handle handle;
+        handle.component = component;
+        handle.property = prop;
+        index = handles.size();
+        handles.push_back(handle);
+        handleLookup[key] = index;
+    }
+
+    return ((handleGeneration & HANDLE_GENERATION_MASK) << HANDLE_INDEX_BITS) | index;
+}
+
+/**
+ * Set a property through a handle from resolveHandle
+ * @param  handle The handle
+ * @param  value  Value to set the property to
+ * @return        False if the handle is not valid or the set failed
+ */
+bool RobotControl::setByHandle(int handle, double value){
+    Handle* h = findHandle(handle);
+    return h != NULL && h->component->set(h->property, value);
+}
+
+/**
+ * Get a property through a handle from resolveHandle
+ * @param  handle The handle
+ * @param  value  Set to the value of the property
+ * @return        False if the handle is not valid or the get failed
+ */
+bool RobotControl::getByHandle(int handle, double &value){
+    Handle* h = findHandle(handle);
+    return h != NULL && h->component->get(h->property, value);
+}
+
+/**
+ * Check a handle and find what it refers to
+ * @param  handle The handle
+ * @return        The component and property, or NULL if the handle is not valid
+ */
+RobotControl::Handle* RobotControl::findHandle(int handle){
+    if (handle < 0 || ((handle >> HANDLE_INDEX_BITS) & HANDLE_GENERATION_MASK) != (handleGeneration & HANDLE_GENERATION_MASK))
+        return NULL;
+    int index = handle & HANDLE_INDEX_MASK;
+    if (index >= handles.size())
+        return NULL;
+    return &handles[index];
+}
+
+/**
+ * Forget all handles. Ones already handed out will be refused from now on.
+ */
+void RobotControl::clearHandles(){
+    handles.clear();
+    handleLookup.clear();
+    handleGeneration++;
+}
+
 /**
  * Run the command that is passed in. If it has a joint target run it on that joint. 
  * @param name   Name of the command to run
  * @param target Optional Joint target
  */
 void RobotControl::command(string name, string target){
-    Commands commands = Names::getComms();
-    RobotComponent* component = NULL;
-    double temp;
-
+    Command comm;
+    if (prepareCommand(name, target, comm))
+        command(comm);
+}
 
-    if (commands.count(name) == 0){
-        cout << "Error. No command with name " << name << " is defined for RobotControl. Aborting." << endl << "> ";
-        cout.flush();
-        return;
+/**
+ * Look up a command and its target. Nothing on the robot is changed, so it can be done
+ * off the loop.
+ * @param  name   Name of the command to run
+ * @param  target Optional Joint target
+ * @param  comm   Filled with the command to run
+ * @return        False if the command or its target does not exist
+ */
+bool RobotControl::prepareCommand(const string &name, const string &target, Command &comm){
+    if (!Names::lookup(name, comm.command)){
+        LOOP_LOG(LOG_ERROR, "Error. No command with name %s is defined for RobotControl. Aborting.", name.c_str());
+        return false;
     }
 
-    switch (commands[name]){
+    comm.component = NULL;
+    comm.target = target;
+    switch (comm.command){
     case ENABLE:
-        if (!state->nameExists(target)){
-            cout << "Error. Component with name " << target << " is not on record. Aborting." << endl << "> ";
-            cout.flush();
-            return;
+    case DISABLE:
+    case RESET:
+    case HOME:
+    case ZERO:
+        comm.component = state->getComponent(target);
+        if (comm.component == NULL){
+            LOOP_LOG(LOG_ERROR, "Error. Component with name %s is not on record. Aborting.", target.c_str());
+            return false;
         }
+        break;
+    default:
+        break;
+    }
+    return true;
+}
 
-        if (!this->commandChannel->enable(target)){
-            cout << "Enable command failed. Aborting." << endl;
-            return;
-        }
+/**
+ * Run a command from prepareCommand
+ * @param comm The command
+ */
+void RobotControl::command(const Command &comm){
+    RobotComponent* component = comm.component;
+    double temp;
 
-        component = state->getComponent(target);
-        if (component == NULL){
-            cout << "Error retrieving component with name " << target << endl;
+    switch (comm.command){
+    case ENABLE:
+        if (!this->commandChannel->enable(comm.target)){
+            LOOP_LOG(LOG_ERROR, "Enable command failed. Aborting.");
             return;
         }
 
@@ -524,7 +1091,7 @@ void RobotControl::command(string name, string target){
     case ENABLEALL:
 
         if (!this->commandChannel->enable("all")){
-            cout << "Enable command failed. Aborting." << endl;
+            LOOP_LOG(LOG_ERROR, "Enable command failed. Aborting.");
             return;
         }
 
@@ -538,20 +1105,8 @@ void RobotControl::command(string name, string target){
 
         break;
     case DISABLE:
-        if (!state->nameExists(target)){
-            cout << "Error. Component with name " << target << " is not on record. Aborting." << endl << "> ";
-            cout.flush();
-            return;
-        }
-
-        if (!this->commandChannel->disable(target)){
-            cout << "Disable command failed. Aborting." << endl;
-            return;
-        }
-
-        component = state->getComponent(target);
-        if (component == NULL){
-            cout << "Error retrieving component with name " << target << endl;
+        if (!this->commandChannel->disable(comm.target)){
+            LOOP_LOG(LOG_ERROR, "Disable command failed. Aborting.");
             return;
         }
 
@@ -559,7 +1114,7 @@ void RobotControl::command(string name, string target){
         break;
     case DISABLEALL:
         if (!this->commandChannel->disable("all")){
-            cout << "Disable command failed. Aborting." << endl;
+            LOOP_LOG(LOG_ERROR, "Disable command failed. Aborting.");
             return;
         }
 
@@ -568,44 +1123,29 @@ void RobotControl::command(string name, string target){
 
         break;
     case RESET:
-        if (!state->nameExists(target)){
-           cout << "Error. Component with name " << target << " is not on record. Aborting." << endl << "> ";
-           cout.flush();
-           return;
-       }
-
-        if (!this->commandChannel->reset(target)){
-            cout << "Reset command failed. Aborting." << endl;
+        if (!this->commandChannel->reset(comm.target)){
+            LOOP_LOG(LOG_ERROR, "Reset command failed. Aborting.");
             return;
         }
         break;
     case RESETALL:
-        for (Motors::const_iterator it = state->getMotors().begin(); it != state->getMotors().end(); it++)
-            command("ResetJoint", (*it)->getName());
+        for (Motors::const_iterator it = state->getMotors().begin(); it != state->getMotors().end(); it++){
+            if (!this->commandChannel->reset((*it)->getName()))
+                LOOP_LOG(LOG_ERROR, "Reset command failed. Aborting.");
+        }
 
         return;
     case HOME:
-        if (!state->nameExists(target)){
-           cout << "Error. Component with name " << target << " is not on record. Aborting." << endl << "> ";
-           cout.flush();
-           return;
-       }
-
-        if (!this->commandChannel->home(target)){
-            cout << "Homing command failed. Aborting." << endl;
+        if (!this->commandChannel->home(comm.target)){
+            LOOP_LOG(LOG_ERROR, "Homing command failed. Aborting.");
             return;
         }
 
-        component = state->getComponent(target);
-        if (component == NULL){
-            cout << "Error retrieving component with name " << target << endl;
-            return;
-        }
         component->set(GOAL, 0);
         break;
     case HOMEALL:
         if (!this->commandChannel->home("all")){
-            cout << "Homing command failed. Aborting." << endl;
+            LOOP_LOG(LOG_ERROR, "Homing command failed. Aborting.");
             return;
         }
 
@@ -616,18 +1156,13 @@ void RobotControl::command(string name, string target){
     case INITSENSORS:
 
         if (!this->commandChannel->initializeSensors()){
-            cout << "Initialize Sensors command failed. Aborting." << endl;
+            LOOP_LOG(LOG_ERROR, "Initialize Sensors command failed. Aborting.");
             return;
         }
         break;
     case ZERO:
-        component = state->getComponent(target);
-        if (component == NULL){
-            cout << "Error retrieving component with name " << target << endl;
-            return;
-        }
         if (!component->get(ENABLED, temp)){
-            cout << "Attempting to zero a non-motor component. Aborting" << endl;
+            LOOP_LOG(LOG_ERROR, "Attempting to zero a non-motor component. Aborting");
             return;
         }
         component->set(GOAL, 0);
@@ -645,6 +1180,12 @@ void RobotControl::command(string name, string target){
     case BALANCEOFF:
         balanceOn = false;
         break;
+    case PROFILEON:
+        profiler.setEnabled(true);
+        break;
+    case PROFILEOFF:
+        profiler.setEnabled(false);
+        break;
 
     }
 }
@@ -685,7 +1226,7 @@ void RobotControl::setMode(string mode, bool value){
         }
         interpolation = value;
     } else {
-        cout << "RobotControl does not have a mutable mode with name " << mode << "." << endl;
+        LOOP_LOG(LOG_ERROR, "RobotControl does not have a mutable mode with name %s.", mode.c_str());
     }
 }
 
@@ -716,38 +1257,23 @@ bool RobotControl::setAlias(string name, string alias){
  * @param input The string to split
  * @return      A vector of each field
  */
-vector<string> RobotControl::splitFields(string input){
+vector<string> RobotControl::splitFields(const string &input){
     vector<string> output;
-    int whitespaceType = 0;
-    if (input.find(' ') != string::npos) whitespaceType += 1;
-    if (input.find('\t') != string::npos) whitespaceType += 2;
-    if (input.find('\n') != string::npos) whitespaceType += 4;
-
-    char whitespace;
-    switch (whitespaceType){
-    case 1:
-        whitespace = ' ';
-        break;
-    case 2:
-        whitespace = '\t';
-        break;
-    case 4:
-        whitespace = '\n';
-        break;
-    default:
+    const char* whitespace = " \t\n\r";
+
+    // Input without any whitespace is a single field, even if it is empty.
+    if (input.find_first_of(whitespace) == string::npos){
         output.push_back(input);
         return output;
     }
-    string field;
-    int pos = 0;
 
-    do {
-        pos = input.find(whitespace);
-        field = input.substr(0, pos);
-        output.push_back(field);
-        input = input.substr(pos + 1, input.length() - pos - 1);
-    } while (input.find(whitespace) != string::npos);
-    output.push_back(input);
+    // Any mix and run of whitespace separates fields. One pass, no copies of the rest of the input.
+    string::size_type start = input.find_first_not_of(whitespace);
+    while (start != string::npos){
+        string::size_type end = input.find_first_of(whitespace, start);
+        output.push_back(input.substr(start, end == string::npos ? string::npos : end - start));
+        start = input.find_first_not_of(whitespace, end);
+    }
     return output;
 }
 
@@ -768,14 +1294,96 @@ void RobotControl::setDelay(int us){
 bool RobotControl::requiresMotion(string name){
     RobotComponent* component = state->getComponent(name);
     if (component == NULL){
-        cout << "Error retrieving component with name " << name << endl;
+        LOOP_LOG(LOG_ERROR, "Error retrieving component with name %s", name.c_str());
         return false;
     }
+    return requiresMotion(component);
+}
+
+/**
+ * Check if a joint that has been looked up already is at its goal
+ * @param  component Joint to check
+ * @return           True if the joint is not at its goal False if it is.
+ */
+bool RobotControl::requiresMotion(RobotComponent* component){
     double step, goal;
     if (!component->get(POSITION, step) || !component->get(GOAL, goal)){
-        cout << "Error retrieving data from component " << name << endl;
+        LOOP_LOG(LOG_ERROR, "Error retrieving data from component %s", component->getName().c_str());
+        return false;
+    }
+
+    return fabs(step - goal) > DEFAULT_MOTION_TOLERANCE;
+}
+
+/**
+ * Have the loop wake a waiter once all of the named components are at their goals. If
+ * they already are, the waiter is finished straight away and not kept.
+ * @param  waiter The waiter. It must stay alive until it is finished or removed.
+ * @param  names  Names of the components to wait for
+ * @return        False if a name does not exist or too many callers are waiting
+ */
+bool RobotControl::addWaiter(MotionWaiter* waiter, const vector<string> &names){
+    for (int i = 0; i < names.size(); i++){
+        RobotComponent* component = state->getComponent(names[i]);
+        if (component == NULL){
+            LOOP_LOG(LOG_ERROR, "Error retrieving component with name %s", names[i].c_str());
+            return false;
+        }
+        if (!waiter->add(component)){
+            LOOP_LOG(LOG_ERROR, "Error. Cannot wait for more than %d components at once.", MOTION_WAIT_COMPONENTS);
+            return false;
+        }
+    }
+
+    if (waiter->arrived()){
+        waiter->finish(true);
+        return true;
+    }
+
+    if (numWaiters >= MAX_MOTION_WAITERS){
+        LOOP_LOG(LOG_ERROR, "Error. Too many callers waiting for motion.");
         return false;
     }
+    waiters[numWaiters++] = waiter;
+    return true;
+}
+
+/**
+ * Stop checking a waiter, if it is still being checked. Once this returns the loop
+ * no longer touches it.
+ * @param waiter The waiter
+ */
+void RobotControl::removeWaiter(MotionWaiter* waiter){
+    for (int i = 0; i < numWaiters; i++){
+        if (waiters[i] == waiter){
+            waiters[i] = waiters[--numWaiters];
+            return;
+        }
+    }
+}
 
-    return fabs(step - goal) > .01;
+/**
+ * Finish every waiter whose components have all reached their goals. Called at the end
+ * of each tick.
+ */
+void RobotControl::checkWaiters(){
+    for (int i = 0; i < numWaiters; ){
+        if (waiters[i]->arrived()){
+            waiters[i]->finish(true);
+            waiters[i] = waiters[--numWaiters];
+        } else {
+            i++;
+        }
+    }
+}
+
+/**
+ * Finish every waiter as not arrived. Used when the components are about to go away.
+ */
+void RobotControl::cancelWaiters(){
+    for (int i = 0; i < numWaiters; i++){
+        waiters[i]->clear();
+        waiters[i]->finish(false);
+    }
+    numWaiters = 0;
 }
@@ -36,8 +36,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 Scheduler::Scheduler(long period){
     this->period = period;
-    getTime(&nextShot);
-    update();
+    start();
 }
 
 /**
@@ -45,24 +44,55 @@ Scheduler::Scheduler(long period){
  */
 Scheduler::~Scheduler() {}
 
+/**
+ * Start timing from now. Call right before the loop, so that the periods that passed
+ * since the scheduler was created are not counted as skipped. Clears the measurements.
+ */
+void Scheduler::start(){
+    measuring = false;
+    resetStats();
+    getTime(&nextShot);
+    update();
+}
+
 /**
  * update the timing of the the scheduler
  */
 void Scheduler::update(){
     getTime(&currTime);
 
+    int64_t periods = 0;
     do {
         nextShot.tv_nsec += period;
         normalizeTimespec(&nextShot);
+        periods++;
     } while (currTime.tv_sec > nextShot.tv_sec ||
             (currTime.tv_sec == nextShot.tv_sec && currTime.tv_nsec > nextShot.tv_nsec));
+
+    if (measuring){
+        stats.ticks++;
+        stats.skipped += periods - 1;
+    }
 }
 
 /**
  * Sleep the loop. 
  */
 void Scheduler::sleep(){
+    timespec now;
+    getTime(&now);
+    if (measuring){
+        stats.workTime.record(elapsed(wakeTime, now));
+        if (elapsed(nextShot, now) > 0)
+            stats.overruns++;
+    }
+
     clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &nextShot, NULL);
+
+    getTime(&wakeTime);
+    if (measuring)
+        stats.wakeLatency.record(elapsed(nextShot, wakeTime));
+    measuring = true;
 }
 
 /**
@@ -97,6 +127,26 @@ timespec& Scheduler::getNextShot(){
     return nextShot;
 }
 
+/**
+ * Get the timing measurements taken so far. The first tick is not measured, since
+ * it has no previous wake up to measure from.
+ * @return The measurements
+ */
+const TimingStats& Scheduler::getStats(){
+    return stats;
+}
+
+/**
+ * Clear all timing measurements
+ */
+void Scheduler::resetStats(){
+    stats.ticks = 0;
+    stats.overruns = 0;
+    stats.skipped = 0;
+    stats.wakeLatency.reset();
+    stats.workTime.reset();
+}
+
 /**
  * Normalize the timespec 
  * @param t The timespec to normailze
@@ -115,3 +165,13 @@ void Scheduler::normalizeTimespec(timespec* t){
 void Scheduler::getTime(timespec* t){
     clock_gettime(CLOCK_MONOTONIC, t);
 }
+
+/**
+ * Get the time between two timespecs
+ * @param  from The earlier time
+ * @param  to   The later time
+ * @return      to - from in nanoseconds
+ */
+int64_t Scheduler::elapsed(const timespec& from, const timespec& to){
+    return (int64_t)(to.tv_sec - from.tv_sec) * NSEC_PER_SECOND + (to.tv_nsec - from.tv_nsec);
+}
@@ -0,0 +1,139 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * The mailbox between the setpoints topic and the control loop.
+ */
+
+#include "ros/ros.h"
+
+#include "SetpointMailbox.h"
+
+/**
+ * Create an empty mailbox. Setpoints never go stale until a timeout is set.
+ */
+SetpointMailbox::SetpointMailbox(){
+    latest.count = 0;
+    latest.sent = 0;
+    latest.stamp = 0;
+    fresh = false;
+    timeout = 0;
+    stale = 0;
+    dropped = 0;
+}
+
+/**
+ * Set how old a message may be when the loop takes it, counted from when it was sent.
+ * @param seconds The timeout. 0 or less means messages never go stale.
+ */
+void SetpointMailbox::setTimeout(double seconds){
+    boost::mutex::scoped_lock guard(lock);
+    timeout = seconds > 0 ? (int64_t)(seconds * 1e9) : 0;
+}
+
+/**
+ * Replace whatever is in the mailbox. Subscriber side only.
+ * @param  handles The handles to set
+ * @param  values  The value for each handle
+ * @param  count   Number of handles
+ * @param  sent    The ROS time the message was stamped with, in nanoseconds, or 0 if it was not
+ * @return         False if there are more than SETPOINT_CAPACITY of them
+ */
+bool SetpointMailbox::post(const int *handles, const double *values, int count, int64_t sent){
+    if (count < 0 || count > SETPOINT_CAPACITY)
+        return false;
+
+    boost::mutex::scoped_lock guard(lock);
+    if (fresh)
+        dropped++;
+    for (int i = 0; i < count; i++){
+        latest.handles[i] = handles[i];
+        latest.values[i] = values[i];
+    }
+    latest.count = count;
+    latest.sent = sent;
+    latest.stamp = now();
+    fresh = true;
+    return true;
+}
+
+/**
+ * Take the newest message, if there is one the loop has not seen yet. Never blocks:
+ * if the subscriber is in the middle of posting, the message is picked up next tick.
+ * A message is stale if more than the timeout has passed since it was sent, or since it
+ * was received if the sender did not stamp it. Loop side only.
+ * @param  setpoints Filled with the message
+ * @return           True if setpoints was filled in
+ */
+bool SetpointMailbox::take(Setpoints &setpoints){
+    boost::mutex::scoped_try_lock guard(lock);
+    if (!guard.owns_lock() || !fresh)
+        return false;
+
+    fresh = false;
+    if (timeout != 0){
+        int64_t age = latest.sent != 0 ? (int64_t)ros::Time::now().toNSec() - latest.sent : now() - latest.stamp;
+        if (age > timeout){
+            stale++;
+            return false;
+        }
+    }
+
+    setpoints.count = latest.count;
+    setpoints.sent = latest.sent;
+    setpoints.stamp = latest.stamp;
+    for (int i = 0; i < latest.count; i++){
+        setpoints.handles[i] = latest.handles[i];
+        setpoints.values[i] = latest.values[i];
+    }
+    return true;
+}
+
+/**
+ * @return The number of messages that timed out before the loop took them
+ */
+int64_t SetpointMailbox::numStale(){
+    boost::mutex::scoped_lock guard(lock);
+    return stale;
+}
+
+/**
+ * @return The number of messages replaced by a newer one before the loop took them
+ */
+int64_t SetpointMailbox::numDropped(){
+    boost::mutex::scoped_lock guard(lock);
+    return dropped;
+}
+
+/**
+ * @return The CLOCK_MONOTONIC time in nanoseconds
+ */
+int64_t SetpointMailbox::now(){
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
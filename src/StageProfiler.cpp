@@ -0,0 +1,123 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * Per stage timing of the update loop. See StageProfiler.h
+ */
+
+#include "StageProfiler.h"
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * Create a profiler. It starts off disabled.
+ */
+StageProfiler::StageProfiler(){
+    enabled = false;
+    reset();
+}
+
+/**
+ * Turn the profiler on or off. Turning it on starts a fresh window.
+ * @param enabled True to start profiling
+ */
+void StageProfiler::setEnabled(bool enabled){
+    if (enabled && !this->enabled)
+        reset();
+    this->enabled = enabled;
+}
+
+/**
+ * See if the profiler is recording
+ * @return True if the profiler is on
+ */
+bool StageProfiler::isEnabled() const {
+    return enabled;
+}
+
+/**
+ * Throw away everything recorded so far.
+ */
+void StageProfiler::reset(){
+    next = 0;
+    filled = 0;
+    memset(samples, 0, sizeof(samples));
+}
+
+/**
+ * Get the number of ticks currently in the window
+ * @return The number of ticks recorded, at most PROFILE_WINDOW
+ */
+int StageProfiler::numSamples() const {
+    return filled;
+}
+
+/**
+ * Work out min, mean, 99th percentile and max of a stage over the window. This sorts,
+ * so do it on a copy of the profiler away from the loop.
+ * @param  stage   The stage to summarize
+ * @param  summary Filled with the results, in nanoseconds
+ * @return         False if nothing has been recorded
+ */
+bool StageProfiler::summarize(STAGE stage, StageSummary& summary) const {
+    if (filled == 0 || stage < 0 || stage >= NUM_STAGES)
+        return false;
+
+    std::vector<int64_t> values(filled);
+    double sum = 0;
+    for (int i = 0; i < filled; i++){
+        values[i] = samples[i][stage];
+        sum += values[i];
+    }
+
+    std::sort(values.begin(), values.end());
+    summary.min = values.front();
+    summary.max = values.back();
+    summary.mean = sum / filled;
+    summary.p99 = values[(int)((filled - 1) * .99)];
+    return true;
+}
+
+/**
+ * Get the name of a stage, for printing
+ * @param  stage The stage
+ * @return       The stage's name
+ */
+const char* StageProfiler::stageName(STAGE stage){
+    switch (stage){
+    case STAGE_SIM_LOAD:            return "simLoad";
+    case STAGE_REFERENCE_LOAD:      return "referenceLoad";
+    case STAGE_STATE_LOAD:          return "stateLoad";
+    case STAGE_BALANCE:             return "balance";
+    case STAGE_COMPONENTS:          return "components";
+    case STAGE_TRAJECTORY_ADVANCE:  return "trajectoryAdvance";
+    case STAGE_REFERENCE_UPDATE:    return "referenceUpdate";
+    case STAGE_TOTAL:               return "total";
+    default:                        return "unknown";
+    }
+}
@@ -30,34 +30,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
 #include "StateChannel.h"
-//The array of all the joint names
-const char *StateChannel::urdf_joint_names[] = {
-        "WST", "NKY", "NK1", "NK2",
-        "LSP", "LSR", "LSY", "LEP", "LWY", "LWR", "LWP",
-        "RSP", "RSR", "RSY", "REP", "RWY", "RWR", "RWP",
-        "UNUSED1",
-        "LHY", "LHR", "LHP", "LKP", "LAP", "LAR",
-        "UNUSED2",
-        "RHY", "RHR", "RHP", "RKP", "RAP", "RAR",
-        "RF1", "RF2", "RF3", "RF4", "RF5",
-        "LF1", "LF2", "LF3", "LF4", "LF5",
-        "unknown1", "unknown2", "unknown3", "unknown4", "unknown5", "unknown6", "unknown7", "unknown8"};
-
+#include "LoopLog.h"
 /**
  * Look up a joint's index by it's joint name
  * @param  joint Joint name
  * @return       index of the joint in hubo-ach
  */
 int StateChannel::indexLookup(string &joint) {
-    if (joint.length() != 3)
-        return -1;
-    int best_match = -1;
-
-    for (int i = 0; i < HUBO_JOINT_COUNT; i++) {
-        if (strcmp(joint.c_str(), urdf_joint_names[i]) == 0)
-            best_match = i;
-    }
-    return best_match;
+    return JointRegistry::instance()->indexOf(joint);
 }
 
 /**
@@ -90,12 +70,12 @@ void StateChannel::load(){
     int r = ach_get(&huboStateChannel, &temp, sizeof(temp), &fs, NULL, ACH_O_LAST);
 
     if(ACH_OK != r && ACH_MISSED_FRAME != r && ACH_STALE_FRAMES != r) {
-        cout << "Error! State Channel failed with state " << r << endl;
+        LOOP_LOG(LOG_ERROR, "Error! State Channel failed with state %d", r);
         errored = true;
         return;
     } else if (ACH_STALE_FRAMES != r){
         if (sizeof(temp) != fs) {
-            cout << "Error! File size inconsistent with state struct! fs = " << fs << " sizeof currentReference: " << sizeof(temp) << endl;
+            LOOP_LOG(LOG_ERROR, "Error! File size inconsistent with state struct! fs = %lu sizeof currentReference: %lu", (unsigned long)fs, (unsigned long)sizeof(temp));
             errored = true;
             return;
         }
@@ -0,0 +1,201 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * The thread that turns the loop's state snapshots into robot_state messages.
+ */
+
+#include "StatePublisher.h"
+
+/**
+ * Create a publisher. Nothing is published until start() is called.
+ */
+StatePublisher::StatePublisher(){
+    sem_init(&ready, 0, 0);
+    running = false;
+    fresh = false;
+    skipped = 0;
+    fetcher = NULL;
+    latest.generation = -1;
+    layout.generation = -1;
+}
+
+/**
+ * Destructor. Stops the thread if it is still going.
+ */
+StatePublisher::~StatePublisher(){
+    stop();
+    sem_destroy(&ready);
+}
+
+/**
+ * Advertise the topic and start the publisher thread. Start it before the loop makes
+ * itself real time, so that the thread does not inherit the loop's priority.
+ * @param n       The node to advertise on
+ * @param topic   Name of the topic
+ * @param fetcher Gets the names that go with the snapshots
+ */
+void StatePublisher::start(ros::NodeHandle &n, const std::string &topic, LayoutFetcher fetcher){
+    if (running)
+        return;
+    this->fetcher = fetcher;
+    publisher = n.advertise<maestor::RobotState>(topic, 1);
+    running = true;
+    thread = boost::thread(&StatePublisher::run, this);
+}
+
+/**
+ * Stop the publisher thread and wait for it to finish.
+ */
+void StatePublisher::stop(){
+    if (!running)
+        return;
+    running = false;
+    sem_post(&ready);
+    thread.join();
+}
+
+/**
+ * Get the snapshot to fill in. Never blocks. Loop side only; every claim() that does not
+ * return NULL has to be followed by commit().
+ * @return The snapshot, or NULL if the publisher is busy copying the last one or stopped
+ */
+StateSnapshot* StatePublisher::claim(){
+    if (!running)
+        return NULL;
+    if (!lock.try_lock()){
+        __sync_fetch_and_add(&skipped, 1);
+        return NULL;
+    }
+    return &latest;
+}
+
+/**
+ * Hand the snapshot from claim() to the publisher thread. sem_post never blocks, so
+ * this is safe to call from the loop.
+ */
+void StatePublisher::commit(){
+    fresh = true;
+    lock.unlock();
+    sem_post(&ready);
+}
+
+/**
+ * @return The number of snapshots the loop skipped because the publisher was busy
+ */
+int64_t StatePublisher::numSkipped(){
+    return __sync_fetch_and_add(&skipped, 0);
+}
+
+/**
+ * The publisher thread. Waits for the loop to commit a snapshot, copies it out and
+ * publishes it.
+ */
+void StatePublisher::run(){
+    while (true){
+        while (sem_wait(&ready) != 0)
+            ; // Interrupted by a signal. Keep waiting.
+        if (!running)
+            break;
+
+        {
+            boost::mutex::scoped_lock guard(lock);
+            if (!fresh)
+                continue;
+            sending = latest;
+            fresh = false;
+        }
+
+        if (publisher.getNumSubscribers() == 0)
+            continue;
+
+        // The names only change when the robot is initialized again. Until the loop
+        // hands back names for the generation the snapshot came from, there is nothing
+        // to label the values with.
+        if (sending.generation != layout.generation){
+            if (fetcher == NULL || !fetcher(layout) || layout.generation != sending.generation)
+                continue;
+
+            msg.joints = layout.joints;
+            msg.position.resize(layout.joints.size());
+            msg.goal.resize(layout.joints.size());
+            msg.interpolation_step.resize(layout.joints.size());
+            msg.enabled.resize(layout.joints.size());
+
+            msg.ft_sensors = layout.ftSensors;
+            msg.m_x.resize(layout.ftSensors.size());
+            msg.m_y.resize(layout.ftSensors.size());
+            msg.f_z.resize(layout.ftSensors.size());
+
+            msg.imus = layout.imus;
+            msg.x_accel.resize(layout.imus.size());
+            msg.y_accel.resize(layout.imus.size());
+            msg.z_accel.resize(layout.imus.size());
+            msg.x_rotat.resize(layout.imus.size());
+            msg.y_rotat.resize(layout.imus.size());
+        }
+
+        fill(sending);
+        publisher.publish(msg);
+    }
+}
+
+/**
+ * Copy a snapshot into the message. The message's arrays have already been sized for
+ * the snapshot's generation.
+ * @param snapshot The snapshot
+ */
+void StatePublisher::fill(const StateSnapshot &snapshot){
+    msg.header.seq++;
+    msg.header.stamp = ros::Time(snapshot.stamp);
+    msg.tick = snapshot.tick;
+
+    for (int i = 0; i < snapshot.numJoints && i < msg.joints.size(); i++){
+        msg.position[i] = snapshot.position[i];
+        msg.goal[i] = snapshot.goal[i];
+        msg.interpolation_step[i] = snapshot.step[i];
+        msg.enabled[i] = snapshot.enabled[i];
+    }
+
+    for (int i = 0; i < snapshot.numFT && i < msg.ft_sensors.size(); i++){
+        msg.m_x[i] = snapshot.ft[i][FT_M_X];
+        msg.m_y[i] = snapshot.ft[i][FT_M_Y];
+        msg.f_z[i] = snapshot.ft[i][FT_F_Z];
+    }
+
+    for (int i = 0; i < snapshot.numIMU && i < msg.imus.size(); i++){
+        msg.x_accel[i] = snapshot.imu[i][IMU_X_ACCEL];
+        msg.y_accel[i] = snapshot.imu[i][IMU_Y_ACCEL];
+        msg.z_accel[i] = snapshot.imu[i][IMU_Z_ACCEL];
+        msg.x_rotat[i] = snapshot.imu[i][IMU_X_ROTAT];
+        msg.y_rotat[i] = snapshot.imu[i][IMU_Y_ROTAT];
+    }
+
+    msg.balancing = snapshot.balancing;
+    msg.zmp_x = snapshot.zmp[0];
+    msg.zmp_y = snapshot.zmp[1];
+}
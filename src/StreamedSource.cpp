@@ -0,0 +1,364 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * A trajectory file streamed from disk by a prefetch thread.
+ */
+
+#include <algorithm>
+
+#include "StreamedSource.h"
+#include "LoopLog.h"
+
+int64_t StreamedSource::allUnderruns = 0;
+
+/**
+ * Start prefetching a file. The ring is allocated and the first block read here, off the loop.
+ * @param file The file, opened for reading. The source takes ownership of it.
+ */
+StreamedSource::StreamedSource(FrameReader* file){
+    this->file = file;
+    describe(*file);
+    _rate = file->rate();
+
+    leadCount = 0;
+    if (!_error && file->loadBuffer()){
+        FrameReader::Buffer& buffer = file->buffer();
+        lead.resize((size_t)buffer.size() * file->numCols());
+        for (int r = 0; r < buffer.size(); r++)
+            std::copy(buffer[r].begin(), buffer[r].end(), lead.begin() + (size_t)r * file->numCols());
+        leadCount = buffer.size();
+    }
+    if (!_error && leadCount == 0)
+        fail(file->errored() ? file->getError() : string("Trajectory Error: No frames to stream"));
+
+    for (int i = 0; i < PREFETCH_BLOCKS; i++){
+        blocks[i].values.resize((size_t)STREAM_BUFFER_SIZE * file->numCols());
+        blocks[i].count = 0;
+        blocks[i].generation = 0;
+        blocks[i].error = false;
+    }
+    head = 0;
+    tail = 0;
+    generation = 0;
+    seekTo = 0;
+
+    // The first block is played while the prefetch thread reads the ones after it.
+    leading = true;
+    holding = false;
+    row = 0;
+    ended = false;
+    pending = false;
+    held = _start;
+    standing = false;
+    underruns = 0;
+
+    sem_init(&wake, 0, 0);
+    running = true;
+    thread = boost::thread(&StreamedSource::run, this);
+}
+
+/**
+ * Destructor. Stops the prefetch thread and closes the file.
+ */
+StreamedSource::~StreamedSource(){
+    running = false;
+    sem_post(&wake);
+    thread.join();
+    sem_destroy(&wake);
+    delete file;
+}
+
+/**
+ * @return The current frame, or NULL past the end
+ */
+const double* StreamedSource::current(){
+    if (pending && take())
+        pending = false;
+    if (_error || ended)
+        return NULL;
+    if (leading)
+        return &lead[(size_t)row * _start.size()];
+    if (!holding)
+        return &held[0];
+    return &blocks[head % PREFETCH_BLOCKS].values[(size_t)row * _start.size()];
+}
+
+/**
+ * Move to the next frame. Never blocks. If the next block is not ready yet, the current
+ * frame is held and an underrun is counted.
+ * @return False past the end or on error
+ */
+bool StreamedSource::advance(){
+    standing = false;
+    if (_error || ended)
+        return false;
+
+    if (pending){
+        // Still waiting for the frame sought. That is not an underrun. Either way this
+        // lands on the frame sought at best, not the one after it.
+        standing = true;
+        if (!take())
+            return true;
+        pending = false;
+        return !_error && !ended;
+    }
+
+    if (leading){
+        discard();
+        if (row + 1 < leadCount){
+            row++;
+            return true;
+        }
+        // Hold the last frame of the first block if the second one is late.
+        const double* last = &lead[(size_t)(leadCount - 1) * held.size()];
+        for (int i = 0; i < held.size(); i++)
+            held[i] = last[i];
+        leading = false;
+    } else if (holding){
+        if (row + 1 < blocks[head % PREFETCH_BLOCKS].count){
+            row++;
+            return true;
+        }
+        release();
+    }
+
+    if (take())
+        return !_error && !ended;
+
+    underruns++;
+    __sync_fetch_and_add(&allUnderruns, 1);
+    LOOP_LOG(LOG_WARN, "Trajectory stream underrun. Holding the last frame.");
+    standing = true;
+    return true;
+}
+
+/**
+ * Go back to the first frame. Never blocks; the first block is played again from memory
+ * while the prefetch thread starts over from the second.
+ * @return False on error
+ */
+bool StreamedSource::rewind(){
+    if (_error)
+        return false;
+
+    seekTo = 0;
+    __sync_fetch_and_add(&generation, 1);
+    leading = true;
+    holding = false;
+    row = 0;
+    ended = false;
+    pending = false;
+    discard();
+    sem_post(&wake);
+    return true;
+}
+
+/**
+ * Go to a frame. Never blocks. Frames early in the first block are played from memory
+ * straight away, which leaves the prefetch thread the rest of it to catch up; for any
+ * other, the prefetch thread seeks the file and the current frame is held until the block
+ * starting with the frame sought is ready.
+ * @param  frame The frame
+ * @return       False if there is no such frame, or on error
+ */
+bool StreamedSource::seek(int frame){
+    if (_error || frame < 0 || frame >= _frames)
+        return false;
+
+    if (frame < leadCount / 2){
+        rewind();
+        row = frame;
+        return true;
+    }
+
+    const double* now = current();
+    if (now != NULL && now != &held[0])
+        std::copy(now, now + held.size(), held.begin());
+
+    seekTo = frame;
+    __sync_fetch_and_add(&generation, 1);
+    leading = false;
+    holding = false;
+    row = 0;
+    ended = false;
+    pending = true;
+    discard();
+    sem_post(&wake);
+    return true;
+}
+
+/**
+ * @return True until the block a seek asked for is ready
+ */
+bool StreamedSource::seeking(){
+    if (pending && take())
+        pending = false;
+    return pending;
+}
+
+/**
+ * @return True if the last advance() held a frame, for an underrun or a seek, instead of
+ *         moving on
+ */
+bool StreamedSource::stalled(){
+    return standing;
+}
+
+/**
+ * @return Frames per second the file was recorded at, or 0 if it does not say
+ */
+double StreamedSource::rate(){
+    return _rate;
+}
+
+/**
+ * @return The number of times this source had no frame ready
+ */
+int64_t StreamedSource::numUnderruns(){
+    return underruns;
+}
+
+/**
+ * @return The number of times any streamed source had no frame ready
+ */
+int64_t StreamedSource::totalUnderruns(){
+    return __sync_fetch_and_add(&allUnderruns, 0);
+}
+
+/**
+ * @param  block A block number
+ * @return       True if the prefetcher has finished filling the block
+ */
+bool StreamedSource::ready(int64_t block){
+    return block < __sync_fetch_and_add(&tail, 0);
+}
+
+/**
+ * Move on to the next block of the current generation, if the prefetcher has it ready.
+ * Blocks read before the last rewind or seek are handed straight back.
+ * @return True if a block was taken, or the end of the file or an error was reached
+ */
+bool StreamedSource::take(){
+    discard();
+    if (ready(head)){
+        Block& block = blocks[head % PREFETCH_BLOCKS];
+        if (block.error){
+            fail(block.errorMessage);
+            return true;
+        }
+
+        if (block.count == 0){
+            ended = true;
+            return true;
+        }
+
+        holding = true;
+        row = 0;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Hand back the blocks read before the last rewind or seek, so that the prefetcher has
+ * room to read ahead from where playback is now.
+ */
+void StreamedSource::discard(){
+    while (ready(head) && blocks[head % PREFETCH_BLOCKS].generation != generation){
+        __sync_fetch_and_add(&head, 1);
+        sem_post(&wake);
+    }
+}
+
+/**
+ * Give the current block back to the prefetcher, keeping its last frame to hold if the
+ * next block is late.
+ */
+void StreamedSource::release(){
+    Block& block = blocks[head % PREFETCH_BLOCKS];
+    const double* last = &block.values[(size_t)(block.count - 1) * held.size()];
+    for (int i = 0; i < held.size(); i++)
+        held[i] = last[i];
+
+    holding = false;
+    __sync_fetch_and_add(&head, 1);
+    sem_post(&wake);
+}
+
+/**
+ * The prefetch thread. Fills free blocks in order until the end of the file, then waits
+ * for a rewind or seek. The first block is already held in lead, so a rewind skips past it.
+ */
+void StreamedSource::run(){
+    int filling = 0;
+    bool done = false;
+    int cols = _start.size();
+
+    while (running){
+        int requested = __sync_fetch_and_add(&generation, 0);
+        if (requested != filling){
+            // A failed seek leaves the file errored, which the next block reports.
+            if (seekTo == 0){
+                file->reset();
+                file->loadBuffer();
+            } else {
+                file->seek(seekTo);
+            }
+            filling = requested;
+            done = false;
+        }
+
+        if (done || tail - __sync_fetch_and_add(&head, 0) >= PREFETCH_BLOCKS){
+            while (sem_wait(&wake) != 0)
+                ; // Interrupted by a signal. Keep waiting.
+            continue;
+        }
+
+        Block& block = blocks[tail % PREFETCH_BLOCKS];
+        block.generation = filling;
+        block.count = 0;
+        block.error = false;
+
+        if (file->loadBuffer()){
+            FrameReader::Buffer& buffer = file->buffer();
+            for (int r = 0; r < buffer.size(); r++)
+                std::copy(buffer[r].begin(), buffer[r].end(), block.values.begin() + (size_t)r * cols);
+            block.count = buffer.size();
+        } else {
+            if (file->errored()){
+                block.error = true;
+                block.errorMessage = file->getError();
+            }
+            done = true;
+        }
+
+        // Publish the block only once it is completely written.
+        __sync_synchronize();
+        __sync_fetch_and_add(&tail, 1);
+    }
+}
@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * The queue that carries service requests onto the control loop. The loop side
+ * never takes a lock: it only pops task pointers out of a ring buffer and posts
+ * a semaphore when each one is done.
+ */
+
+#include "TaskQueue.h"
+
+#include <errno.h>
+
+/**
+ * Create a task. It starts out not completed.
+ */
+LoopTask::LoopTask(){
+    sem_init(&done, 0, 0);
+}
+
+/**
+ * Destructor
+ */
+LoopTask::~LoopTask(){
+    sem_destroy(&done);
+}
+
+/**
+ * Signal the waiting caller that the task has run. sem_post never blocks,
+ * so this is safe to call from the loop.
+ */
+void LoopTask::complete(){
+    sem_post(&done);
+}
+
+/**
+ * Block until the loop has run the task
+ */
+void LoopTask::wait(){
+    while (sem_wait(&done) == -1 && errno == EINTR);
+}
+
+/**
+ * Create an empty task queue
+ */
+TaskQueue::TaskQueue(){
+    closed = false;
+}
+
+/**
+ * Destructor
+ */
+TaskQueue::~TaskQueue(){}
+
+/**
+ * Queue a task for the loop and wait for it to run. Must not be called from the loop itself.
+ * @param  task The task to run
+ * @return      True if the task ran, false if the queue is full or shut down
+ */
+bool TaskQueue::call(LoopTask& task){
+    {
+        boost::mutex::scoped_lock lock(producers);
+        if (closed || !pending.push(&task))
+            return false;
+    }
+    task.wait();
+    return true;
+}
+
+/**
+ * Run everything that has been queued. Called by the loop at the start of each tick.
+ * @return The number of tasks that were run
+ */
+int TaskQueue::runPending(){
+    LoopTask* task = NULL;
+    int count = 0;
+    while (pending.pop(task)){
+        task->run();
+        task->complete();
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Stop accepting tasks and finish the ones that are already queued, so that no
+ * caller is left waiting once the loop has exited.
+ */
+void TaskQueue::shutdown(){
+    {
+        boost::mutex::scoped_lock lock(producers);
+        closed = true;
+    }
+    runPending();
+}
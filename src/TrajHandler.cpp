@@ -33,11 +33,16 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
 #include "TrajHandler.h"
+#include "LoopLog.h"
 
 /**
  * Create the Trajectory Handler object
  */
-TrajHandler::TrajHandler() {}
+TrajHandler::TrajHandler() {
+    for (int row = 0; row <= JOINT_TABLE_SIZE; row++)
+        owners[row] = NULL;
+    writing = NULL;
+}
 
 /**
  * Clean up the trajectory handler object
@@ -57,24 +62,47 @@ TrajHandler::~TrajHandler() {
  */
 bool TrajHandler::loadTrajectory(const string& name, const string& path, bool read){
     if (!running.empty()){
-        cout << "Error. A trajectory is currently running. Please stop it first." << endl;
+        LOOP_LOG(LOG_ERROR, "Error. A trajectory is currently running. Please stop it first.");
         return false;
     }
 
     Trajectory* traj = new Trajectory(path, read);
+    Trajectory* replaced = NULL;
+    if (!addTrajectory(name, traj, replaced)){
+        delete traj;
+        return false;
+    }
+
+    delete replaced;
+    return true;
+}
+
+/**
+ * Add a trajectory that was constructed elsewhere. Loading is split out from this so
+ * the file can be parsed away from the control loop.
+ * @param  name     The name to give the trajectory
+ * @param  traj     The trajectory. The handler takes ownership of it on success, but not on failure.
+ * @param  replaced Set to the trajectory previously loaded under name, if any. The caller must delete it.
+ * @return          True on success
+ */
+bool TrajHandler::addTrajectory(const string& name, Trajectory* traj, Trajectory*& replaced){
+    replaced = NULL;
+    if (!running.empty()){
+        LOOP_LOG(LOG_ERROR, "Error. A trajectory is currently running. Please stop it first.");
+        return false;
+    }
+
     if (traj->is_open()){
         if (loaded.count(name) == 1){
-            cout << "A previous trajectory named " << name << " was loaded. Removing it from memory." << endl;
-            delete loaded[name];
+            LOOP_LOG(LOG_WARN, "A previous trajectory named %s was loaded. Removing it from memory.", name.c_str());
+            replaced = loaded[name];
         }
 
         loaded[name] = traj;
         return true;
     }
 
-
-    delete traj;
-    cout << "Error. Trajectory file nonexistent, or encountered error initializing. Aborting." << endl;
+    LOOP_LOG(LOG_ERROR, "Error. Trajectory file nonexistent, or encountered error initializing. Aborting.");
     return false;
 }
 
@@ -86,7 +114,7 @@ bool TrajHandler::loadTrajectory(const string& name, const string& path, bool re
  */
 bool TrajHandler::ignoreFrom(const string& name, const string& col){
     if (loaded.count(name) != 1){
-        cout << "A trajectory with name " << name << " is not loaded." << endl;
+        LOOP_LOG(LOG_ERROR, "A trajectory with name %s is not loaded.", name.c_str());
         return false;
     }
     loaded[name]->disableJoint(col);
@@ -117,7 +145,7 @@ bool TrajHandler::ignoreAllFrom(const string& name){
  */
 bool TrajHandler::unignoreFrom(const string& name, const string& col){
     if (loaded.count(name) != 1){
-        cout << "A trajectory with name " << name << " is not loaded." << endl;
+        LOOP_LOG(LOG_ERROR, "A trajectory with name %s is not loaded.", name.c_str());
         return false;
     }
     loaded[name]->enableJoint(col);
@@ -145,13 +173,13 @@ bool TrajHandler::unignoreAllFrom(const string& name){
  */
 bool TrajHandler::setTrigger(const string &traj, int frame, const string& target){
     if (loaded.count(traj) != 1){
-        cout << "No trajectory with name " << traj << " is loaded." << endl;
+        LOOP_LOG(LOG_WARN, "No trajectory with name %s is loaded.", traj.c_str());
         return false;
     }
 
     for (int i = 0; i < running.size(); i++){
         if (running[i].compare(traj) == 0){
-            cout << "Error. Trajectory " << traj << " has already been started. Cannot set trigger." << endl;
+            LOOP_LOG(LOG_ERROR, "Error. Trajectory %s has already been started. Cannot set trigger.", traj.c_str());
             return false;
         }
     }
@@ -161,51 +189,99 @@ bool TrajHandler::setTrigger(const string &traj, int frame, const string& target
 }
 
 /**
- * Extend a loaded trajectory by the contents of a trajectory file
- * @param  name The loaded trajectory to extend 
- * @param  path The path to the extension file
+ * Make a loaded trajectory start over instead of ending. Takes effect the next time the
+ * trajectory reaches its end, whether it is running or not.
+ * @param  name The trajectory
+ * @param  loop True to loop, false to stop looping
+ * @return      True on success
+ */
+bool TrajHandler::loopTrajectory(const string &name, bool loop){
+    if (loaded.count(name) != 1){
+        LOOP_LOG(LOG_WARN, "No trajectory with name %s is loaded.", name.c_str());
+        return false;
+    }
+
+    return loaded[name]->setLooping(loop);
+}
+
+/**
+ * Send a loaded trajectory to a frame, whether it is running or not
+ * @param  name  The trajectory
+ * @param  frame The frame, counted as triggers count them
+ * @return       True on success
+ */
+bool TrajHandler::seekTrajectory(const string &name, int frame){
+    if (loaded.count(name) != 1){
+        LOOP_LOG(LOG_WARN, "No trajectory with name %s is loaded.", name.c_str());
+        return false;
+    }
+
+    return loaded[name]->seek(frame);
+}
+
+/**
+ * Set how fast a loaded trajectory plays, whether it is running or not
+ * @param  name The trajectory
+ * @param  rate Frames to play each tick
  * @return      True on success
  */
-bool TrajHandler::extendTrajectory(const string& name, const string& path){
+bool TrajHandler::setTrajectoryRate(const string &name, double rate){
+    if (loaded.count(name) != 1){
+        LOOP_LOG(LOG_WARN, "No trajectory with name %s is loaded.", name.c_str());
+        return false;
+    }
+
+    return loaded[name]->setRate(rate);
+}
+
+/**
+ * Extend a loaded trajectory by the contents of a trajectory file
+ * @param  name   The loaded trajectory to extend 
+ * @param  source The opened extension file. The handler takes ownership of it on success, but not on failure.
+ * @return        True on success
+ */
+bool TrajHandler::extendTrajectory(const string& name, FrameSource* source){
     if (!running.empty()){
-        cout << "Error. A trajectory has been started. Please stop it first." << endl;
+        LOOP_LOG(LOG_ERROR, "Error. A trajectory has been started. Please stop it first.");
         return false;
     }
 
     if (loaded.count(name) != 1){
-        cout << "No trajectory with name " << name << " is loaded. Loading this trajectory by itself." << endl;
-        return loadTrajectory(name, path, true);
+        LOOP_LOG(LOG_WARN, "No trajectory with name %s is loaded. Loading this trajectory by itself.", name.c_str());
+        if (source == NULL || source->errored())
+            return false;
+        loaded[name] = new Trajectory(source);
+        return true;
     }
 
-    return loaded[name]->extendTrajectory(path);
+    return loaded[name]->extendTrajectory(source);
 }
 
 /**
  * Start the trajectory
- * @param name The trajectory to start
+ * @param  name The trajectory to start
+ * @return      True if it was started
  */
-void TrajHandler::startTrajectory(const string& name){
+bool TrajHandler::startTrajectory(const string& name){
     Trajectory* traj = NULL;
 
     if (loaded.count(name) != 1){
-        cout << "Cannot start trajectory " << name << ". Not yet loaded." << endl;
-        return;
+        LOOP_LOG(LOG_ERROR, "Cannot start trajectory %s. Not yet loaded.", name.c_str());
+        return false;
     }
 
     traj = loaded[name];
 
     if (!traj->is_open()){
-        cout << "Cannot start non-open trajectory " << name << "." << endl;
-        return;
+        LOOP_LOG(LOG_ERROR, "Cannot start non-open trajectory %s.", name.c_str());
+        return false;
     }
 
-    string key(WRITE_KEY);
-    if (inRunning(key) && !traj->read_only()){
-        cout << "Cannot start " << name << ". Another write-enabled trajectory is running." << endl;
-        return;
+    if (writing != NULL && !traj->read_only()){
+        LOOP_LOG(LOG_ERROR, "Cannot start %s. Another write-enabled trajectory is running.", name.c_str());
+        return false;
     }
 
-    Header header;
     for (vector< string >::iterator it = running.begin(); it != running.end(); it++){
         while (loaded.count(*it) != 1){
             it = running.erase(it);
@@ -214,25 +290,29 @@ void TrajHandler::startTrajectory(const string& name){
         }
 
         if (name.compare(*it) == 0){
-            cout << "Trajectory with name " << name << " is already running." << endl;
-            return;
+            LOOP_LOG(LOG_WARN, "Trajectory with name %s is already running.", name.c_str());
+            return false;
         }
+    }
 
-        if (traj->read_only()){
-            header = loaded[*it]->getHeader();
-            for (int j = 0; j < header.size(); j++){
-                if (loaded[*it]->contains(header[j]) && traj->contains(header[j])){
-                    cout << "Cannot start trajectory: references " << header[j] << ", already in use by another trajectory. " << endl;
-                    return;
-                }
+    if (traj->read_only() && (owned & traj->getJoints()).any()){
+        // Only look for which joint it was once we know there is one.
+        for (int row = 0; row <= JOINT_TABLE_SIZE; row++){
+            if (owned.test(row) && traj->contains(row)){
+                LOOP_LOG(LOG_ERROR, "Cannot start trajectory: references %s, already in use by another trajectory.",
+                    traj->getHeader()[traj->column(row)].c_str());
+                break;
             }
         }
+        return false;
     }
+
     string trigger;
-    if (traj->getTrigger(trigger))
+    while (traj->getTrigger(trigger))
         triggers.push(trigger);
-    addToCache(traj);
+    claimJoints(traj);
     running.push_back(name);
+    return true;
 }
 
 /**
@@ -255,7 +335,7 @@ void TrajHandler::stopTrajectory(Trajectory* traj){
  */
 void TrajHandler::stopTrajectory(const string& name){
     if (loaded.count(name) != 1){
-        cout << "Trajectory " << name << " does not exist." << endl;
+        LOOP_LOG(LOG_ERROR, "Trajectory %s does not exist.", name.c_str());
         return;
     }
     for (vector<string>::iterator it = running.begin(); it != running.end(); it++){
@@ -265,7 +345,7 @@ void TrajHandler::stopTrajectory(const string& name){
                 break;
         }
         if (name.compare(*it) == 0){
-            removeFromCache(loaded[*it]);
+            releaseJoints(loaded[*it]);
             loaded[*it]->reset();
             it = running.erase(it);
             return;
@@ -273,6 +353,24 @@ void TrajHandler::stopTrajectory(const string& name){
     }
 }
 
+/**
+ * Move the trajectories over to a new joint table, when a new robot replaces the one they
+ * were bound to. Rows are looked up again by name, and the running ones claim them again.
+ * @param joints The new joint table
+ */
+void TrajHandler::rebindJoints(JointTable& joints){
+    for (TrajectoryMap::iterator it = loaded.begin(); it != loaded.end(); it++){
+        releaseJoints(it->second);
+        it->second->bindJoints(joints);
+    }
+
+    for (int i = 0; i < running.size(); i++){
+        TrajectoryMap::iterator it = loaded.find(running[i]);
+        if (it != loaded.end())
+            claimJoints(it->second);
+    }
+}
+
 /**
  * Advance a frame on the current running trajectory 
  */
@@ -280,14 +378,14 @@ void TrajHandler::advanceFrame(){
     for (int i = 0; i < running.size(); i++){
         if (!loaded[running[i]]->advanceFrame()){
             string trigger;
-            if (loaded[running[i]]->getTrigger(trigger))
+            while (loaded[running[i]]->getTrigger(trigger))
                 triggers.push(trigger);
 
             stopTrajectory(running[i]);
             i--;
         } else {
             string trigger;
-            if (loaded[running[i]]->getTrigger(trigger))
+            while (loaded[running[i]]->getTrigger(trigger))
                 triggers.push(trigger);
         }
     }
@@ -314,13 +412,21 @@ Trajectory* TrajHandler::get(const string& name){
 
 /**
  * Return a trajectory that is currently operating a specific joint
- * @param  col The name of the joint that is being operated 
- * @return     Trajectory object that was running
+ * @param  row The joint's row in the joint table
+ * @return     Trajectory object that was running, or NULL
  */
-Trajectory* TrajHandler::inRunning(const string& col){
-    if (cache.count(col) == 1)
-        return cache[col];
-    return NULL;
+Trajectory* TrajHandler::inRunning(int row){
+    if (row < 0 || row > JOINT_TABLE_SIZE)
+        return NULL;
+    return owners[row];
+}
+
+/**
+ * Return the write-enabled trajectory that is running
+ * @return The trajectory, or NULL if none is
+ */
+Trajectory* TrajHandler::getWriting(){
+    return writing;
 }
 
 /**
@@ -338,26 +444,36 @@ queue< string >& TrajHandler::getCurrentTriggers(){
 }
 
 /**
- * Add a trajectory to the cache
- * @param traj The trajectory to add to the cache
+ * Give a starting trajectory the joints it drives
+ * @param traj The trajectory, already bound to the joint table
  */
-void TrajHandler::addToCache(Trajectory* traj){
-    if (traj->read_only()){
-        Header header = traj->getHeader();
-        for (Header::iterator it = header.begin(); it != header.end(); it++)
-            if (traj->contains(*it))
-                cache[*it] = traj;
-    } else
-        cache[WRITE_KEY] = traj;
+void TrajHandler::claimJoints(Trajectory* traj){
+    if (!traj->read_only()){
+        writing = traj;
+        return;
+    }
+
+    const JointMask& joints = traj->getJoints();
+    owned |= joints;
+    for (int row = 0; row <= JOINT_TABLE_SIZE; row++){
+        if (joints.test(row))
+            owners[row] = traj;
+    }
 }
 
 /**
- * Remove a trajectory from the cache
- * @param traj The trajectory object to remove to the cache
+ * Take back the joints a stopping trajectory owned. Goes by the owners rather than the
+ * trajectory's current joints, which may have changed while it ran.
+ * @param traj The trajectory
  */
-void TrajHandler::removeFromCache(Trajectory* traj){
-    for (TrajectoryMap::iterator it = cache.begin(); it != cache.end(); it++){
-        if (it->second == traj)
-            cache.erase(it);
+void TrajHandler::releaseJoints(Trajectory* traj){
+    if (traj == writing)
+        writing = NULL;
+
+    for (int row = 0; row <= JOINT_TABLE_SIZE; row++){
+        if (owners[row] == traj){
+            owners[row] = NULL;
+            owned.reset(row);
+        }
     }
 }
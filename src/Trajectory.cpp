@@ -30,7 +30,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * and allows you to do opertations on them.
  */
 
+#include <algorithm>
+
 #include "Trajectory.h"
+#include "RobotComponent.h"
+#include <string.h>
+#include "LoopLog.h"
 
 /**
  * Create a trajectory object from a file or open a file to be written to if read is false. 
@@ -38,41 +43,72 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * @param   read        Flag to specify if the file it to be written to or read from
  */
 Trajectory::Trajectory(const string &baseFile, bool read){
-    bufferIndex = 0;
     frame = 0;
-    currentWSV = 0;
+    currentSource = 0;
+    recorder = NULL;
+    recordFrame = NULL;
+    joints = NULL;
+    looping = false;
+    passed = -1;
+    owedFrom = -1;
+    owedTo = -1;
+    rate = 1;
+    lag = 0;
+    mapColumns();
+    path = baseFile;
     open = true;
     this->read = read;
 
-    WSVFile* file = new WSVFile(baseFile, read, BUFFER_SIZE);
-    if (file->errored()){
-        cout << "Error initializing trajectory file " << baseFile << endl;
-        cout << file->getError();
-        delete file; // Current method of handling error in constructor
-        file = NULL;
-        open = false;
-        return;
-    }
-
     if (read) {
-        if (!file->headerSupplied() && file->numCols() == 40){
-            file->setHeader(DEFAULT_HEADER);
-        }
-
-        if (file->loadBuffer())
-            files.push_back(file);
-        else {
-            cout << "Error loading buffer for trajectory file " << baseFile << endl;
-            if (file->errored())
-                cout << file->getError() << endl;
-            delete file; // current method of handling error in constructor
-            file = NULL;
+        string error;
+        FrameSource* source = FrameSource::open(baseFile, error);
+        if (source == NULL){
+            LOOP_LOG(LOG_ERROR, "%s", error.c_str());
             open = false;
             return;
         }
-    } else {
-        files.push_back(file);
-        prepareFrame();
+        sources.push_back(source);
+        previous.resize(source->numCols());
+        scratch.resize(source->numCols());
+        return;
+    }
+
+    // The file is not created until recording begins, so a write-enabled trajectory can
+    // be made off the loop without touching anything on disk.
+    TrajectoryRecorder::Format format = TrajectoryRecorder::TEXT;
+    if (baseFile.size() >= strlen(BINARY_EXTENSION)
+            && baseFile.compare(baseFile.size() - strlen(BINARY_EXTENSION), string::npos, BINARY_EXTENSION) == 0)
+        format = TrajectoryRecorder::BINARY;
+    else if (baseFile.size() >= strlen(COMPRESSED_EXTENSION)
+            && baseFile.compare(baseFile.size() - strlen(COMPRESSED_EXTENSION), string::npos, COMPRESSED_EXTENSION) == 0)
+        format = TrajectoryRecorder::COMPRESSED;
+    recorder = new TrajectoryRecorder(baseFile, format);
+}
+
+/**
+ * Create a read trajectory from a source that has already been opened
+ * @param   source      The source to play. The trajectory takes ownership of it.
+ */
+Trajectory::Trajectory(FrameSource* source){
+    frame = 0;
+    currentSource = 0;
+    recorder = NULL;
+    recordFrame = NULL;
+    joints = NULL;
+    looping = false;
+    passed = -1;
+    owedFrom = -1;
+    owedTo = -1;
+    rate = 1;
+    lag = 0;
+    mapColumns();
+    open = source != NULL && !source->errored();
+    read = true;
+
+    if (source){
+        sources.push_back(source);
+        previous.resize(source->numCols());
+        scratch.resize(source->numCols());
     }
 }
 
@@ -80,12 +116,11 @@ Trajectory::Trajectory(const string &baseFile, bool read){
  * Clean up after the trajectory object is destructed 
  */
 Trajectory::~Trajectory(){
-    for (int i = 0; i < files.size(); i++){
-        if (files[i]){
-            delete files[i];
-            files[i] = NULL;
-        }
-    }
+    for (int i = 0; i < sources.size(); i++)
+        delete sources[i];
+    sources.clear();
+    delete recorder;
+    recorder = NULL;
 }
 
 /**
@@ -98,63 +133,69 @@ bool Trajectory::extendTrajectory(const string &filename){
     if (!open || !read)
         return false;
 
-    WSVFile* file = new WSVFile(filename, true, BUFFER_SIZE);
-    if (file->errored()){
-        cout << "Error initializing trajectory file " << filename << endl;
-        delete file; // Current method of handling error in constructor
-        file = NULL;
+    string error;
+    FrameSource* source = FrameSource::open(filename, error);
+    if (source == NULL){
+        LOOP_LOG(LOG_ERROR, "%s", error.c_str());
         return false;
     }
 
-    // If the new file doesn't supply a header, and has 40 columns, assume the default header, and move along.
-    if (!file->headerSupplied() && file->numCols() == 40)
-        file->setHeader(DEFAULT_HEADER);
-
-    // Nab the file at the end of the current trajectory.
-    WSVFile* last = files[files.size() - 1];
+    if (!extendTrajectory(source)){
+        delete source;
+        return false;
+    }
+    return true;
+}
 
-    if (!last)
+/**
+ * Extend an already loaded trajectory by a source that has already been opened.
+ * 
+ * @param  source   The source to play after the current end of the trajectory. Owned by the trajectory on success.
+ * @return          True on success
+ */
+bool Trajectory::extendTrajectory(FrameSource* source){
+    if (!open || !read || sources.empty() || source == NULL || source->errored())
         return false;
 
-    if (file->numCols() != last->numCols()){
-        cout << "Column size for " << filename << " does not match existing trajectory." << endl;
+    // Nab the source at the end of the current trajectory.
+    FrameSource* last = sources[sources.size() - 1];
+
+    if (source->numCols() != last->numCols()){
+        LOOP_LOG(LOG_ERROR, "Column size does not match existing trajectory.");
         return false;
     }
 
-    Frame lastEnd = last->end();
-    Frame fileStart = file->start();
+    const Frame& lastEnd = last->end();
+    const Frame& sourceStart = source->start();
 
     string col;
-    int fileIndex;
+    int sourceIndex;
     double lastPos;
     double startPos;
     for (int i = 0; i < last->orderedHeader().size(); i++){
         col = last->orderedHeader()[i];
-        if (file->header().count(col) != 1){
-            cout << "Column " << col << " not present in " << filename << endl;
+        sourceIndex = source->column(col);
+        if (sourceIndex < 0){
+            LOOP_LOG(LOG_ERROR, "Column %s not present in extension", col.c_str());
             return false;
         }
 
-        fileIndex = file->header()[col];
-
         lastPos = lastEnd[i];
-        startPos = fileStart[fileIndex];
+        startPos = sourceStart[sourceIndex];
 
         if (fabs( lastPos - startPos ) > .01){
-            cout << "Start position of " << filename << " inconsistent with previous end position." << endl;
+            LOOP_LOG(LOG_ERROR, "Start position of extension inconsistent with previous end position.");
             return false;
         }
     }
 
-    if (file->loadBuffer())
-        files.push_back(file);
-    else {
-        cout << "Error loading buffer for trajectory file " << filename << endl;
-        delete file; // current method of handling error in constructor
-        file = NULL;
+    if (looping && !closesLoop(source)){
+        LOOP_LOG(LOG_ERROR, "End position of extension inconsistent with the start of the looping trajectory.");
         return false;
     }
 
+    sources.push_back(source);
+    mapColumns(); // So that playing on into the extension only has to switch maps
     return true;
 }
 
@@ -164,16 +205,16 @@ bool Trajectory::extendTrajectory(const string &filename){
  * @return       The starting position of the joint
  */
 double Trajectory::startPosition(const string &joint){
-    if (files.size() == 0)
+    if (sources.size() == 0)
         return 0;
-    WSVFile* file = files[0];
-    if (!file || file->errored()){
+    FrameSource* source = sources[0];
+    if (source->errored()){
         open = false;
         return 0;
     }
 
-    if (file && !file->errored() && contains(joint))
-        return file->start()[ file->header()[joint] ];
+    if (contains(joint))
+        return source->start()[ source->column(joint) ];
 
     return 0;
 }
@@ -185,78 +226,213 @@ double Trajectory::startPosition(const string &joint){
  * @return          True on success
  */
 bool Trajectory::nextPosition(const string &joint, double &position){
-    if (!open || files.size() <= currentWSV)
+    if (!open || !contains(joint))
         return false;
 
-    WSVFile* file = files[currentWSV];
-    if (!file || file->errored() || !contains(joint) || bufferIndex >= file->bufferSize()){
-        if (file && file->errored())
-            cout << file->getError() << endl;
+    if (!read){
+        if (recordFrame == NULL)
+            return false;
+        recordFrame[recordColumns[joint]] = position;
+        return true;
+    }
+
+    FrameSource* source = sources[currentSource];
+    const double* row = source->current();
+    if (row == NULL){
+        if (source->errored())
+            LOOP_LOG(LOG_ERROR, "%s", source->getError().c_str());
         return false;
     }
 
-    if (read)
-        position = file->buffer()[bufferIndex][file->header()[joint]];
-    else
-        file->buffer()[bufferIndex][file->header()[joint]] = position;
+    position = at(row, source->header()[joint]);
     return true;
 }
 
+/**
+ * Get the next position for the joint in a row of the bound joint table
+ * @param  row      The joint's row
+ * @param  position A pointer to store the position of the joint
+ * @return          True on success
+ */
+bool Trajectory::nextPosition(int row, double &position){
+    if (!open || row < 0 || row > JOINT_TABLE_SIZE || mapped->columns[row] < 0)
+        return false;
+
+    if (!read){
+        if (recordFrame == NULL)
+            return false;
+        recordFrame[mapped->columns[row]] = position;
+        return true;
+    }
+
+    FrameSource* source = sources[currentSource];
+    const double* frame = source->current();
+    if (frame == NULL){
+        if (source->errored())
+            LOOP_LOG(LOG_ERROR, "%s", source->getError().c_str());
+        return false;
+    }
+
+    position = at(frame, mapped->columns[row]);
+    return true;
+}
+
+/**
+ * Map the rows of a joint table to columns of this trajectory
+ * @param joints The joint table
+ */
+void Trajectory::bindJoints(JointTable& joints){
+    this->joints = &joints;
+    mapColumns();
+}
+
 /**
  * Advance a frame in the trajectory 
  * @return True on success
  */
 bool Trajectory::advanceFrame(){
-    if (!open || files.size() <= currentWSV)
-        return false;
-    WSVFile* file = files[currentWSV];
-    if (!file || file->errored()){
-        if (file && file->errored())
-            cout << "Error on advance frame: " << file->getError() << endl;
+    if (!open)
         return false;
+
+    if (!read){
+        if (recordFrame == NULL)
+            return false;
+
+        // Hand the frame to the recorder's writer thread and start the next one.
+        recorder->commit();
+        recordFrame = recorder->next();
+        frame++;
+        return true;
     }
 
-    bufferIndex++;
-    frame++;
+    if (sources.size() <= currentSource)
+        return false;
 
-    // Prepares a frame for writing.
-    if (!read)
-        prepareFrame();
+    // Only the step that lands between two frames needs the one before it. At a rate of 1
+    // this is exactly one step, with nothing copied.
+    lag -= rate;
+    while (lag < 0){
+        lag += 1;
+        if (lag > 0){
+            const double* current = sources[currentSource]->current();
+            if (current != NULL)
+                std::copy(current, current + previous.size(), previous.begin());
+        }
+        if (!step())
+            return false;
+    }
+    return true;
+}
 
-    if (bufferIndex < file->bufferSize())
+/**
+ * Move on by one frame
+ * @return True on success
+ */
+bool Trajectory::step(){
+    frame++;
+    FrameSource* source = sources[currentSource];
+    if (source->advance()){
+        // A source that held its frame has not moved on, so neither does the frame count.
+        // Otherwise every underrun would make triggers fire a frame early.
+        if (source->stalled())
+            frame--;
         return true;
+    }
 
-    // The frame has passed the end of the buffer. We need to load a new one (or write it)
-    bufferIndex = 0;
-    if (read){
-        if (!file->loadBuffer()){
-            if (file->errored() || currentWSV + 1 == files.size()){
-                if (file->errored())
-                    cout << "Error on loading buffer " << file->getError() << endl;
+    // The current source is used up. Move on to the next one, if there is one, or back
+    // to the first when looping. Rewinding only resets indices, so this is safe here.
+    if (looping && !source->errored() && currentSource + 1 == sources.size()){
+        for (int i = 0; i < sources.size(); i++){
+            if (!sources[i]->rewind()){
+                owe();
+                LOOP_LOG(LOG_ERROR, "Error on loop: %s", sources[i]->getError().c_str());
                 open = false;
                 frame = -1;
+                passed = END_PASSED;
                 return false;
             }
-            currentWSV++;
         }
-
-    } else {
-        if (!file->storeBuffer(file->bufferSize())){
-            open = false;
-            return false;
+        owe();
+        frame = 0;
+        passed = -1;
+        if (currentSource != 0){
+            currentSource = 0;
+            useColumns();
         }
-        file->buffer().clear();
-        prepareFrame();
+        carry(source);
+        return true;
     }
+    if (source->errored() || currentSource + 1 == sources.size()){
+        owe();
+        if (source->errored())
+            LOOP_LOG(LOG_ERROR, "Error on advance frame: %s", source->getError().c_str());
+        open = false;
+        frame = -1;
+        passed = END_PASSED;
+        return false;
+    }
+    currentSource++;
+    useColumns();
+    carry(source);
     return true;
 }
 
+/**
+ * Note that the triggers on the frames since the last one handed out are still owed, before
+ * the frame count ends or starts over. Frames stepped over on an earlier pass this tick,
+ * when a short trajectory loops more than once a tick, are merged in, and fire once.
+ */
+void Trajectory::owe(){
+    int last = frame - 1;
+    if (owedTo > owedFrom){
+        owedFrom = std::min(owedFrom, passed);
+        owedTo = std::max(owedTo, last);
+    } else {
+        owedFrom = passed;
+        owedTo = last;
+    }
+}
+
 /**
  * See if the trajectory is open
  * @return If the the trajectory is open
  */
 bool Trajectory::is_open(){
-    return open;
+    collectRecording();
+    return open && (!read || !sources.empty());
+}
+
+/**
+ * Make the trajectory start over when it reaches its end
+ * @param  loop True to loop, false to end as usual
+ * @return      True on success
+ */
+bool Trajectory::setLooping(bool loop){
+    if (!loop){
+        looping = false;
+        return true;
+    }
+
+    if (!read || sources.empty()){
+        LOOP_LOG(LOG_ERROR, "Only trajectories opened for reading can loop.");
+        return false;
+    }
+
+    if (!closesLoop(sources[sources.size() - 1])){
+        LOOP_LOG(LOG_ERROR, "End position of trajectory inconsistent with its start position. Cannot loop.");
+        return false;
+    }
+
+    looping = true;
+    return true;
+}
+
+/**
+ * See if the trajectory loops
+ * @return If the trajectory starts over at its end
+ */
+bool Trajectory::isLooping(){
+    return looping;
 }
 
 /**
@@ -275,6 +451,83 @@ int Trajectory::getFrame(){
     return frame;
 }
 
+/**
+ * Go to a frame of the trajectory
+ * @param  target The frame, counted from the start of the first source
+ * @return        True on success
+ */
+bool Trajectory::seek(int target){
+    if (!read || sources.empty() || target < 0)
+        return false;
+
+    int first = 0;
+    for (int i = 0; i < sources.size(); i++){
+        if (target >= first + sources[i]->numFrames()){
+            first += sources[i]->numFrames();
+            continue;
+        }
+
+        if (!sources[i]->seek(target - first)){
+            LOOP_LOG(LOG_ERROR, "Error seeking to frame %d: %s", target, sources[i]->getError().c_str());
+            return false;
+        }
+
+        // The sources after it play from their start when they are reached.
+        for (int j = i + 1; j < sources.size(); j++){
+            if (!sources[j]->rewind()){
+                LOOP_LOG(LOG_ERROR, "Error: %s", sources[j]->getError().c_str());
+                open = false;
+                return false;
+            }
+        }
+
+        frame = target;
+        passed = frame - 1;
+        owedFrom = -1;
+        owedTo = -1;
+        lag = 0;
+        open = true;
+        if (currentSource != i){
+            currentSource = i;
+            useColumns();
+        }
+        return true;
+    }
+
+    LOOP_LOG(LOG_ERROR, "Cannot seek to frame %d. The trajectory only has %d frames.", target, first);
+    return false;
+}
+
+/**
+ * See if the trajectory is still waiting for the frame it was sent to
+ * @return True until the frame sought has been read
+ */
+bool Trajectory::seeking(){
+    return read && sources.size() > currentSource && sources[currentSource]->seeking();
+}
+
+/**
+ * Set how fast the trajectory plays
+ * @param  rate Frames to move on by each tick
+ * @return      True on success
+ */
+bool Trajectory::setRate(double rate){
+    if (!(rate >= 0 && rate <= MAX_PLAYBACK_RATE)){
+        LOOP_LOG(LOG_ERROR, "Playback rate %g is not between 0 and %g.", rate, MAX_PLAYBACK_RATE);
+        return false;
+    }
+    this->rate = rate;
+    return true;
+}
+
+/**
+ * Get how fast the trajectory plays
+ * @return Frames moved on by each tick
+ */
+double Trajectory::getRate(){
+    return rate;
+}
+
 /**
  * Add a trigger to this trajectory to begin another trajectory at the frame
  * number. 
@@ -295,9 +548,33 @@ bool Trajectory::addTrigger(int frame, const string &target){
  * @return        True if there is a trigger or false if there isn't 
  */
 bool Trajectory::getTrigger(string& target){
-    if (triggers.count(frame) == 0)
+    // Frames stepped over before the trajectory ended or started over this tick come first.
+    if (owedTo > owedFrom){
+        map< int, string >::iterator owed = triggers.upper_bound(owedFrom);
+        if (owed != triggers.end() && owed->first <= owedTo){
+            target = owed->second;
+            owedFrom = owed->first;
+            return true;
+        }
+        owedFrom = -1;
+        owedTo = -1;
+    }
+
+    if (frame < 0){
+        // The end of the trajectory. Its trigger is handed out once.
+        if (passed != END_PASSED || triggers.count(frame) == 0)
+            return false;
+        target = triggers[frame];
+        passed = frame;
+        return true;
+    }
+
+    // Every frame since the last trigger handed out, up to the current one.
+    map< int, string >::iterator next = triggers.upper_bound(passed);
+    if (next == triggers.end() || next->first > frame)
         return false;
-    target = triggers[frame];
+    target = next->second;
+    passed = next->first;
     return true;
 }
 
@@ -306,7 +583,7 @@ bool Trajectory::getTrigger(string& target){
  * @return True if there is a next line
  */
 bool Trajectory::hasNext(){
-    return files.size() > currentWSV && currentWSV != files.size() - 1;
+    return sources.size() > currentSource && currentSource != sources.size() - 1;
 }
 
 /**
@@ -315,13 +592,44 @@ bool Trajectory::hasNext(){
  * @return       True if the joint is in the trajectory
  */
 bool Trajectory::contains(const string& joint){
-    if (files.size() <= currentWSV)
-        return false;
-    WSVFile* file = files[currentWSV];
-    if (!file || file->errored())
-        return false;
+    HeaderMap* header;
+    if (read){
+        if (sources.size() <= currentSource || sources[currentSource]->errored())
+            return false;
+        header = &sources[currentSource]->header();
+    } else {
+        header = &recordColumns;
+    }
 
-    return file->header().count(joint) == 1 && !disabledJoints.count(joint) == 1;
+    return header->count(joint) == 1 && !disabledJoints.count(joint) == 1;
+}
+
+/**
+ * Check to see if the joint in a row of the bound joint table is in this trajectory
+ * @param  row   The joint's row
+ * @return       True if the joint is in the trajectory
+ */
+bool Trajectory::contains(int row){
+    return row >= 0 && row <= JOINT_TABLE_SIZE && mapped->columns[row] >= 0;
+}
+
+/**
+ * Get the rows of the bound joint table that are in this trajectory
+ * @return One bit per row
+ */
+const JointMask& Trajectory::getJoints(){
+    return mapped->mask;
+}
+
+/**
+ * Get the column for a row of the bound joint table
+ * @param  row The joint's row
+ * @return     The column, or -1 if the joint is not in the trajectory
+ */
+int Trajectory::column(int row){
+    if (row < 0 || row > JOINT_TABLE_SIZE)
+        return -1;
+    return mapped->columns[row];
 }
 
 /**
@@ -330,6 +638,7 @@ bool Trajectory::contains(const string& joint){
  */
 void Trajectory::disableJoint(const string& joint){
     disabledJoints.insert(joint);
+    mapColumns();
 }
 
 /**
@@ -341,69 +650,88 @@ void Trajectory::enableJoint(const string& joint){
 
     if (it != disabledJoints.end())
         disabledJoints.erase(it);
+    mapColumns();
 }
 
 /**
- * Reset the trajectory
+ * Reset the trajectory. A write-enabled trajectory finishes its file and opens it again
+ * for reading.
  * @return True on success
  */
 bool Trajectory::reset(){
-    if (files.size() <= currentWSV){
-        cout << "Error! Resetting trajectory past its list of trajectories. Aborting." << endl;
-        open = false;
-        return false;
+    if (!read){
+        // The recorder finishes the file and opens it for reading on its own thread. The
+        // trajectory is closed until collectRecording() picks it up.
+        recorder->finish();
+        recordFrame = NULL;
+        read = true;
+        frame = 0;
+        passed = -1;
+        owedFrom = -1;
+        owedTo = -1;
+        mapColumns();
+        return true;
     }
 
-    WSVFile* file = files[currentWSV];
-    if (!file || file->errored()){
-        cout << "Last file has errored. Cannot reset." << endl;
-        cout << file->getError() << endl;
+    if (sources.size() <= currentSource){
+        LOOP_LOG(LOG_ERROR, "Error! Resetting trajectory past its list of trajectories. Aborting.");
+        open = false;
         return false;
     }
 
-    if (!read && bufferIndex < file->buffer().size() && bufferIndex > 0)
-        file->storeBuffer(bufferIndex); // Writes what is remaining to the file
-
-    for (int i = 0; i < files.size(); i++){
-        if (files[i] && files[i]->errored()){
-            cout << "Error: " << file->getError() << endl;
+    for (int i = 0; i < sources.size(); i++){
+        if (!sources[i]->rewind()){
+            LOOP_LOG(LOG_ERROR, "Error: %s", sources[i]->getError().c_str());
             open = false;
             return false;
         }
-        files[i]->reset();
     }
 
-    read = true;
-    currentWSV = 0;
-    bufferIndex = 0;
+    currentSource = 0;
     frame = 0;
+    passed = -1;
+    owedFrom = -1;
+    owedTo = -1;
+    lag = 0;
+    useColumns();
 
-    open = files[currentWSV]->loadBuffer();
+    open = sources[currentSource]->current() != NULL;
     return open;
 }
 
 /**
- * Set the header of the trajectory
+ * Set the header of the trajectory and start recording
  * @param header The header as a string
  */
 void Trajectory::setHeader(const string& header){
-    if (!files[currentWSV] || files[currentWSV]->readOnly())
-        return;
-
-    files[currentWSV]->setHeader(header);
-    files[currentWSV]->storeHeader();
+    std::istringstream names(header);
+    Header columns;
+    string name;
+    while (names >> name)
+        columns.push_back(name);
+    setHeader(columns);
 }
 
 /**
- * Set the header of the trajectory
+ * Set the header of the trajectory and start recording
  * @param header The header as a struct
  */
 void Trajectory::setHeader(const Header& header){
-    if (!files[currentWSV] || files[currentWSV]->readOnly())
+    if (read || recorder == NULL || recordFrame != NULL)
         return;
 
-    files[currentWSV]->setHeader(header);
-    files[currentWSV]->storeHeader();
+    if (!recorder->begin(header)){
+        LOOP_LOG(LOG_ERROR, "Cannot record %d columns. At most %d can be recorded.", (int)header.size(), RECORD_MAX_COLUMNS);
+        open = false;
+        return;
+    }
+
+    recordHeader = header;
+    recordColumns.clear();
+    for (int i = 0; i < header.size(); i++)
+        recordColumns[header[i]] = i;
+    recordFrame = recorder->next();
+    mapColumns();
 }
 
 /**
@@ -411,23 +739,128 @@ void Trajectory::setHeader(const Header& header){
  * @return The joint header as a structure
  */
 const Trajectory::Header& Trajectory::getHeader(){
-    if (files[currentWSV])
-        return files[currentWSV]->orderedHeader();
-    vector< string > temp;
-    return temp;
+    if (!read)
+        return recordHeader;
+    if (read && sources.size() > currentSource)
+        return sources[currentSource]->orderedHeader();
+    return noHeader;
+}
+
+/**
+ * Work out which column drives each row of the bound joint table, for every source up front
+ * so that moving on to another source only has to switch maps
+ */
+void Trajectory::mapColumns(){
+    for (int row = 0; row <= JOINT_TABLE_SIZE; row++)
+        unmapped.columns[row] = -1;
+    unmapped.mask.reset();
+    maps.clear();
+
+    if (joints != NULL)
+        maps.resize(read ? sources.size() : 1, unmapped);
+
+    for (int i = 0; i < maps.size(); i++){
+        HeaderMap* header;
+        if (read){
+            if (sources[i]->errored())
+                continue;
+            header = &sources[i]->header();
+        } else {
+            header = &recordColumns;
+        }
+
+        for (int row = 0; row < joints->size(); row++){
+            if (joints->component[row] == NULL)
+                continue;
+
+            const string& name = joints->component[row]->getName();
+            HeaderMap::const_iterator it = header->find(name);
+            if (it == header->end() || disabledJoints.count(name) != 0)
+                continue;
+
+            maps[i].columns[row] = it->second;
+            maps[i].mask.set(row);
+        }
+    }
+    useColumns();
+}
+
+/**
+ * Switch to the column map of the current source
+ */
+void Trajectory::useColumns(){
+    mapped = currentSource < maps.size() ? &maps[currentSource] : &unmapped;
 }
 
 /**
- * Prepare the frame to be written to the file
+ * Pick up a finished recording, if the recorder has it ready
  */
-void Trajectory::prepareFrame(){
-    WSVFile* file = files[currentWSV];
-    if (!open || read || !file || file->errored() )
+void Trajectory::collectRecording(){
+    if (recorder == NULL || !read)
         return;
 
-    if (bufferIndex < file->bufferSize()){
-        file->buffer().push_back(Frame());
-        for (int i = 0; i < file->orderedHeader().size(); i++)
-            file->buffer()[bufferIndex].push_back(0);
+    FrameSource* source = recorder->takeRecording();
+    if (source == NULL){
+        if (recorder->failed()){
+            LOOP_LOG(LOG_ERROR, "Recording to %s failed.", path.c_str());
+            TrajectoryRecorder::retire(recorder);
+            recorder = NULL;
+            open = false;
+        }
+        return;
     }
+
+    TrajectoryRecorder::retire(recorder); // Deleted off the loop. Its thread has already finished.
+    recorder = NULL;
+    sources.push_back(source);
+    previous.resize(source->numCols());
+    scratch.resize(source->numCols());
+    currentSource = 0;
+    mapColumns();
+    open = true;
+}
+
+/**
+ * Check that the trajectory can start over after a source
+ * @param  last The source that would end the trajectory
+ * @return      True if every column of the first source starts where it ends
+ */
+bool Trajectory::closesLoop(FrameSource* last){
+    FrameSource* first = sources[0];
+    const Frame& lastEnd = last->end();
+    const Frame& firstStart = first->start();
+
+    for (int i = 0; i < last->orderedHeader().size(); i++){
+        int index = first->column(last->orderedHeader()[i]);
+        if (index < 0 || fabs( lastEnd[i] - firstStart[index] ) > .01)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Rearrange the frame before the current one after moving on from a source
+ * @param last The source it was taken from
+ */
+void Trajectory::carry(FrameSource* last){
+    if (lag <= 0)
+        return;
+
+    FrameSource* source = sources[currentSource];
+    const Header& names = last->orderedHeader();
+    for (int i = 0; i < names.size(); i++)
+        scratch[source->column(names[i])] = previous[i];
+    previous.swap(scratch);
+}
+
+/**
+ * Interpolate a column between the frame before the current one and the current one
+ * @param  to  The current frame
+ * @param  col The column
+ * @return     The position
+ */
+double Trajectory::at(const double* to, int col){
+    if (lag <= 0)
+        return to[col];
+    return to[col] - lag * (to[col] - previous[col]);
 }
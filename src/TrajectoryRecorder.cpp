@@ -0,0 +1,323 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * Records a write-enabled trajectory from a writer thread. See TrajectoryRecorder.h
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <iostream>
+
+#include "TrajectoryRecorder.h"
+#include "WSVFile.h"
+#include "LoopLog.h"
+
+using std::cout;
+using std::endl;
+
+int64_t TrajectoryRecorder::allDropped = 0;
+RingBuffer< TrajectoryRecorder*, RETIRED_RING_SIZE > TrajectoryRecorder::retired;
+boost::mutex TrajectoryRecorder::reaping;
+
+/**
+ * Create a recorder and start its writer thread. Nothing is written, and the file is not
+ * touched, until begin() is called. Create it off the loop, so that the thread does not
+ * inherit the loop's real time priority.
+ * @param path   The file to record to
+ * @param format The format to record in
+ */
+TrajectoryRecorder::TrajectoryRecorder(const string &path, Format format){
+    this->path = path;
+    this->format = format;
+    begun = false;
+    finishing = false;
+    current = NULL;
+    claimed = false;
+    width = 0;
+    dropped = 0;
+    recording = NULL;
+    done = false;
+    error = false;
+    text = NULL;
+    reported = 0;
+
+    running = true;
+    thread = boost::thread(&TrajectoryRecorder::run, this);
+}
+
+/**
+ * Destructor. Stops the writer thread, finishing the file if recording had begun.
+ */
+TrajectoryRecorder::~TrajectoryRecorder(){
+    running = false;
+    thread.join();
+    delete recording;
+}
+
+/**
+ * Start recording. Loop side. The writer thread creates the file and writes the header.
+ * @param  columns The column names
+ * @return         False if there are more columns than a frame can hold, or recording has already begun
+ */
+bool TrajectoryRecorder::begin(const vector< string > &columns){
+    if (begun || columns.size() > RECORD_MAX_COLUMNS)
+        return false;
+
+    this->columns = columns;
+    width = columns.size();
+    __sync_synchronize();
+    begun = true;
+    return true;
+}
+
+/**
+ * Get the frame to fill in for this tick. Loop side. It starts out zeroed. Every call
+ * has to be followed by commit() before the next.
+ * @return The frame. Never NULL; if the ring is full it is a frame that will be dropped.
+ */
+double* TrajectoryRecorder::next(){
+    RecordedFrame* slot = begun && !finishing ? ring.claim() : NULL;
+    claimed = slot != NULL;
+    current = claimed ? slot->values : scratch.values;
+    memset(current, 0, width * sizeof(double));
+    return current;
+}
+
+/**
+ * Hand the frame from next() to the writer thread. Loop side; never blocks.
+ */
+void TrajectoryRecorder::commit(){
+    if (current == NULL)
+        return;
+    if (claimed)
+        ring.commit();
+    else if (begun && !finishing){
+        __sync_fetch_and_add(&dropped, 1);
+        __sync_fetch_and_add(&allDropped, 1);
+    }
+    current = NULL;
+    claimed = false;
+}
+
+/**
+ * Stop recording. Loop side; never blocks. The writer thread writes out what is left,
+ * closes the file and opens it for reading. The frame from next(), if any, is dropped.
+ */
+void TrajectoryRecorder::finish(){
+    current = NULL;
+    claimed = false;
+    __sync_synchronize();
+    finishing = true;
+}
+
+/**
+ * Collect the finished recording, opened for reading. Loop side; never blocks.
+ * @return The recording, which the caller then owns, or NULL if it is not ready yet or failed
+ */
+FrameSource* TrajectoryRecorder::takeRecording(){
+    if (!done)
+        return NULL;
+    __sync_synchronize();
+    FrameSource* taken = recording;
+    recording = NULL;
+    return taken;
+}
+
+/**
+ * @return True if the file could not be written or read back
+ */
+bool TrajectoryRecorder::failed(){
+    return done && error;
+}
+
+/**
+ * @return The number of frames this recorder dropped because its ring was full
+ */
+int64_t TrajectoryRecorder::numDropped(){
+    return __sync_fetch_and_add(&dropped, 0);
+}
+
+/**
+ * @return The number of frames any recorder dropped because its ring was full
+ */
+int64_t TrajectoryRecorder::totalDropped(){
+    return __sync_fetch_and_add(&allDropped, 0);
+}
+
+/**
+ * Hand a recorder that is done with to be deleted off the loop by reap(). Deleting one
+ * joins its thread and frees its ring, which the loop must not do. Loop side only.
+ * @param recorder The recorder. Its recording must have been taken, or have failed.
+ */
+void TrajectoryRecorder::retire(TrajectoryRecorder* recorder){
+    if (!retired.push(recorder)){
+        // Only if nothing has reaped for RETIRED_RING_SIZE recordings. Its thread has
+        // finished, so this does not wait, but it does free memory on the loop.
+        LOOP_LOG(LOG_WARN, "No room to retire the recorder for %s. Deleting it on the loop.", recorder->path.c_str());
+        delete recorder;
+    }
+}
+
+/**
+ * Delete every recorder retired by the loop. Call from the service threads, never the loop.
+ * @return The number deleted
+ */
+int TrajectoryRecorder::reap(){
+    boost::mutex::scoped_lock guard(reaping);
+    TrajectoryRecorder* recorder;
+    int reaped = 0;
+    while (retired.pop(recorder)){
+        delete recorder;
+        reaped++;
+    }
+    return reaped;
+}
+
+/**
+ * The writer thread. Waits for recording to begin, then drains the ring to the file every
+ * RECORD_DRAIN_PERIOD_US until recording finishes.
+ */
+void TrajectoryRecorder::run(){
+    while (running && !begun)
+        usleep(RECORD_DRAIN_PERIOD_US);
+    if (!running)
+        return;
+
+    __sync_synchronize();
+    bool ok = openFile();
+
+    while (true){
+        // Everything committed before finish() is in the ring by the time it is seen.
+        bool last = finishing || !running;
+        __sync_synchronize();
+        drain();
+
+        int64_t lost = __sync_fetch_and_add(&dropped, 0);
+        if (lost != reported){
+            cout << "Warning: Recording to " << path << " fell behind. " << lost - reported << " frames dropped." << endl;
+            reported = lost;
+        }
+
+        if (last)
+            break;
+        usleep(RECORD_DRAIN_PERIOD_US);
+    }
+
+    ok = closeFile() && ok;
+
+    FrameSource* source = NULL;
+    if (ok && running){
+        string message;
+        source = FrameSource::open(path, message);
+        if (source == NULL)
+            cout << message << endl;
+    }
+
+    recording = source;
+    error = source == NULL;
+    __sync_synchronize();
+    done = true;
+}
+
+/**
+ * Create the file and write the header. Writer thread only.
+ * @return True on success
+ */
+bool TrajectoryRecorder::openFile(){
+    if (format == BINARY){
+        if (writer.open(path, columns, sizeof(double), RECORD_RATE))
+            return true;
+        cout << writer.getError() << endl;
+        return false;
+    }
+    if (format == COMPRESSED){
+        if (compressed.open(path, columns, RECORD_RATE))
+            return true;
+        cout << compressed.getError() << endl;
+        return false;
+    }
+
+    text = fopen(path.c_str(), "w");
+    if (text == NULL){
+        cout << "Trajectory Error: Unable to open file '" << path << "' for recording." << endl;
+        return false;
+    }
+    for (int i = 0; i < columns.size(); i++)
+        fprintf(text, "%s%c", columns[i].c_str(), WRITE_WHITESPACE);
+    fprintf(text, "\n");
+    return true;
+}
+
+/**
+ * Write every frame in the ring to the file. Writer thread only. If the file could not be
+ * opened, the frames are thrown away so the loop can keep going.
+ */
+void TrajectoryRecorder::drain(){
+    RecordedFrame* frame;
+    char value[32];
+    while ((frame = ring.front()) != NULL){
+        if (format == BINARY)
+            writer.write(frame->values);
+        else if (format == COMPRESSED)
+            compressed.write(frame->values);
+        else if (text != NULL){
+            for (int i = 0; i < width; i++)
+                fprintf(text, "%s%c", WSVFile::format_value(frame->values[i], value, sizeof(value)), WRITE_WHITESPACE);
+            fprintf(text, "\n");
+        }
+        ring.release();
+    }
+}
+
+/**
+ * Finish the file. Writer thread only.
+ * @return True if everything was written
+ */
+bool TrajectoryRecorder::closeFile(){
+    if (format == BINARY){
+        if (writer.close() && writer.getError().empty())
+            return true;
+        cout << writer.getError() << endl;
+        return false;
+    }
+    if (format == COMPRESSED){
+        if (compressed.close() && compressed.getError().empty())
+            return true;
+        cout << compressed.getError() << endl;
+        return false;
+    }
+
+    if (text == NULL)
+        return false;
+    bool ok = !ferror(text);
+    ok = fclose(text) == 0 && ok;
+    text = NULL;
+    if (!ok)
+        cout << "Trajectory Error: Unable to finish recording '" << path << "'." << endl;
+    return ok;
+}
@@ -33,6 +33,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *      Author: Solis Knight
  */
 
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
 #include "WSVFile.h"
 
 WSVFile::WSVFile(const string& fname, bool read, int bufferSize) {
@@ -66,12 +71,11 @@ WSVFile::~WSVFile(){
 
 
 void WSVFile::setHeader(const string& line) {
-    static stringstream sline;
-    static string field;
+    stringstream sline;
+    string field;
 
     _orderedHeader.clear();
     _header.clear();
-    sline.clear();
 
     sline << line;
     for (int i = 0; sline >> field; i++) {
@@ -115,75 +119,57 @@ bool WSVFile::loadBuffer() {
         return false;
     }
 
-    static vector<string> fields;
-    static Frame vals;
-    /*static*/ stringstream fieldToVal;
-    static string line;
-    static TrajLineType type;
+    // The line and the rows of the buffer are reused from one call to the next, so once
+    // they have grown to size, reading a buffer does not allocate.
+    string& line = _line;
+    const char* p;
+    const char* field;
+    const char* end;
+    double val;
 
     int line_num = 0;
     int col_num = 0;
-    double val;
-
-    /*fieldToVal.clear();
-    fieldToVal.seekp(0);
-    fieldToVal.seekg(0);*/
-    _buffer.clear();
+    int bad_col;
 
     while ((line_num < _bufferSize) && getline(_file, line)) {
-        // Clear old values
-        fields.clear();
-        vals.clear();
-
-        // If the line was empty, skip it.
-        type = line_type(line);
-        if (type == BLANK || type == COMMENT)
+        // Skip blank lines, comments, and lines that do not start with a number (the header).
+        p = line.c_str();
+        if (line_type(line) == COMMENT || !next_field(p, field, end) || !to_double(field, end, val))
             continue;
 
-        // Split the line into vector of words
-        split(line, fields);
-
-        if (!is_numeric(fields[0]))
-            continue;
+        if (_buffer.size() <= line_num)
+            _buffer.resize(line_num + 1);
+        Frame& vals = _buffer[line_num];
 
         // Valid line found. Update the count.
         line_num++;
         if (DEBUG) cout << line << endl;
-        if (DEBUG) cout << "buffer: ";
-        // Parse lines.
-        for (col_num = 0; col_num < fields.size(); col_num++) {
-            fieldToVal << fields[col_num];
-            // Streaming to a double had better work.
-            if (fieldToVal >> val) {
-                if (DEBUG) cout << '{' << val << '}';
-                vals.push_back(val);
-                fieldToVal.clear();
-            } else {
-                // If it doesn't, throw an error.
-                _error = true;
-                _errorMessageStream << "Trajectory Error: " << "Cannot convert to float. In '"
-                    << filename << "' [line " << line_num << " column " << col_num << "] " << fields[col_num];
-                errorMessage = _errorMessageStream.str();
-                _file.close();
-                return false;
-            }
+
+        col_num = parse_line(line, vals, bad_col);
+        if (bad_col >= 0) {
+            // If it doesn't, throw an error.
+            _error = true;
+            _errorMessageStream << "Trajectory Error: " << "Cannot convert to float. In '"
+                << filename << "' [line " << line_num << " column " << bad_col << "]";
+            errorMessage = _errorMessageStream.str();
+            _file.close();
+            _buffer.resize(line_num - 1);
+            return false;
         }
-        if (DEBUG) cout << endl;
 
         // Check that this line had the right number of columns.
         if (col_num != _cols) {
             _error = true;
             _errorMessageStream << "Trajectory Error: " << "Wrong number of columns. Expected "
-                << _cols << " but saw " << vals.size() << ". In '" << filename << "' [line " << line_num << "]";
+                << _cols << " but saw " << col_num << ". In '" << filename << "' [line " << line_num << "]";
             errorMessage = _errorMessageStream.str();
             _file.close();
+            _buffer.resize(line_num - 1);
             return false;
         }
-
-        // Add this row of values to our data table.
-        _buffer.push_back(vals);
     }
 
+    _buffer.resize(line_num);
 
     // If we read any valid data, return 1
     return line_num != 0;
@@ -228,6 +214,36 @@ void WSVFile::reset(){
     }
 }
 
+bool WSVFile::seek(int line){
+    if (_error || !_read || line < 0 || line >= _lines)
+        return false;
+
+    int entry = line / INDEX_STRIDE;
+    _file.clear();
+    _file.seekg(_index[entry], _file.beg);
+
+    // Skip the lines between the indexed one and the one asked for, as loadBuffer() would.
+    const char* p;
+    const char* field;
+    const char* end;
+    double val;
+    int skip = line - entry * INDEX_STRIDE;
+    while (skip > 0 && getline(_file, _line)) {
+        p = _line.c_str();
+        if (line_type(_line) == COMMENT || !next_field(p, field, end) || !to_double(field, end, val))
+            continue;
+        skip--;
+    }
+
+    if (skip > 0) {
+        _errorMessageStream << "Trajectory Error: Unable to seek to line " << line << " of '" << filename << "'";
+        errorMessage = _errorMessageStream.str();
+        _error = true;
+        return false;
+    }
+    return true;
+}
+
 bool WSVFile::errored(){
     return _error;
 }
@@ -276,22 +292,103 @@ WSVFile::Frame& WSVFile::end(){
     return _end;
 }
 
-// http://stackoverflow.com/a/5577987/2168416
+const char* WSVFile::format_value(double value, char* text, int size) {
+    snprintf(text, size, "%.15g", value);
+    if (strtod(text, NULL) != value)
+        snprintf(text, size, "%.17g", value);
+    return text;
+}
+
 bool WSVFile::is_numeric(const string& str) {
-    /*static*/ stringstream conv;
-    static double tmp;
-    conv.clear();
-    /*conv.seekg(0);
-    conv.seekp(0);*/
-
-    conv << str;
-    conv >> tmp;
-    return conv.eof();
+    double tmp;
+    return to_double(str.c_str(), str.c_str() + str.size(), tmp);
+}
+
+bool WSVFile::next_field(const char*& p, const char*& start, const char*& end) {
+    while (isspace(*p))
+        p++;
+    if (*p == '\0')
+        return false;
+
+    start = p;
+    while (*p != '\0' && !isspace(*p))
+        p++;
+    end = p;
+    return true;
+}
+
+bool WSVFile::to_double(const char* start, const char* end, double& value) {
+    // strtod also takes things like "inf" and "nan", which could be column names.
+    bool negative = *start == '-';
+    const char* p = (*start == '+' || *start == '-') ? start + 1 : start;
+    if (!isdigit(*p) && *p != '.')
+        return false;
+
+    // Fast path for plain decimals like the ones we record: at most 15 significant digits
+    // and no exponent. Both the digits and the power of ten are exact as doubles, so one
+    // division rounds correctly. Anything else goes to strtod.
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int decimals = 0;
+    bool point = false;
+    bool any = false;
+    for (; p < end; p++) {
+        if (isdigit(*p)) {
+            any = true;
+            if (mantissa == 0 && *p == '0') {
+                if (point)
+                    decimals++;
+                continue;
+            }
+            mantissa = mantissa * 10 + (*p - '0');
+            digits++;
+            if (point)
+                decimals++;
+        } else if (*p == '.' && !point) {
+            point = true;
+        } else {
+            break;
+        }
+    }
+
+    if (p == end && any && digits <= 15 && decimals <= 22) {
+        value = (double)mantissa / powers[decimals];
+        if (negative)
+            value = -value;
+        return true;
+    }
+
+    char* parsed;
+    value = strtod(start, &parsed);
+    return parsed == end;
+}
+
+int WSVFile::parse_line(const string& line, Frame& values, int& badField) {
+    const char* p = line.c_str();
+    const char* start;
+    const char* end;
+    double val;
+    int fields = 0;
+
+    values.clear();
+    badField = -1;
+    while (next_field(p, start, end)) {
+        if (!to_double(start, end, val)) {
+            if (badField < 0)
+                badField = fields;
+            val = 0;
+        }
+        values.push_back(val);
+        fields++;
+    }
+    return fields;
 }
 
 void WSVFile::split(const string& line, vector<string>& fields) {
     /*static*/ stringstream sline;
-    static string field;
+    string field;
     sline.clear();
     /*sline.seekp(0);
     sline.seekg(0);*/
@@ -328,110 +425,82 @@ void WSVFile::loadStatistics(){
         return;
     }
 
-    static string line;
-    static string lastLine;
-    /*static*/ stringstream sline;
-    static vector<string> fields;
-    static Frame vals;
+    string& line = _line;
+    string lastLine;
+    vector<string> fields;
+    const char* p;
+    const char* field;
+    const char* end;
+    double val;
+    int bad_col;
 
-    int line_num = 0;
     bool found_header = false;
     bool found_start = false;
     bool isNumeric = false;
 
-    while (getline(_file, line)) {
-        // Clear old values
-        fields.clear();
-        vals.clear();
+    // Offsets are counted rather than asked for, as tellg() costs a system call.
+    std::streamoff offset = 0;
+    std::streamoff lineStart;
+    _index.clear();
 
-        // Load line
-        line_num++;
+    while (getline(_file, line)) {
+        lineStart = offset;
+        offset += line.size() + 1;
 
         // If the line was empty, skip it.
-        TrajLineType t = line_type(line);
-        if (t == BLANK || t == COMMENT)
-            continue;
-
-        lastLine = line;
-
-        if (found_header && found_start)
+        p = line.c_str();
+        if (line_type(line) == COMMENT || !next_field(p, field, end))
             continue;
 
-        // Split the line into vector of words
-        split(line, fields);
-
-        isNumeric = is_numeric(fields[0]);
+        isNumeric = to_double(field, end, val);
 
         // Act on the first row that is not blank or a comment.
         if (!found_header) {
             found_header = true;
 
-            // Set # of columns for this file.
-            _cols = fields.size();
-
-            // Figure out if the row is a header or not, and treat specially. If not header, store start.
-            if (isNumeric) {
-                _hasHeader = false;
-                found_start = true;
-                _start.resize(_cols);
-
-                for (int i = 0; i < _cols; i++){
-                    sline.clear();
-                    /*sline.seekg(0);
-                    sline.seekp(0);*/
-                    sline << fields[i];
-                    sline >> _start[i];
-                }
-
-                _dataStart = 0;
-
-            } else {
+            // Figure out if the row is a header or not, and treat specially.
+            if (!isNumeric) {
                 _dataStart = _file.tellg();
+                split(line, fields);
+                _cols = fields.size();
                 setHeader(fields);
-
                 continue;
             }
+
+            // Set # of columns for this file.
+            _hasHeader = false;
+            _dataStart = 0;
+            _cols = parse_line(line, _start, bad_col);
+            found_start = true;
         }
 
+        // Only lines that start with a number are played.
+        if (!isNumeric)
+            continue;
+
         // Act on the first data member
-        if (!found_start && isNumeric){
+        if (!found_start){
             found_start = true;
-            if (!fields.size() == _cols){
-                _errorMessageStream << "Trajectory Error: Inconsistent column size " << fields.size() << " for file '" << filename << "'";
+            if (parse_line(line, _start, bad_col) != _cols){
+                _errorMessageStream << "Trajectory Error: Inconsistent column size " << _start.size() << " for file '" << filename << "'";
                 errorMessage = _errorMessageStream.str();
                 _error = true;
                 return;
             }
-            _start.resize(_cols);
-            for (int i = 0; i < _cols; i++){
-                sline.clear();
-                /*sline.seekg(0);
-                sline.seekp(0);*/
-                sline << fields[i];
-                sline >> _start[i];
-            }
         }
 
-        // Count the number of data lines in the file.
+        // Count the number of data lines in the file. Swapping keeps the last one without copying it.
+        if (_lines % INDEX_STRIDE == 0)
+            _index.push_back(lineStart);
         _lines++;
+        lastLine.swap(line);
     }
 
-    split(lastLine, fields);
-    if (is_numeric(fields[0])) {
-        if (fields.size() != _cols){
-            _errorMessageStream << "Trajectory Error: Inconsistent column size " << fields.size() << " for file '" << filename << "'";
-            errorMessage = _errorMessageStream.str();
-            _error = true;
-            return;
-        }
-        _end.resize(_cols);
-        for (int i = 0; i < _cols; i++){
-            sline.clear();
-            /*sline.seekp(0);
-            sline.seekg(0);*/
-            sline << fields[i];
-            sline >> _end[i];
-        }
+    if (found_start && parse_line(lastLine, _end, bad_col) != _cols) {
+        _errorMessageStream << "Trajectory Error: Inconsistent column size " << _end.size() << " for file '" << filename << "'";
+        errorMessage = _errorMessageStream.str();
+        _error = true;
+        return;
     }
 
     // Rewind file to beginning of data.
@@ -28,6 +28,56 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "loop.h"
 
 RobotControl robot;
+TaskQueue tasks;
+Scheduler timer(FREQ_200HZ);
+SetpointMailbox setpoints;
+StatePublisher statePublisher;
+
+/**
+ * A LoopTask that runs one of the service wrappers below.
+ */
+template <typename Request, typename Response>
+class ServiceTask : public LoopTask {
+public:
+    typedef bool (*Wrapper)(Request&, Response&);
+
+    ServiceTask(Wrapper wrapper, Request &req, Response &res) : wrapper(wrapper), req(req), res(res) {
+        result = false;
+    }
+
+    void run(){
+        result = wrapper(req, res);
+    }
+
+    bool result;
+
+private:
+    Wrapper wrapper;
+    Request &req;
+    Response &res;
+};
+
+/**
+ * The callback that is actually advertised for most services. It runs on the ROS
+ * service thread and hands the wrapper to the control loop, so the wrapper is applied
+ * between ticks instead of racing with updateHook.
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     Whatever the wrapper returned, or false if the loop could not take it
+ */
+template <typename Request, typename Response, bool (*wrapper)(Request&, Response&)>
+bool onLoop(Request &req, Response &res){
+    ServiceTask<Request, Response> task(wrapper, req, res);
+    bool called = tasks.call(task);
+
+    // Starting a trajectory collects a finished recording, and leaves its recorder to be
+    // deleted here, off the loop.
+    TrajectoryRecorder::reap();
+    return called && task.result;
+}
+
+#define ON_LOOP(service) onLoop< maestor::service::Request, maestor::service::Response, &service >
+
 /**
  * The main method that starts MAESTOR! This is where the ros node is made and all of the 
  * services are advertised. There are also wrappers in here for all of the service methods that 
@@ -38,7 +88,6 @@ RobotControl robot;
  */
 int main(int argc, char **argv) {
     ros::init(argc, argv, "Maestor"); 
-    setRealtime();
 
     //Check for the run type
 
@@ -52,32 +101,131 @@ int main(int argc, char **argv) {
     }
     //Init the node
     NodeHandle n; //Fully initializes the node
-    Scheduler timer(FREQ_200HZ);
+    NodeHandle params("~");
     robot.setPeriod(1.0/timer.getFrequency());
     ServiceServer srv = n.advertiseService("fib", &fib);
     ServiceServer Initsrv = n.advertiseService("initRobot", &initRobot);
     ServiceServer SPsrv = n.advertiseService("setProperties", &setProperties);
+    ServiceServer SPBsrv = n.advertiseService("setPropertiesBatch", &setPropertiesBatch);
     ServiceServer Comsrv = n.advertiseService("command", &command);
     ServiceServer RMsrv = n.advertiseService("requiresMotion", &requiresMotion);
     ServiceServer GPsrv = n.advertiseService("getProperties", &getProperties);
     ServiceServer LTsrv = n.advertiseService("loadTrajectory", &loadTrajectory);
-    ServiceServer IFsrv = n.advertiseService("ignoreFrom", &ignoreFrom);
-    ServiceServer IAFsrv = n.advertiseService("ignoreAllFrom", &ignoreAllFrom);
-    ServiceServer UFsrv = n.advertiseService("unignoreFrom", &unignoreFrom);
-    ServiceServer UAFsrv = n.advertiseService("unignoreAllFrom", &unignoreAllFrom);
-    ServiceServer STsrv = n.advertiseService("setTrigger", &setTrigger);
+    ServiceServer IFsrv = n.advertiseService("ignoreFrom", &ON_LOOP(ignoreFrom));
+    ServiceServer IAFsrv = n.advertiseService("ignoreAllFrom", &ON_LOOP(ignoreAllFrom));
+    ServiceServer UFsrv = n.advertiseService("unignoreFrom", &ON_LOOP(unignoreFrom));
+    ServiceServer UAFsrv = n.advertiseService("unignoreAllFrom", &ON_LOOP(unignoreAllFrom));
+    ServiceServer STsrv = n.advertiseService("setTrigger", &ON_LOOP(setTrigger));
+    ServiceServer LpTsrv = n.advertiseService("loopTrajectory", &ON_LOOP(loopTrajectory));
     ServiceServer ETsrv = n.advertiseService("extendTrajectory", &extendTrajectory);
-    ServiceServer StTsrv = n.advertiseService("startTrajectory", &startTrajectory);
-    ServiceServer SpTsrv = n.advertiseService("stopTrajectory", &stopTrajectory);
+    ServiceServer StTsrv = n.advertiseService("startTrajectory", &ON_LOOP(startTrajectory));
+    ServiceServer SpTsrv = n.advertiseService("stopTrajectory", &ON_LOOP(stopTrajectory));
+    ServiceServer SkTsrv = n.advertiseService("seekTrajectory", &ON_LOOP(seekTrajectory));
+    ServiceServer STRsrv = n.advertiseService("setTrajectoryRate", &ON_LOOP(setTrajectoryRate));
 
     ServiceServer SetPropsrv = n.advertiseService("setProperty", &setProperty);
+    ServiceServer RHsrv = n.advertiseService("resolveHandles", &resolveHandles);
+    ServiceServer SBHsrv = n.advertiseService("setByHandle", &ON_LOOP(setByHandle));
+    ServiceServer GBHsrv = n.advertiseService("getByHandle", &getByHandle);
+    ServiceServer GTSsrv = n.advertiseService("getTimingStats", &getTimingStats);
+    ServiceServer GSTsrv = n.advertiseService("getStageTimes", &getStageTimes);
+
+    // Streamed setpoints. Only the newest message matters, so nothing is queued.
+    double setpointTimeout;
+    params.param("setpoint_timeout", setpointTimeout, 0.05);
+    setpoints.setTimeout(setpointTimeout);
+
+    // Trajectory files with no more than this many megabytes of frames are parsed into
+    // memory when they are loaded. Bigger ones are streamed from disk as they play.
+    double preloadLimit;
+    params.param("trajectory_preload_limit_mb", preloadLimit, DEFAULT_PRELOAD_LIMIT / (1024.0 * 1024.0));
+    FrameSource::setPreloadLimit(preloadLimit > 0 ? (size_t)(preloadLimit * 1024 * 1024) : 0);
+
+    // Preloaded files are kept after they are parsed, up to this many megabytes, so that
+    // loading an unchanged file again does not parse it again. 0 turns this off.
+    double cacheLimit;
+    params.param("trajectory_cache_mb", cacheLimit, DEFAULT_CACHE_LIMIT / (1024.0 * 1024.0));
+    FrameCache::setLimit(cacheLimit > 0 ? (size_t)(cacheLimit * 1024 * 1024) : 0);
+
+    // Log a summary of the loop timing every so often. 0 turns it off.
+    double summaryPeriod;
+    params.param("timing_summary_period", summaryPeriod, 60.0);
+    ros::WallTimer summaryTimer;
+    if (summaryPeriod > 0)
+        summaryTimer = n.createWallTimer(ros::WallDuration(summaryPeriod), &printTimingSummary);
+
+    // Service callbacks get their own thread so a slow one can never make the loop miss
+    // a tick. It has to be started before setRealtime() so that neither it nor the ROS
+    // threads inherit the loop's real time priority.
+    ros::AsyncSpinner spinner(1);
+    spinner.start();
+
+    // Anything the loop logs is printed by a drain thread of its own, so the loop never
+    // waits on the terminal.
+    string logLevel;
+    params.param("log_level", logLevel, string("info"));
+    if (!LoopLog::instance()->setLevel(logLevel.c_str()))
+        cout << "Unknown log level " << logLevel << ". Using info." << endl;
+    LoopLog::instance()->start();
+
+    // waitForMotion blocks its caller until the motion is done, so it gets a queue and
+    // threads of its own instead of holding up every other service while it waits.
+    ros::CallbackQueue waitQueue;
+    NodeHandle waitNode;
+    waitNode.setCallbackQueue(&waitQueue);
+    ServiceServer WFMsrv = waitNode.advertiseService("waitForMotion", &waitForMotion);
+    ros::AsyncSpinner waitSpinner(MAX_MOTION_WAITERS, &waitQueue);
+    waitSpinner.start();
+
+    // startTrajectoryAt can wait on a streamed trajectory's prefetch thread, so it gets a
+    // queue and thread of its own for the same reason.
+    ros::CallbackQueue startAtQueue;
+    NodeHandle startAtNode;
+    startAtNode.setCallbackQueue(&startAtQueue);
+    ServiceServer StTAsrv = startAtNode.advertiseService("startTrajectoryAt", &startTrajectoryAt);
+    ros::AsyncSpinner startAtSpinner(1, &startAtQueue);
+    startAtSpinner.start();
+
+    // Setpoints come in at the controller's rate and go stale quickly, so they get a queue
+    // and thread of their own instead of waiting behind services that parse files.
+    ros::CallbackQueue setpointQueue;
+    NodeHandle setpointNode;
+    setpointNode.setCallbackQueue(&setpointQueue);
+    ros::Subscriber SPsub = setpointNode.subscribe("setpoints", 1, &onSetpoints, ros::TransportHints().tcpNoDelay());
+    ros::AsyncSpinner setpointSpinner(1, &setpointQueue);
+    setpointSpinner.start();
+
+    // Publish the robot state every state_divisor ticks. 0 turns it off. The publisher
+    // has its own thread, for the same reason as the spinner.
+    int stateDivisor;
+    params.param("state_divisor", stateDivisor, 1);
+    if (stateDivisor > 0)
+        statePublisher.start(n, "robot_state", &fetchStateLayout);
+
+    setRealtime();
+    LoopLog::instance()->setLoopThread();
+    timer.start();
 
+    int64_t tick = 0;
     while (ros::ok()) {
-        ros::spinOnce();
+        tasks.runPending();
+        applySetpoints();
         robot.updateHook();
+        if (stateDivisor > 0 && tick % stateDivisor == 0)
+            publishState(tick);
+        tick++;
         timer.sleep();
         timer.update();
     }
+
+    tasks.shutdown();
+    TrajectoryRecorder::reap();
+    statePublisher.stop();
+    waitSpinner.stop();
+    startAtSpinner.stop();
+    setpointSpinner.stop();
+    spinner.stop();
+    LoopLog::instance()->stop();
     return 0;
 }
 
@@ -98,18 +246,38 @@ void setRealtime(){
 }
 
 /**
- * Wrapper
+ * Wrapper. Reading the config file and building the robot from it happen here on the
+ * service thread; the loop only swaps the new robot in.
  * @param  req The ROS request service part
  * @param  res The ROS response service part
  * @return     True
  */
 bool initRobot(maestor::initRobot::Request &req, maestor::initRobot::Response &res)
 {
-    robot.initRobot(req.path);
-    return true;
+    struct SwapTask : public LoopTask {
+        void run(){
+            robot.swapRobot();
+        }
+    } task;
+
+    xml_document doc;
+    if (!robot.loadConfig(req.path, doc))
+        return true;
 
+    robot.buildRobot(doc);
+    return tasks.call(task);
 }
 
+/**
+ * Carries looked up property sets to the loop
+ */
+struct PropertiesTask : public LoopTask {
+    RobotControl::PropertyUpdates updates;
+    void run(){
+        robot.setProperties(updates);
+    }
+};
+
 /**
  * Wrapper
  * @param  req The ROS request service part
@@ -118,62 +286,189 @@ bool initRobot(maestor::initRobot::Request &req, maestor::initRobot::Response &r
  */
 bool setProperties(maestor::setProperties::Request &req, maestor::setProperties::Response &res)
 {
-    robot.setProperties(req.names, req.properties, req.values);
-    return true;
+    PropertiesTask task;
+    if (!robot.prepareProperties(req.names, req.properties, req.values, task.updates))
+        return true;
+
+    return tasks.call(task);
+}
+
+/**
+ * Wrapper
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True
+ */
+bool setPropertiesBatch(maestor::setPropertiesBatch::Request &req, maestor::setPropertiesBatch::Response &res)
+{
+    PropertiesTask task;
+    res.success = robot.prepareProperties(req.names, req.properties, req.values, task.updates);
+    if (!res.success)
+        return true;
+
+    return tasks.call(task);
 }
 
 // Control Commands
 
 /**
- * Wrapper
+ * Wrapper. The command and its target are looked up here; the loop only runs it.
  * @param  req The ROS request service part
  * @param  res The ROS response service part
  * @return     True
  */
 bool command(maestor::command::Request &req, maestor::command::Response &res)
 {
-    robot.command(req.name, req.target);
-    return true;
+    struct CommandTask : public LoopTask {
+        RobotControl::Command comm;
+        void run(){
+            robot.command(comm);
+        }
+    } task;
+
+    if (!robot.prepareCommand(req.name, req.target, task.comm))
+        return true;
+
+    return tasks.call(task);
 }
 
 // Feedback Commands
 
 /**
- * Wrapper
+ * Wrapper. The component is looked up here; the loop only reads it.
  * @param  req The ROS request service part
  * @param  res The ROS response service part
  * @return     True
  */
 bool requiresMotion(maestor::requiresMotion::Request &req, maestor::requiresMotion::Response &res)
 {
-    res.requiresMotion = robot.requiresMotion(req.name);
+    struct MotionTask : public LoopTask {
+        RobotComponent* component;
+        bool moving;
+        void run(){
+            moving = robot.requiresMotion(component);
+        }
+    } task;
+
+    res.requiresMotion = false;
+    task.component = robot.getComponent(req.name);
+    if (task.component == NULL)
+        return true;
+
+    if (!tasks.call(task))
+        return false;
+
+    res.requiresMotion = task.moving;
     return true;
 }
 
 /**
- * Wrapper
+ * Wrapper. Blocks until every named component is within tolerance of its goal, or
+ * the timeout runs out. The loop checks once per tick and wakes this up as soon as they
+ * all are.
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True on success
+ */
+bool waitForMotion(maestor::waitForMotion::Request &req, maestor::waitForMotion::Response &res)
+{
+    struct AddTask : public LoopTask {
+        MotionWaiter *waiter;
+        const vector<string> *names;
+        bool added;
+        void run(){
+            added = robot.addWaiter(waiter, *names);
+        }
+    } add;
+
+    struct RemoveTask : public LoopTask {
+        MotionWaiter *waiter;
+        void run(){
+            robot.removeWaiter(waiter);
+        }
+    } remove;
+
+    MotionWaiter waiter(req.tolerance);
+    res.arrived = false;
+
+    add.waiter = &waiter;
+    add.names = &req.names;
+    add.added = false;
+    if (!tasks.call(add))
+        return false;
+    if (!add.added)
+        return true;
+
+    if (!waiter.wait(req.timeout)){
+        // Timed out. Take the waiter back from the loop before it goes out of scope.
+        remove.waiter = &waiter;
+        if (!tasks.call(remove))
+            return false;
+    }
+
+    res.arrived = waiter.succeeded();
+    return true;
+}
+
+/**
+ * Wrapper. The request is looked up and the reply formatted here; the loop only reads
+ * the values.
  * @param  req The ROS request service part
  * @param  res The ROS response service part
  * @return     True
  */
 bool getProperties(maestor::getProperties::Request &req, maestor::getProperties::Response &res)
 {
-    res.properties = robot.getProperties(req.name, req.properties);
+    struct QueryTask : public LoopTask {
+        RobotControl::PropertyQuery query;
+        void run(){
+            robot.query(query);
+        }
+    } task;
+
+    robot.prepareQuery(req.name, req.properties, task.query);
+    if (!tasks.call(task))
+        return false;
+
+    res.properties = robot.formatQuery(task.query);
     return true;
 }
 
 // Trajectory Commands
 
 /**
- * Wrapper
+ * Wrapper. Trajectories are made here on the service thread and then handed to the loop.
+ * Ones that are read are parsed here. Write-enabled ones start their recorder's thread
+ * here, and do not create their file until recording begins.
  * @param  req The ROS request service part
  * @param  res The ROS response service part
  * @return     True
  */
 bool loadTrajectory(maestor::loadTrajectory::Request &req, maestor::loadTrajectory::Response &res)
 {
-    res.success = robot.loadTrajectory(req.name, req.path, req.read);
-    return true;
+    struct LoadTask : public LoopTask {
+        maestor::loadTrajectory::Request *req;
+        Trajectory* traj;
+        Trajectory* replaced;
+        bool success;
+        void run(){
+            success = robot.addTrajectory(req->name, traj, replaced);
+        }
+    } task;
+
+    task.req = &req;
+    task.traj = new Trajectory(req.path, req.read);
+    task.replaced = NULL;
+    task.success = false;
+
+    bool called = tasks.call(task);
+    if (!task.success)
+        delete task.traj;
+    delete task.replaced;
+    TrajectoryRecorder::reap();
+
+    res.success = task.success;
+    return called;
 }
 
 /**
@@ -242,12 +537,48 @@ bool setTrigger(maestor::setTrigger::Request &req, maestor::setTrigger::Response
  * @param  res The ROS response service part
  * @return     True
  */
-bool extendTrajectory(maestor::extendTrajectory::Request &req, maestor::extendTrajectory::Response &res)
+bool loopTrajectory(maestor::loopTrajectory::Request &req, maestor::loopTrajectory::Response &res)
 {
-    res.success = robot.extendTrajectory(req.name, req.path);
+    res.success = robot.loopTrajectory(req.name, req.loop);
     return true;
 }
 
+/**
+ * Wrapper. The extension file is opened (and preloaded, if it is small enough) here on
+ * the service thread, and only the checks and the append happen on the loop.
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True
+ */
+bool extendTrajectory(maestor::extendTrajectory::Request &req, maestor::extendTrajectory::Response &res)
+{
+    struct ExtendTask : public LoopTask {
+        string name;
+        FrameSource* source;
+        bool success;
+        void run(){
+            success = robot.extendTrajectory(name, source);
+        }
+    } task;
+
+    string error;
+    task.name = req.name;
+    task.source = FrameSource::open(req.path, error);
+    task.success = false;
+    if (task.source == NULL){
+        cout << error << endl;
+        res.success = false;
+        return true;
+    }
+
+    bool called = tasks.call(task);
+    if (!task.success)
+        delete task.source;
+
+    res.success = task.success;
+    return called;
+}
+
 /**
  * Wrapper
  * @param  req The ROS request service part
@@ -278,8 +609,384 @@ bool stopTrajectory(maestor::stopTrajectory::Request &req, maestor::stopTrajecto
  * @param  res The ROS response service part
  * @return     True
  */
+bool seekTrajectory(maestor::seekTrajectory::Request &req, maestor::seekTrajectory::Response &res)
+{
+    res.success = robot.seekTrajectory(req.name, req.frame);
+    return true;
+}
+
+/**
+ * Wrapper. Sends the trajectory to the frame, then starts it there. A streamed trajectory
+ * reads the frame on its prefetch thread, so the start (and its check that every joint is
+ * where the frame has it) waits here, off the loop, until the frame is in.
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True on success
+ */
+bool startTrajectoryAt(maestor::startTrajectoryAt::Request &req, maestor::startTrajectoryAt::Response &res)
+{
+    struct StartTask : public LoopTask {
+        maestor::startTrajectoryAt::Request *req;
+        bool seek;
+        bool seeking;
+        bool started;
+        void run(){
+            seeking = false;
+            started = false;
+            if (seek && !robot.seekTrajectory(req->name, req->frame))
+                return;
+            seeking = robot.seekingTrajectory(req->name);
+            if (!seeking)
+                started = robot.startTrajectory(req->name);
+        }
+    } task;
+
+    task.req = &req;
+    task.seek = true;
+    if (!tasks.call(task))
+        return false;
+
+    // Give the prefetch thread up to START_AT_TIMEOUT_NS, however long each call takes.
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t deadline = (int64_t)now.tv_sec * NSEC_PER_SECOND + now.tv_nsec + START_AT_TIMEOUT_NS;
+    task.seek = false;
+    while (task.seeking){
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if ((int64_t)now.tv_sec * NSEC_PER_SECOND + now.tv_nsec >= deadline)
+            break;
+        usleep(1000);
+        if (!tasks.call(task))
+            return false;
+    }
+
+    TrajectoryRecorder::reap();
+    res.success = task.started;
+    return true;
+}
+
+/**
+ * Wrapper
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True
+ */
+bool setTrajectoryRate(maestor::setTrajectoryRate::Request &req, maestor::setTrajectoryRate::Response &res)
+{
+    res.success = robot.setTrajectoryRate(req.name, req.rate);
+    return true;
+}
+
+/**
+ * Wrapper. Looked up here, the same as setProperties.
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True
+ */
 bool setProperty(maestor::setProperty::Request &req, maestor::setProperty::Response &res)
 {
-    robot.set(req.name, req.property, req.value);
+    PropertiesTask task;
+    robot.prepareProperties(vector<string>(1, req.name), vector<string>(1, req.property),
+        vector<double>(1, req.value), task.updates);
+    if (task.updates.components.empty())
+        return true;
+
+    return tasks.call(task);
+}
+
+// Handle Commands
+
+/**
+ * Wrapper. Resolves each name and property pair to a handle, -1 for pairs that do
+ * not exist.
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True
+ */
+bool resolveHandles(maestor::resolveHandles::Request &req, maestor::resolveHandles::Response &res)
+{
+    struct ResolveTask : public LoopTask {
+        vector<RobotComponent*> components;
+        vector<PROPERTY> properties;
+        maestor::resolveHandles::Response *res;
+        void run(){
+            for (int i = 0; i < properties.size(); i++){
+                if (res->handles[i] != -1)
+                    res->handles[i] = robot.resolveHandle(components[i], properties[i]);
+            }
+        }
+    } task;
+
+    if (req.names.size() != req.properties.size()){
+        cout << "Error! Size of entered fields not consistent. Aborting." << endl;
+        return true;
+    }
+
+    // Components and properties are looked up here. Unknown ones get -1 now, and the loop
+    // skips them.
+    res.handles.resize(req.names.size(), 0);
+    task.components.resize(req.names.size());
+    task.properties.resize(req.names.size());
+    for (int i = 0; i < req.names.size(); i++){
+        if (!Names::lookup(req.properties[i], task.properties[i])){
+            LOOP_LOG(LOG_ERROR, "Error. No property with name %s registered. Aborting.", req.properties[i].c_str());
+            res.handles[i] = -1;
+            continue;
+        }
+        task.components[i] = robot.getComponent(req.names[i]);
+        if (task.components[i] == NULL)
+            res.handles[i] = -1;
+    }
+    task.res = &res;
+    return tasks.call(task);
+}
+
+/**
+ * Wrapper. Values for handles that are not valid are skipped.
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True
+ */
+bool setByHandle(maestor::setByHandle::Request &req, maestor::setByHandle::Response &res)
+{
+    if (req.handles.size() != req.values.size()){
+        cout << "Error! Size of entered fields not consistent. Aborting." << endl;
+        res.success = false;
+        return true;
+    }
+
+    res.success = true;
+    for (int i = 0; i < req.handles.size(); i++){
+        if (!robot.setByHandle(req.handles[i], req.values[i]))
+            res.success = false;
+    }
+    return true;
+}
+
+/**
+ * Wrapper. The response is sized here so that the loop only has to fill it in.
+ * Handles that are not valid read as 0.
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True on success
+ */
+bool getByHandle(maestor::getByHandle::Request &req, maestor::getByHandle::Response &res)
+{
+    struct GetTask : public LoopTask {
+        maestor::getByHandle::Request *req;
+        maestor::getByHandle::Response *res;
+        void run(){
+            res->success = true;
+            for (int i = 0; i < req->handles.size(); i++){
+                if (!robot.getByHandle(req->handles[i], res->values[i])){
+                    res->values[i] = 0;
+                    res->success = false;
+                }
+            }
+        }
+    } task;
+
+    res.values.resize(req.handles.size());
+    task.req = &req;
+    task.res = &res;
+    return tasks.call(task);
+}
+
+/**
+ * Receive a message on the setpoints topic. Runs on the spinner thread and only copies
+ * the message into the mailbox for the loop.
+ * @param msg The setpoints
+ */
+void onSetpoints(const maestor::Setpoints::ConstPtr &msg)
+{
+    if (msg->handles.size() != msg->values.size()){
+        cout << "Error! Size of entered fields not consistent. Aborting." << endl;
+        return;
+    }
+    if (msg->handles.empty())
+        return;
+    int64_t sent = msg->header.stamp.isZero() ? 0 : (int64_t)msg->header.stamp.toNSec();
+    if (!setpoints.post(&msg->handles[0], &msg->values[0], msg->handles.size(), sent))
+        cout << "Error! More than " << SETPOINT_CAPACITY << " setpoints in one message. Aborting." << endl;
+}
+
+/**
+ * Apply the newest streamed setpoints, if any arrived since the last tick. Runs on
+ * the loop. Handles that are not valid are skipped.
+ */
+void applySetpoints()
+{
+    static Setpoints current;   // Too big to want on the stack. Only ever used by the loop.
+    if (!setpoints.take(current))
+        return;
+
+    for (int i = 0; i < current.count; i++)
+        robot.setByHandle(current.handles[i], current.values[i]);
+}
+
+/**
+ * Take a snapshot of the robot for the state publisher. Runs on the loop. If the
+ * publisher is still busy with the last one this tick's is skipped.
+ * @param tick The loop tick
+ */
+void publishState(int64_t tick)
+{
+    StateSnapshot* snapshot = statePublisher.claim();
+    if (snapshot == NULL)
+        return;
+
+    robot.snapshotState(*snapshot);
+    snapshot->tick = tick;
+    snapshot->stamp = ros::Time::now().toSec();
+    statePublisher.commit();
+}
+
+/**
+ * Get the names that go with the state snapshots. Called by the state publisher's
+ * thread when the robot has been initialized again.
+ * @param  layout Filled with the names
+ * @return        True on success
+ */
+bool fetchStateLayout(StateLayout &layout)
+{
+    struct LayoutTask : public LoopTask {
+        StateLayout *layout;
+        void run(){
+            robot.getStateLayout(*layout);
+        }
+    } task;
+
+    task.layout = &layout;
+    return tasks.call(task);
+}
+
+/**
+ * Get the loop timing measurements. Only copying them is done on the loop; the
+ * response is filled in here.
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True
+ */
+bool getTimingStats(maestor::getTimingStats::Request &req, maestor::getTimingStats::Response &res)
+{
+    static TimingStats stats;   // Too big to want on the stack. Only ever used by the service thread.
+    if (!snapshotTimingStats(stats, req.reset))
+        return false;
+
+    res.ticks = stats.ticks;
+    res.overruns = stats.overruns;
+    res.skipped = stats.skipped;
+
+    res.latency_min = stats.wakeLatency.min() / 1000.0;
+    res.latency_mean = stats.wakeLatency.mean() / 1000.0;
+    res.latency_p99 = stats.wakeLatency.percentile(.99) / 1000.0;
+    res.latency_max = stats.wakeLatency.max() / 1000.0;
+
+    res.work_min = stats.workTime.min() / 1000.0;
+    res.work_mean = stats.workTime.mean() / 1000.0;
+    res.work_p99 = stats.workTime.percentile(.99) / 1000.0;
+    res.work_max = stats.workTime.max() / 1000.0;
+
+    // Only send the buckets up to the last one that has anything in it.
+    int used = 0;
+    for (int i = 0; i < stats.wakeLatency.numBuckets(); i++){
+        if (stats.wakeLatency.bucketCount(i) != 0 || stats.workTime.bucketCount(i) != 0)
+            used = i + 1;
+    }
+    for (int i = 0; i < used; i++){
+        res.bucket_bounds.push_back(stats.wakeLatency.bucketLowerBound(i) / 1000.0);
+        res.latency_counts.push_back(stats.wakeLatency.bucketCount(i));
+        res.work_counts.push_back(stats.workTime.bucketCount(i));
+    }
+    return true;
+}
+
+/**
+ * Copy the scheduler's timing measurements from the loop.
+ * @param  stats Filled with the measurements
+ * @param  reset If true the measurements are cleared after being copied
+ * @return       True on success
+ */
+bool snapshotTimingStats(TimingStats &stats, bool reset)
+{
+    struct SnapshotTask : public LoopTask {
+        TimingStats *stats;
+        bool reset;
+        void run(){
+            *stats = timer.getStats();
+            if (reset)
+                timer.resetStats();
+        }
+    } task;
+
+    task.stats = &stats;
+    task.reset = reset;
+    return tasks.call(task);
+}
+
+/**
+ * Print a one line summary of the loop timing since the last summary. Runs on a
+ * ROS timer, off the loop.
+ * @param event The timer event
+ */
+void printTimingSummary(const ros::WallTimerEvent &event)
+{
+    static TimingStats stats;
+    if (!snapshotTimingStats(stats, true))
+        return;
+
+    cout << "Loop timing: " << stats.ticks << " ticks, "
+         << stats.overruns << " overruns, " << stats.skipped << " skipped periods. "
+         << "Wake latency (us) min/mean/p99/max "
+         << stats.wakeLatency.min() / 1000.0 << "/" << stats.wakeLatency.mean() / 1000.0 << "/"
+         << stats.wakeLatency.percentile(.99) / 1000.0 << "/" << stats.wakeLatency.max() / 1000.0 << ". "
+         << "Work (us) min/mean/p99/max "
+         << stats.workTime.min() / 1000.0 << "/" << stats.workTime.mean() / 1000.0 << "/"
+         << stats.workTime.percentile(.99) / 1000.0 << "/" << stats.workTime.max() / 1000.0 << ". "
+         << "Setpoints " << setpoints.numStale() << " stale, " << setpoints.numDropped() << " overwritten in total. "
+         << "State snapshots " << statePublisher.numSkipped() << " skipped in total. "
+         << "Log messages " << LoopLog::instance()->numDropped() << " lost in total. "
+         << "Trajectory streams " << StreamedSource::totalUnderruns() << " underruns in total. "
+         << "Recordings " << TrajectoryRecorder::totalDropped() << " frames dropped in total." << endl;
+}
+
+/**
+ * Get the per stage timing of the update hook over the profiler's window. Profiling is
+ * turned on and off with the ProfileOn and ProfileOff commands. The window is copied on
+ * the loop and summarized here.
+ * @param  req The ROS request service part
+ * @param  res The ROS response service part
+ * @return     True on success
+ */
+bool getStageTimes(maestor::getStageTimes::Request &req, maestor::getStageTimes::Response &res)
+{
+    static StageProfiler profile;   // Too big to want on the stack. Only ever used by the service thread.
+
+    struct SnapshotTask : public LoopTask {
+        bool reset;
+        void run(){
+            profile = robot.getProfiler();
+            if (reset)
+                robot.getProfiler().reset();
+        }
+    } task;
+
+    task.reset = req.reset;
+    if (!tasks.call(task))
+        return false;
+
+    res.enabled = profile.isEnabled();
+    res.samples = profile.numSamples();
+
+    StageSummary summary;
+    for (int i = 0; i < NUM_STAGES; i++){
+        if (!profile.summarize((STAGE)i, summary))
+            continue;
+        res.stages.push_back(StageProfiler::stageName((STAGE)i));
+        res.min.push_back(summary.min / 1000.0);
+        res.mean.push_back(summary.mean / 1000.0);
+        res.p99.push_back(summary.p99 / 1000.0);
+        res.max.push_back(summary.max / 1000.0);
+    }
     return true;
 }
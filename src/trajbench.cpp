@@ -0,0 +1,382 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * trajbench: measures how fast trajectory files are read.
+ *
+ *   trajbench [--lines N] [--cols N] [--keys N] [file]
+ *
+ * With no file, a text trajectory of N lines (a million by default) of random values is
+ * written to a temporary file first, and removed afterwards. Each pass over the file is
+ * timed and reported in lines and megabytes per second. The file is then compressed, and
+ * decoding it timed the same way.
+ *
+ * With --keys, a keyframe trajectory of N keyframes is written too, and playing it back
+ * is timed per frame, against reading the same frames from a preloaded file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "WSVFile.h"
+#include "FrameSource.h"
+#include "FrameCache.h"
+#include "KeyframeSource.h"
+#include "CompressedTrajectory.h"
+
+#define DEFAULT_LINES 1000000
+#define DEFAULT_COLS 40
+#define KEY_SPACING .5      // Seconds between generated keyframes
+
+/**
+ * @return The wall clock time in seconds
+ */
+double now(){
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * Write a text trajectory of random values
+ * @param  path  Where to write it
+ * @param  lines Number of frames
+ * @param  cols  Number of columns
+ * @return       True on success
+ */
+bool generate(const string &path, int lines, int cols){
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == NULL)
+        return false;
+
+    for (int c = 0; c < cols; c++)
+        fprintf(file, "J%d%c", c, WRITE_WHITESPACE);
+    fprintf(file, "\n");
+
+    srand(1);
+    for (int l = 0; l < lines; l++){
+        for (int c = 0; c < cols; c++)
+            fprintf(file, "%.6f%c", (rand() / (double)RAND_MAX - .5) * 3, WRITE_WHITESPACE);
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
+
+/**
+ * Write a keyframe trajectory of random values. Every joint has a keyframe every
+ * KEY_SPACING seconds, except that every third one is left out for odd joints.
+ * @param  path Where to write it
+ * @param  keys Number of keyframes
+ * @param  cols Number of joints
+ * @return      True on success
+ */
+bool generateKeys(const string &path, int keys, int cols){
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == NULL)
+        return false;
+
+    fprintf(file, "%s", KEYFRAME_TIME_COLUMN);
+    for (int c = 0; c < cols; c++)
+        fprintf(file, "%cJ%d", WRITE_WHITESPACE, c);
+    fprintf(file, "\n");
+
+    srand(1);
+    for (int k = 0; k < keys; k++){
+        fprintf(file, "%g", k * KEY_SPACING);
+        for (int c = 0; c < cols; c++){
+            if (c % 2 == 1 && k % 3 == 1 && k + 1 < keys)
+                fprintf(file, "%c-", WRITE_WHITESPACE);
+            else
+                fprintf(file, "%c%.6f", WRITE_WHITESPACE, (rand() / (double)RAND_MAX - .5) * 3);
+        }
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
+
+/**
+ * Play a source to its end, a frame at a time, as the loop would
+ * @param  source The source
+ * @param  sum    Has the first column of every frame added to it
+ * @return        Frames played
+ */
+long play(FrameSource* source, double &sum){
+    long frames = 0;
+    do {
+        const double* values = source->current();
+        if (values == NULL)
+            break;
+        sum += values[0];
+        frames++;
+    } while (source->advance());
+    return frames;
+}
+
+/**
+ * Time loading and playing a keyframe trajectory, and the same frames preloaded
+ * @param  keys Number of keyframes
+ * @param  cols Number of joints
+ * @param  sum  Has the first column of every frame added to it
+ * @return      False on error
+ */
+bool benchKeyframes(int keys, int cols, double &sum){
+    char name[] = "/tmp/trajbenchXXXXXX";
+    int fd = mkstemp(name);
+    if (fd < 0){
+        fprintf(stderr, "Unable to create a temporary file.\n");
+        return false;
+    }
+    close(fd);
+    unlink(name);
+    string path = string(name) + KEYFRAME_EXTENSION;
+
+    printf("Writing %d keyframes of %d joints to %s\n", keys, cols, path.c_str());
+    if (!generateKeys(path, keys, cols)){
+        fprintf(stderr, "Unable to write %s.\n", path.c_str());
+        unlink(path.c_str());
+        return false;
+    }
+
+    string error;
+    double start = now();
+    FrameSource* source = FrameSource::open(path, error);
+    double loaded = now();
+    unlink(path.c_str());
+    if (source == NULL){
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    printf("%-28s %8.3f s %12d frames\n", "Keyframes (fit splines)", loaded - start, source->numFrames());
+
+    start = now();
+    long frames = play(source, sum);
+    double played = now();
+    printf("%-28s %8.3f s %12.1f ns/frame\n", "Keyframes (play)", played - start, (played - start) * 1e9 / frames);
+
+    // The same frames, written out densely and preloaded.
+    string dense = string(name) + ".txt";
+    FILE* file = fopen(dense.c_str(), "w");
+    if (file == NULL){
+        delete source;
+        return false;
+    }
+    for (int c = 0; c < cols; c++)
+        fprintf(file, "J%d%c", c, WRITE_WHITESPACE);
+    fprintf(file, "\n");
+    source->rewind();
+    do {
+        const double* values = source->current();
+        for (int c = 0; c < cols; c++)
+            fprintf(file, "%.6f%c", values[c], WRITE_WHITESPACE);
+        fprintf(file, "\n");
+    } while (source->advance());
+    fclose(file);
+    delete source;
+
+    source = FrameSource::open(dense, error);
+    unlink(dense.c_str());
+    if (source == NULL){
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    start = now();
+    frames = play(source, sum);
+    played = now();
+    printf("%-28s %8.3f s %12.1f ns/frame\n", "Preloaded (play)", played - start, (played - start) * 1e9 / frames);
+    delete source;
+    return true;
+}
+
+/**
+ * Write a text trajectory out in the compressed format
+ * @param  in  Path of the text file
+ * @param  out Path of the compressed file
+ * @return     Size of the compressed file, or 0 on error
+ */
+long compress(const string &in, const string &out){
+    WSVFile file(in, true, STREAM_BUFFER_SIZE);
+    CompressedTrajectoryWriter writer;
+    if (file.errored() || !writer.open(out, file.orderedHeader(), 0)){
+        fprintf(stderr, "%s\n", file.errored() ? file.getError().c_str() : writer.getError().c_str());
+        return 0;
+    }
+
+    while (file.loadBuffer()){
+        WSVFile::Buffer& buffer = file.buffer();
+        for (int r = 0; r < buffer.size(); r++){
+            if (!writer.write(&buffer[r][0])){
+                fprintf(stderr, "%s\n", writer.getError().c_str());
+                return 0;
+            }
+        }
+    }
+    if (!writer.close()){
+        fprintf(stderr, "%s\n", writer.getError().c_str());
+        return 0;
+    }
+
+    struct stat info;
+    return stat(out.c_str(), &info) == 0 ? info.st_size : 0;
+}
+
+/**
+ * Print one timed pass
+ * @param name    What was timed
+ * @param seconds How long it took
+ * @param lines   Frames read
+ * @param bytes   Size of the file
+ */
+void report(const char* name, double seconds, long lines, long bytes){
+    printf("%-28s %8.3f s %12.0f lines/s %9.1f MB/s\n",
+        name, seconds, lines / seconds, bytes / seconds / (1024 * 1024));
+}
+
+int main(int argc, char** argv){
+    int lines = DEFAULT_LINES;
+    int cols = DEFAULT_COLS;
+    int keys = 0;
+    string path;
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc)
+            lines = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cols") == 0 && i + 1 < argc)
+            cols = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--keys") == 0 && i + 1 < argc)
+            keys = atoi(argv[++i]);
+        else
+            path = argv[i];
+    }
+
+    bool generated = path.empty();
+    if (generated){
+        char name[] = "/tmp/trajbenchXXXXXX";
+        int fd = mkstemp(name);
+        if (fd < 0){
+            fprintf(stderr, "Unable to create a temporary file.\n");
+            return 1;
+        }
+        close(fd);
+        path = name;
+
+        printf("Writing %d lines of %d columns to %s\n", lines, cols, path.c_str());
+        if (!generate(path, lines, cols)){
+            fprintf(stderr, "Unable to write %s.\n", path.c_str());
+            unlink(path.c_str());
+            return 1;
+        }
+    }
+
+    struct stat info;
+    long bytes = stat(path.c_str(), &info) == 0 ? info.st_size : 0;
+
+    // Opening a file reads it once to count the frames and find the first and last.
+    double start = now();
+    WSVFile file(path, true, STREAM_BUFFER_SIZE);
+    double opened = now();
+    if (file.errored()){
+        fprintf(stderr, "%s\n", file.getError().c_str());
+        if (generated)
+            unlink(path.c_str());
+        return 1;
+    }
+    report("Open (statistics pass)", opened - start, file.numLines(), bytes);
+
+    // Then it is parsed a buffer at a time as it plays.
+    long frames = 0;
+    double sum = 0;
+    start = now();
+    while (file.loadBuffer()){
+        WSVFile::Buffer& buffer = file.buffer();
+        for (int r = 0; r < buffer.size(); r++)
+            sum += buffer[r][0];
+        frames += buffer.size();
+    }
+    double parsed = now();
+    if (file.errored())
+        fprintf(stderr, "%s\n", file.getError().c_str());
+    report("Parse (loadBuffer pass)", parsed - start, frames, bytes);
+
+    // Both together, as when a file is preloaded.
+    string error;
+    FrameSource::setPreloadLimit((size_t)-1);
+    FrameCache::setLimit((size_t)-1);
+    start = now();
+    FrameSource* source = FrameSource::open(path, error);
+    double loaded = now();
+    if (source == NULL)
+        fprintf(stderr, "%s\n", error.c_str());
+    else
+        report("Preload (FrameSource::open)", loaded - start, source->numFrames(), bytes);
+    delete source;
+
+    // And again, now that the parsed file is cached.
+    start = now();
+    source = FrameSource::open(path, error);
+    loaded = now();
+    if (source == NULL)
+        fprintf(stderr, "%s\n", error.c_str());
+    else
+        report("Reload (cached)", loaded - start, source->numFrames(), bytes);
+    delete source;
+
+    // Compressed, and decoded as the prefetch thread would.
+    string compressed = path + COMPRESSED_EXTENSION;
+    long compressedBytes = compress(path, compressed);
+    if (compressedBytes > 0){
+        printf("Compressed to %ld bytes, %.1f%% of the text\n", compressedBytes, 100.0 * compressedBytes / bytes);
+        CompressedTrajectoryReader reader(compressed, STREAM_BUFFER_SIZE);
+        frames = 0;
+        start = now();
+        while (reader.loadBuffer()){
+            FrameReader::Buffer& buffer = reader.buffer();
+            for (int r = 0; r < buffer.size(); r++)
+                sum += buffer[r][0];
+            frames += buffer.size();
+        }
+        double decoded = now();
+        if (reader.errored())
+            fprintf(stderr, "%s\n", reader.getError().c_str());
+        report("Decode (compressed)", decoded - start, frames, compressedBytes);
+    }
+    unlink(compressed.c_str());
+
+    if (keys > 0 && !benchKeyframes(keys, cols, sum)){
+        if (generated)
+            unlink(path.c_str());
+        return 1;
+    }
+
+    printf("Checksum %g\n", sum);
+    if (generated)
+        unlink(path.c_str());
+    return 0;
+}
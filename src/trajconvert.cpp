@@ -0,0 +1,254 @@
+/*
+Copyright (c) 2013, Drexel University, iSchool, Applied Informatics Group
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * trajconvert: converts trajectories between the whitespace separated text format and
+ * the binary and compressed formats. The direction is taken from the input file: binary
+ * and compressed files are converted to text, and text files to the compressed format if
+ * the output ends in .trz, or to the binary format otherwise.
+ *
+ *   trajconvert [--float] [--rate HZ] [--quantum Q] input output
+ *
+ * --float stores floats instead of doubles when writing a binary file, halving its size.
+ * --rate sets the rate recorded in a binary or compressed file. Text files are played one
+ * frame per tick, so it defaults to the loop's 200 Hz.
+ * --quantum sets the step values are rounded to in a compressed file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "WSVFile.h"
+#include "FrameSource.h"
+#include "MappedSource.h"
+#include "BinaryTrajectory.h"
+#include "CompressedTrajectory.h"
+
+#define DEFAULT_RATE 200.0
+
+/**
+ * Write every frame of a text trajectory and finish the file
+ * @param  file   The text file, with its header set
+ * @param  writer A binary or compressed writer, already opened
+ * @param  out    Path of the file being written
+ * @return        0 on success
+ */
+template < class Writer >
+int writeFrames(WSVFile &file, Writer &writer, const string &out){
+    while (file.loadBuffer()){
+        WSVFile::Buffer& buffer = file.buffer();
+        for (int r = 0; r < buffer.size(); r++){
+            if (!writer.write(&buffer[r][0])){
+                fprintf(stderr, "%s\n", writer.getError().c_str());
+                return 1;
+            }
+        }
+    }
+    if (file.errored()){
+        fprintf(stderr, "%s\n", file.getError().c_str());
+        return 1;
+    }
+
+    uint64_t frames = writer.numFrames();
+    if (!writer.close()){
+        fprintf(stderr, "%s\n", writer.getError().c_str());
+        return 1;
+    }
+    printf("Wrote %llu frames of %d columns to %s\n", (unsigned long long)frames, (int)file.orderedHeader().size(), out.c_str());
+    return 0;
+}
+
+/**
+ * Convert a text trajectory to a binary or compressed one
+ * @param  in        Path of the text file
+ * @param  out       Path of the binary or compressed file
+ * @param  valueSize sizeof(double) or sizeof(float), for a binary file
+ * @param  rate      Frames per second to record in the file
+ * @param  quantum   The step values are rounded to for a compressed file, or 0 for a binary one
+ * @return           0 on success
+ */
+int textToBinary(const string &in, const string &out, int valueSize, double rate, double quantum){
+    WSVFile file(in, true, STREAM_BUFFER_SIZE);
+    if (file.errored()){
+        fprintf(stderr, "%s\n", file.getError().c_str());
+        return 1;
+    }
+
+    // Same rule as when the file is loaded: 40 columns and no header means the default one.
+    if (!file.headerSupplied() && file.numCols() == 40)
+        file.setHeader(DEFAULT_HEADER);
+    if (!file.headerSupplied()){
+        fprintf(stderr, "%s has no header naming its columns.\n", in.c_str());
+        return 1;
+    }
+
+    if (quantum > 0){
+        CompressedTrajectoryWriter writer;
+        if (!writer.open(out, file.orderedHeader(), rate, quantum)){
+            fprintf(stderr, "%s\n", writer.getError().c_str());
+            return 1;
+        }
+        return writeFrames(file, writer, out);
+    }
+
+    BinaryTrajectoryWriter writer;
+    if (!writer.open(out, file.orderedHeader(), valueSize, rate)){
+        fprintf(stderr, "%s\n", writer.getError().c_str());
+        return 1;
+    }
+    return writeFrames(file, writer, out);
+}
+
+/**
+ * Convert a binary trajectory to a text one
+ * @param  in  Path of the binary file
+ * @param  out Path of the text file
+ * @return     0 on success
+ */
+int binaryToText(const string &in, const string &out){
+    MappedSource source(in);
+    if (source.errored()){
+        fprintf(stderr, "%s\n", source.getError().c_str());
+        return 1;
+    }
+
+    FILE* file = fopen(out.c_str(), "w");
+    if (file == NULL){
+        fprintf(stderr, "Unable to open %s for writing.\n", out.c_str());
+        return 1;
+    }
+
+    const FrameSource::Header& header = source.orderedHeader();
+    for (int i = 0; i < header.size(); i++)
+        fprintf(file, "%s%c", header[i].c_str(), WRITE_WHITESPACE);
+    fprintf(file, "\n");
+
+    char value[32];
+    int frames = 0;
+    for (const double* frame = source.current(); frame != NULL; frame = source.advance() ? source.current() : NULL){
+        for (int i = 0; i < header.size(); i++)
+            fprintf(file, "%s%c", WSVFile::format_value(frame[i], value, sizeof(value)), WRITE_WHITESPACE);
+        fprintf(file, "\n");
+        frames++;
+    }
+
+    if (fclose(file) != 0){
+        fprintf(stderr, "Unable to finish %s.\n", out.c_str());
+        return 1;
+    }
+    printf("Wrote %d frames of %d columns to %s\n", frames, (int)header.size(), out.c_str());
+    return 0;
+}
+
+/**
+ * Convert a compressed trajectory to a text one
+ * @param  in  Path of the compressed file
+ * @param  out Path of the text file
+ * @return     0 on success
+ */
+int compressedToText(const string &in, const string &out){
+    CompressedTrajectoryReader reader(in, STREAM_BUFFER_SIZE);
+    if (reader.errored()){
+        fprintf(stderr, "%s\n", reader.getError().c_str());
+        return 1;
+    }
+
+    FILE* file = fopen(out.c_str(), "w");
+    if (file == NULL){
+        fprintf(stderr, "Unable to open %s for writing.\n", out.c_str());
+        return 1;
+    }
+
+    const FrameReader::Header& header = reader.orderedHeader();
+    for (int i = 0; i < header.size(); i++)
+        fprintf(file, "%s%c", header[i].c_str(), WRITE_WHITESPACE);
+    fprintf(file, "\n");
+
+    char value[32];
+    int frames = 0;
+    while (reader.loadBuffer()){
+        FrameReader::Buffer& buffer = reader.buffer();
+        for (int r = 0; r < buffer.size(); r++){
+            for (int i = 0; i < header.size(); i++)
+                fprintf(file, "%s%c", WSVFile::format_value(buffer[r][i], value, sizeof(value)), WRITE_WHITESPACE);
+            fprintf(file, "\n");
+        }
+        frames += buffer.size();
+    }
+
+    bool ok = fclose(file) == 0;
+    if (reader.errored()){
+        fprintf(stderr, "%s\n", reader.getError().c_str());
+        return 1;
+    }
+    if (!ok){
+        fprintf(stderr, "Unable to finish %s.\n", out.c_str());
+        return 1;
+    }
+    printf("Wrote %d frames of %d columns to %s\n", frames, (int)header.size(), out.c_str());
+    return 0;
+}
+
+int main(int argc, char** argv){
+    int valueSize = sizeof(double);
+    double rate = DEFAULT_RATE;
+    double quantum = DEFAULT_QUANTUM;
+    vector< string > paths;
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--float") == 0)
+            valueSize = sizeof(float);
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+            rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--quantum") == 0 && i + 1 < argc)
+            quantum = atof(argv[++i]);
+        else
+            paths.push_back(argv[i]);
+    }
+
+    if (paths.size() != 2){
+        fprintf(stderr, "Usage: %s [--float] [--rate HZ] [--quantum Q] input output\n", argv[0]);
+        fprintf(stderr, "Converts a text trajectory to binary, or to compressed if output ends in %s,\n", COMPRESSED_EXTENSION);
+        fprintf(stderr, "or a binary or compressed one to text.\n");
+        return 2;
+    }
+    if (!(quantum > 0)){
+        fprintf(stderr, "The quantum must be more than 0.\n");
+        return 2;
+    }
+
+    if (isBinaryTrajectory(paths[0]))
+        return binaryToText(paths[0], paths[1]);
+    if (isCompressedTrajectory(paths[0]))
+        return compressedToText(paths[0], paths[1]);
+
+    const string& out = paths[1];
+    bool compressed = out.size() >= strlen(COMPRESSED_EXTENSION)
+        && out.compare(out.size() - strlen(COMPRESSED_EXTENSION), string::npos, COMPRESSED_EXTENSION) == 0;
+    return textToBinary(paths[0], out, valueSize, rate, compressed ? quantum : 0);
+}